@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __cplusplus
+# error "L8Binding.h is a C++ header: generated bindings must be compiled as Objective-C++."
+#endif
+
+// Installed with the public headers of the framework
+#include "v8.h"
+
+/**
+ * @page bindings Generated bindings
+ *
+ * By default, the methods and properties of exported classes are
+ * found using the Objective-C runtime, and every call goes through
+ * a generic callback.
+ *
+ * The l8gen tool reads headers declaring L8Export protocols and
+ * generates an Objective-C++ file with a static callback for every
+ * exported method and property, and an installer per class. The
+ * installers register themselves on load using L8RegisterBinding().
+ * When a class has a registered installer, it is used instead of
+ * runtime reflection.
+ *
+ * An installer is only used when it covers every export protocol the
+ * class adopts at runtime, including protocols adopted in class
+ * extensions or categories the generator did not see. Classes adopting
+ * L8LazyExport are always bound lazily using reflection. Generated
+ * property accessors message the accessor methods, so
+ * L8DirectIvarAccess does not apply to them.
+ *
+ * @code
+ * l8gen -o MyClassBinding.mm MyClass.h
+ * @endcode
+ */
+
+/**
+ * Installs the exported methods and properties of a class.
+ *
+ * Instance methods and properties are installed on the prototype
+ * template and class methods on the class template. Property
+ * accessors use an accessor signature of the class template, and
+ * find the receiver in the holder.
+ *
+ * @param isolate The isolate the templates belong to.
+ * @param classTemplate The template of the class.
+ */
+typedef void (*L8BindingInstaller)(v8::Isolate *isolate, v8::Local<v8::FunctionTemplate> classTemplate);
+
+/**
+ * Registers a generated installer for a class.
+ *
+ * @param cls The class.
+ * @param installer The installer, replacing any previously registered one.
+ * @param protocols NULL-terminated list with the names of the export
+ * protocols adopted by the class whose members the installer installs.
+ */
+void L8RegisterBinding(Class cls, L8BindingInstaller installer, const char *const *protocols);
+
+/**
+ * Get the installer registered for a class.
+ *
+ * @param cls The class.
+ * @return The installer, or NULL if none is registered, the class adopts
+ * an export protocol the installer does not cover, or the class adopts
+ * L8LazyExport.
+ */
+L8BindingInstaller L8BindingInstallerForClass(Class cls);
+
+/**
+ * Get the Objective-C object wrapped by a JavaScript object.
+ *
+ * @param object The JavaScript wrapper, usually This().
+ * @return The wrapped object, or nil.
+ */
+id L8BindingUnwrap(v8::Local<v8::Object> object);
+
+/**
+ * Convert a JavaScript value to an object argument.
+ *
+ * @param isolate The current isolate.
+ * @param expectedClass The class of the argument, or Nil for id.
+ * @param value The value to convert.
+ * @return The converted object.
+ */
+id L8BindingToObject(v8::Isolate *isolate, Class expectedClass, v8::Local<v8::Value> value);
+
+/**
+ * Convert a JavaScript value to a number argument.
+ *
+ * Throws a TypeError into JavaScript when the value is not a number.
+ */
+double L8BindingToNumber(v8::Isolate *isolate, v8::Local<v8::Value> value);
+
+/**
+ * Convert a JavaScript value to an integer argument.
+ *
+ * Throws a TypeError into JavaScript when the value is not a number, and
+ * a RangeError when it does not fit the native type, like it does for
+ * reflected methods.
+ *
+ * @param isolate The current isolate.
+ * @param value The value to convert.
+ * @param encoding The encoding of the native type, from \@encode().
+ * @return The converted value, to be cast to the native type, or 0 if
+ * an exception was thrown.
+ */
+long long L8BindingToInteger(v8::Isolate *isolate, v8::Local<v8::Value> value, const char *encoding);
+
+/**
+ * Convert an object to a JavaScript value.
+ *
+ * An L8Value created with +[L8Value valueWithThrownValue:inContext:]
+ * is thrown instead, like it is for reflected methods.
+ */
+v8::Local<v8::Value> L8BindingFromObject(v8::Isolate *isolate, id object);
+
+/**
+ * Throw a native exception into JavaScript.
+ *
+ * @param isolate The current isolate.
+ * @param exception The caught Objective-C exception.
+ */
+void L8BindingThrow(v8::Isolate *isolate, id exception);
+
+/**
+ * @brief Autorelease scope of a generated callback.
+ *
+ * Manages the autorelease pool of the call like reflected calls do,
+ * following the autoreleasePolicy of the virtual machine, and releases a
+ * batch of objects released by the garbage collector.
+ */
+class L8BindingAutoreleaseScope {
+public:
+	explicit L8BindingAutoreleaseScope(v8::Isolate *isolate);
+	~L8BindingAutoreleaseScope();
+
+private:
+	L8BindingAutoreleaseScope(const L8BindingAutoreleaseScope&);
+	L8BindingAutoreleaseScope& operator=(const L8BindingAutoreleaseScope&);
+
+	/// Storage of the autorelease scope of the framework.
+	void *_storage[2];
+};
+
+/**
+ * @brief Scope of a generated method callback.
+ *
+ * Makes the callback information available to +[L8Context currentThis]
+ * and friends for the lifetime of the scope, like the callback scope of
+ * reflected calls does.
+ */
+class L8BindingCallScope {
+public:
+	explicit L8BindingCallScope(const v8::FunctionCallbackInfo<v8::Value>& info);
+	~L8BindingCallScope();
+
+private:
+	L8BindingCallScope(const L8BindingCallScope&);
+	L8BindingCallScope& operator=(const L8BindingCallScope&);
+
+	/// Storage of the callback scope of the framework.
+	void *_storage[2];
+};
@@ -33,6 +33,12 @@
 /// The virtual machine containing this context.
 @property (nonatomic,readonly) L8VirtualMachine *virtualMachine;
 
+/// Number of times the existing JavaScript wrapper of a native object was reused.
+@property (nonatomic,readonly) NSUInteger wrapperCacheHits;
+
+/// Number of JavaScript wrappers created for native objects.
+@property (nonatomic,readonly) NSUInteger wrapperCacheMisses;
+
 /**
  * Initialize a new context in a new virtual machine.
  *
@@ -93,6 +99,33 @@
  */
 - (L8Value *)evaluateScript:(NSString *)scriptData withName:(NSString *)name;
 
+/**
+ * Evaluate given script in the context, returning an error
+ * instead of reporting it.
+ *
+ * A compilation error or uncaught exception is neither thrown nor passed
+ * to the exception handler of L8Reporter, regardless of L8_TRANSFER_JS_EXCEPTIONS.
+ *
+ * @param scriptData the script contents
+ * @param error On failure, an error in L8ErrorDomain with the L8Exception
+ * under L8ExceptionErrorKey. May be NULL.
+ * @return the scripts return value, or nil on failure
+ */
+- (L8Value *)evaluateScript:(NSString *)scriptData error:(NSError **)error;
+
+/**
+ * Evaluate given script in the context, returning an error
+ * instead of reporting it.
+ *
+ * @see evaluateScript:error:
+ *
+ * @param scriptData the script contents
+ * @param name name used in stacktraces and errors
+ * @param error On failure, an error describing the problem. May be NULL.
+ * @return the scripts return value, or nil on failure
+ */
+- (L8Value *)evaluateScript:(NSString *)scriptData withName:(NSString *)name error:(NSError **)error;
+
 /**
  * Evaluate a script file.
  *
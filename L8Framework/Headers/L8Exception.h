@@ -25,6 +25,21 @@
 
 @class L8StackTrace;
 
+/// Domain of errors returned by the framework.
+extern NSString *const L8ErrorDomain;
+
+/// Key of the L8Exception in the user info of an error in L8ErrorDomain.
+extern NSString *const L8ExceptionErrorKey;
+
+/// Error codes in L8ErrorDomain.
+enum {
+	/// The script could not be compiled.
+	L8ErrorCompilationFailed = 1,
+
+	/// The script threw an exception.
+	L8ErrorExceptionThrown = 2
+};
+
 /**
  * @brief An JavaScript exception
  */
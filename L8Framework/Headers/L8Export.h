@@ -29,6 +29,84 @@
 @protocol L8Export
 @end
 
+/**
+ * @brief Lazy export marker for L8.
+ *
+ * The instance methods of a class conforming to this protocol are installed
+ * on the prototype when they are first accessed, instead of when the class
+ * is first used. This makes first use of classes with many exported methods
+ * cheaper. Properties and class methods are installed as usual.
+ *
+ * @code
+ * @interface MyClass : NSObject <MyClassExports, L8LazyExport>
+ * @endcode
+ *
+ * @note The prototype of the class prototype is an internal resolver
+ * object, whose prototype is the prototype of the superclass.
+ */
+@protocol L8LazyExport
+@end
+
+/**
+ * @brief Background release marker for L8.
+ *
+ * When the garbage collector releases the wrapper of an object, the object
+ * is released later, outside of the collection. Objects conforming to this
+ * protocol are then released on a background dispatch queue, so their dealloc
+ * does not run on the thread of the virtual machine.
+ *
+ * @note Only use this when dealloc of the class and of the objects it owns
+ * may run on any thread.
+ */
+@protocol L8BackgroundRelease
+@end
+
+/**
+ * @brief Direct instance variable access marker for L8.
+ *
+ * Exported properties of a class conforming to this protocol are read
+ * and written through their backing instance variable, instead of by
+ * calling the accessors. Objects are read and written like synthesized
+ * accessors do, so retained, copied and atomic properties keep their
+ * semantics. Weak, unretained and dynamic properties always call the
+ * accessors.
+ *
+ * @code
+ * @interface MyModel : NSObject <MyModelExports, L8DirectIvarAccess>
+ * @endcode
+ *
+ * @note Only adopt this when the class synthesizes the accessors of
+ * its exported properties. The runtime does not tell a hand-written
+ * accessor from a synthesized one, so its side effects, such as
+ * validation or lazy initialization, would be skipped. Receivers whose
+ * accessor differs from that of the class, such as overriding subclasses
+ * and objects observed using key-value observing, call the accessors.
+ * Subclasses do not inherit the marker.
+ */
+@protocol L8DirectIvarAccess
+@end
+
+/**
+ * @brief Native memory held by an exported object.
+ *
+ * The garbage collector only sees the small JavaScript wrapper of an
+ * object. An object holding a lot of native memory, such as an image
+ * buffer, can report its size so the collector collects wrappers sooner.
+ *
+ * The cost is asked once, when the wrapper is created, and subtracted
+ * again when the wrapper is collected.
+ */
+@protocol L8ExternalMemory <NSObject>
+
+/**
+ * Get the number of bytes of native memory kept alive by this object.
+ *
+ * @return The size in bytes.
+ */
+- (size_t)externalMemoryCost;
+
+@end
+
 /**
  * A name-changer for exported methods in L8 exports.
  *
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __cplusplus
+# error "L8Scope.h is a C++ header: code using it must be compiled as Objective-C++."
+#endif
+
+#import <Foundation/Foundation.h>
+
+// Installed with the public headers of the framework
+#include "v8.h"
+
+@class L8Context, L8Value;
+
+/**
+ * @page scopes Stack-scoped values
+ *
+ * Every L8Value is an Objective-C object holding a V8 handle. For work on
+ * many values, such as walking a large array returned by a script, the
+ * C++ classes L8Scope and L8Local avoid creating an object per value.
+ *
+ * An L8Scope enters a context and opens a handle scope. Within it, values
+ * are L8Local, which are copied by value and are only valid until the scope
+ * ends. Values that must outlive the scope are converted to an L8Value.
+ *
+ * @code
+ * L8Scope scope(context);
+ * L8Local points = scope.evaluate(@"makePoints()");
+ *
+ * double sum = 0;
+ * for(uint32_t i = 0; i < points.length(); ++i)
+ *     sum += points.get(i).get("x").toDouble();
+ * @endcode
+ */
+
+/**
+ * @brief A JavaScript value within an L8Scope.
+ *
+ * The value is only valid while the scope that created it is alive.
+ * An empty value is the result of a failed operation, such as a call
+ * that threw an exception.
+ */
+class L8Local {
+public:
+	/// An empty value.
+	inline L8Local()
+	: _isolate(NULL)
+	{
+	}
+
+	/// A value from a V8 handle.
+	inline L8Local(v8::Isolate *isolate, v8::Local<v8::Value> value)
+	: _isolate(isolate),
+	_value(value)
+	{
+	}
+
+	/// The V8 handle of the value.
+	inline v8::Local<v8::Value> V8Value() const
+	{
+		return _value;
+	}
+
+	/// Whether this value is empty.
+	inline bool isEmpty() const
+	{
+		return _value.IsEmpty();
+	}
+
+	inline bool isUndefined() const
+	{
+		return !_value.IsEmpty() && _value->IsUndefined();
+	}
+
+	inline bool isNull() const
+	{
+		return !_value.IsEmpty() && _value->IsNull();
+	}
+
+	inline bool isBoolean() const
+	{
+		return !_value.IsEmpty() && _value->IsBoolean();
+	}
+
+	inline bool isNumber() const
+	{
+		return !_value.IsEmpty() && _value->IsNumber();
+	}
+
+	inline bool isString() const
+	{
+		return !_value.IsEmpty() && _value->IsString();
+	}
+
+	/// Whether the value is an object that is not a function.
+	inline bool isObject() const
+	{
+		return !_value.IsEmpty() && _value->IsObject() && !_value->IsFunction();
+	}
+
+	inline bool isFunction() const
+	{
+		return !_value.IsEmpty() && _value->IsFunction();
+	}
+
+	inline bool isArray() const
+	{
+		return !_value.IsEmpty() && _value->IsArray();
+	}
+
+	inline bool toBool() const
+	{
+		return !_value.IsEmpty() && _value->BooleanValue();
+	}
+
+	inline double toDouble() const
+	{
+		return _value.IsEmpty() ? NAN : _value->NumberValue();
+	}
+
+	inline int32_t toInt32() const
+	{
+		return _value.IsEmpty() ? 0 : _value->Int32Value();
+	}
+
+	inline uint32_t toUInt32() const
+	{
+		return _value.IsEmpty() ? 0 : _value->Uint32Value();
+	}
+
+	/**
+	 * Convert the value to a string.
+	 *
+	 * @return A new string, or nil when the value is empty.
+	 */
+	NSString *toString() const;
+
+	/**
+	 * Get the length of an array.
+	 *
+	 * @return The length, or 0 when the value is not an array.
+	 */
+	inline uint32_t length() const
+	{
+		return isArray() ? _value.As<v8::Array>()->Length() : 0;
+	}
+
+	/**
+	 * Get a property of an object.
+	 *
+	 * @return The property value, or an empty value when this is not an object.
+	 */
+	inline L8Local get(const char *name) const
+	{
+		if(_value.IsEmpty() || !_value->IsObject())
+			return L8Local();
+		return L8Local(_isolate, _value.As<v8::Object>()->Get(v8::String::NewFromUtf8(_isolate, name)));
+	}
+
+	/**
+	 * Get an indexed property of an object.
+	 *
+	 * @return The property value, or an empty value when this is not an object.
+	 */
+	inline L8Local get(uint32_t index) const
+	{
+		if(_value.IsEmpty() || !_value->IsObject())
+			return L8Local();
+		return L8Local(_isolate, _value.As<v8::Object>()->Get(index));
+	}
+
+	/**
+	 * Set a property of an object.
+	 *
+	 * @return Whether the property was set.
+	 */
+	inline bool set(const char *name, const L8Local& value) const
+	{
+		if(_value.IsEmpty() || !_value->IsObject() || value.isEmpty())
+			return false;
+		return _value.As<v8::Object>()->Set(v8::String::NewFromUtf8(_isolate, name), value._value);
+	}
+
+	/**
+	 * Set an indexed property of an object.
+	 *
+	 * @return Whether the property was set.
+	 */
+	inline bool set(uint32_t index, const L8Local& value) const
+	{
+		if(_value.IsEmpty() || !_value->IsObject() || value.isEmpty())
+			return false;
+		return _value.As<v8::Object>()->Set(index, value._value);
+	}
+
+	/**
+	 * Call the value as a function.
+	 *
+	 * An exception thrown by the function is reported like exceptions of
+	 * L8Value calls.
+	 *
+	 * @param receiver The value of this, undefined when empty.
+	 * @param argc The number of arguments.
+	 * @param argv The arguments.
+	 * @return The result, or an empty value when the call threw or this is
+	 * not a function.
+	 */
+	L8Local call(const L8Local& receiver, int argc, const L8Local *argv) const;
+
+	/**
+	 * Call a method of the object.
+	 *
+	 * @see call()
+	 */
+	inline L8Local invoke(const char *method, int argc, const L8Local *argv) const
+	{
+		return get(method).call(*this, argc, argv);
+	}
+
+private:
+	v8::Isolate *_isolate;
+	v8::Local<v8::Value> _value;
+};
+
+/**
+ * @brief Enters a context for working with L8Local values.
+ *
+ * Opens a handle scope and enters the context for the lifetime of the
+ * scope. The values created within the scope are released when it ends.
+ * Create scopes on the stack only.
+ */
+class L8Scope {
+public:
+	explicit L8Scope(L8Context *context);
+	~L8Scope();
+
+	/// The isolate of the context.
+	inline v8::Isolate *isolate() const
+	{
+		return _isolate;
+	}
+
+	/// The context.
+	inline L8Context *context() const
+	{
+		return _context;
+	}
+
+	/// The global object of the context.
+	L8Local global() const;
+
+	/**
+	 * Evaluate a script in the context.
+	 *
+	 * @return The result, or an empty value when the script threw.
+	 */
+	L8Local evaluate(NSString *script) const;
+
+	inline L8Local undefined() const
+	{
+		return L8Local(_isolate, v8::Undefined(_isolate));
+	}
+
+	inline L8Local null() const
+	{
+		return L8Local(_isolate, v8::Null(_isolate));
+	}
+
+	inline L8Local boolean(bool value) const
+	{
+		return L8Local(_isolate, v8::Boolean::New(_isolate, value));
+	}
+
+	inline L8Local number(double value) const
+	{
+		return L8Local(_isolate, v8::Number::New(_isolate, value));
+	}
+
+	inline L8Local string(const char *value) const
+	{
+		return L8Local(_isolate, v8::String::NewFromUtf8(_isolate, value));
+	}
+
+	inline L8Local newObject() const
+	{
+		return L8Local(_isolate, v8::Object::New(_isolate));
+	}
+
+	inline L8Local newArray(int length = 0) const
+	{
+		return L8Local(_isolate, v8::Array::New(_isolate, length));
+	}
+
+	/**
+	 * Get the value of an L8Value in this scope.
+	 */
+	L8Local local(L8Value *value) const;
+
+	/**
+	 * Convert an Objective-C object to a value, like L8Value does.
+	 */
+	L8Local fromObject(id object) const;
+
+	/**
+	 * Create an L8Value, which outlives the scope.
+	 *
+	 * @return The value, or nil when local is empty.
+	 */
+	L8Value *value(const L8Local& local) const;
+
+private:
+	L8Scope(const L8Scope&);
+	L8Scope& operator=(const L8Scope&);
+
+	L8Context *_context;
+	v8::Isolate *_isolate;
+	v8::HandleScope _handleScope;
+	v8::Context::Scope _contextScope;
+};
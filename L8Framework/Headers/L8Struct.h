@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * Representations of a struct in JavaScript.
+ */
+typedef enum L8StructRepresentation {
+	/// An object with a property per field. Nested structs are objects as well.
+	L8StructRepresentationObject,
+
+	/// A Float64Array holding the fields, with nested structs flattened, in declaration order.
+	L8StructRepresentationFloat64Array
+} L8StructRepresentation;
+
+/**
+ * Register the field names and representation of a struct type.
+ *
+ * Structs are passed by value to and from native methods, blocks and
+ * properties. The field names of common Foundation and Core Graphics
+ * structs, such as NSRange, CGPoint, CGSize and CGRect, are built in. Other
+ * structs use the field names of an extended type encoding, which methods
+ * of exported protocols have. Structs without known field names cross as
+ * an array with an element per field.
+ *
+ * Only structs with numeric fields and nested structs can cross the
+ * bridge. A struct must be registered before it first crosses.
+ *
+ * @param name The name of the struct in type encodings, such as "CGPoint" or "_NSRange".
+ * @param fieldNames The names of the fields in declaration order, or nil to
+ * keep the names of the type encoding.
+ * @param representation The representation in JavaScript.
+ */
+void L8RegisterStruct(const char *name, NSArray *fieldNames, L8StructRepresentation representation);
@@ -127,6 +127,37 @@
  */
 + (instancetype)valueWithNewErrorFromMessage:(NSString *)message inContext:(L8Context *)context;
 
+/**
+ * Create a new JavaScript error object from an NSError.
+ *
+ * The error object gets the localized description as message, and
+ * the domain and code of the NSError as properties.
+ *
+ * @param error The error.
+ * @param context The context to create the value in.
+ * @return The new JavaScript error object.
+ */
++ (instancetype)valueWithNewErrorFromError:(NSError *)error inContext:(L8Context *)context;
+
+/**
+ * Create a value that is thrown when it is returned to JavaScript.
+ *
+ * A native method or block declared to return an L8Value can return this
+ * value to throw a JavaScript exception, without raising an Objective-C
+ * exception.
+ *
+ * Methods with a selector ending in error: and a trailing NSError **
+ * argument can instead set the error and return NO, nil or 0, or return
+ * void. The error is then thrown as a JavaScript error object. Scripts
+ * do not pass the error argument. Other trailing pointer arguments, such
+ * as id *, are passed by the script.
+ *
+ * @param value The value to throw, usually an error object.
+ * @param context The context to create the value in.
+ * @return The new value.
+ */
++ (instancetype)valueWithThrownValue:(id)value inContext:(L8Context *)context;
+
 /**
  * Create a new JavaScript value <code>null</code>.
  *
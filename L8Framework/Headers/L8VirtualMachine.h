@@ -23,6 +23,21 @@
  * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
  */
 
+/**
+ * Moments at which the autorelease pools of native calls are drained.
+ */
+typedef enum L8AutoreleasePolicy {
+	/// Every native call has its own pool. This is the default.
+	L8AutoreleasePolicyPerCall,
+
+	/// The pool is drained once every autoreleaseInterval native calls.
+	L8AutoreleasePolicyInterval,
+
+	/// The pool is drained when the top-level evaluateScript: or
+	/// executeBlockInContext: returns.
+	L8AutoreleasePolicyPerEvaluation
+} L8AutoreleasePolicy;
+
 /**
  * @brief JavaScript Virtual Machine.
  *
@@ -30,6 +45,88 @@
  */
 @interface L8VirtualMachine : NSObject
 
+/**
+ * When to drain the autorelease pool of calls into native code.
+ *
+ * Sharing a pool between calls avoids pushing and popping a pool
+ * for every call. Objects autoreleased by native code then live until
+ * the pool is drained. The policy applies to calls made within
+ * evaluateScript: and executeBlockInContext:. Calls made elsewhere, such
+ * as from a JavaScript function called by native code, have their own pool.
+ */
+@property (nonatomic,assign) L8AutoreleasePolicy autoreleasePolicy;
+
+/**
+ * Number of native calls between drains of the pool with
+ * L8AutoreleasePolicyInterval. Defaults to 64.
+ */
+@property (nonatomic,assign) unsigned int autoreleaseInterval;
+
+/**
+ * Growth of the resident memory size in bytes after which the shared
+ * pool is drained early, regardless of the policy. 0 disables the limit.
+ * Defaults to 32 MB.
+ *
+ * The growth is measured from the start of the top-level evaluateScript:,
+ * or from the last drain caused by the limit, and checked once every 256
+ * native calls. Long-running scripts therefore drain the pool even when
+ * the policy does not.
+ *
+ * @note Within executeBlockInContext: the pool is only drained when
+ * the block returns, because the block may hold pools of its own.
+ */
+@property (nonatomic,assign) size_t autoreleaseMemoryLimit;
+
+/**
+ * Number of methods installed on first access for classes
+ * exporting with L8LazyExport, in all contexts.
+ */
+@property (nonatomic,readonly) NSUInteger lazyMembersInstalled;
+
+/**
+ * Number of objects released by the garbage collector that are
+ * waiting to be released.
+ *
+ * The wrapped objects of collected wrappers are not released within
+ * the collection, but in batches of releaseBatchSize at the next call
+ * into native code, at the end of an evaluation, or when calling
+ * drainReleaseQueue:.
+ */
+@property (nonatomic,readonly) NSUInteger releaseQueueDepth;
+
+/**
+ * Total time spent releasing objects from the release queue, in seconds.
+ */
+@property (nonatomic,readonly) NSTimeInterval releaseQueueDrainTime;
+
+/**
+ * Number of V8 global handles held by L8Value, L8ManagedValue and
+ * L8Context objects of this virtual machine.
+ *
+ * Handles of objects deallocated on a thread other than that of the
+ * virtual machine are disposed when the release queue is next drained,
+ * and are counted until then. A count that keeps growing indicates
+ * leaked values.
+ */
+@property (nonatomic,readonly) NSUInteger liveHandles;
+
+/**
+ * Maximum number of objects released from the release queue at once,
+ * outside of drainReleaseQueue:. Defaults to 64.
+ */
+@property (nonatomic,assign) NSUInteger releaseBatchSize;
+
+/**
+ * Bytes of native memory reported to the garbage collector by the
+ * wrappers of objects conforming to L8ExternalMemory.
+ */
+@property (nonatomic,readonly) int64_t externalMemoryReported;
+
+/**
+ * Number of live wrappers of objects reporting native memory.
+ */
+@property (nonatomic,readonly) NSUInteger externalMemoryObjects;
+
 /**
  * Initialize a new virtual machine.
  *
@@ -53,6 +150,19 @@
  */
 - (void)removeManagedReference:(id)object withOwner:(id)owner;
 
+/**
+ * Release objects waiting in the release queue.
+ *
+ * Call this when the application is idle, for example from the run loop.
+ * Does nothing unless the calling thread uses the virtual machine: it must
+ * be entered and, when lockers are used, locked.
+ *
+ * @param maximumCount The maximum number of objects to release, or 0
+ * to release all of them.
+ * @return The number of objects released.
+ */
+- (NSUInteger)drainReleaseQueue:(NSUInteger)maximumCount;
+
 /**
  * Attempt to run the garbage collector.
  *
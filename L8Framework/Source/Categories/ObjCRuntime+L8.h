@@ -81,6 +81,17 @@ void l8_for_each_method_in_class(Class cls,
 void l8_for_each_property_in_protocol(Protocol *protocol,
 									  void (^callback)(objc_property_t property));
 
+/**
+ * Get the function called when invoking a block.
+ *
+ * The function takes the block itself as first argument,
+ * followed by the block arguments.
+ *
+ * @param block The block.
+ * @return The invoke function of the block.
+ */
+void *l8_block_invoke_function(id block);
+
 extern "C" {
 	/**
 	 * Gets an extended type encoding for a method in given protocol.
@@ -108,4 +119,11 @@ extern "C" {
 
 	const char *_Block_signature(void *block)
 		__OSX_AVAILABLE_STARTING(__MAC_10_6, __IPHONE_3_2);
+
+	/**
+	 * The functions used by synthesized accessors of object properties.
+	 */
+	id objc_getProperty(id self, SEL _cmd, ptrdiff_t offset, BOOL atomic);
+	void objc_setProperty(id self, SEL _cmd, ptrdiff_t offset, id newValue,
+						  BOOL atomic, signed char shouldCopy);
 }
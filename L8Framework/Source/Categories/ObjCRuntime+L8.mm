@@ -94,3 +94,17 @@ void l8_for_each_method_in_class(Class cls, void (^callback)(Method method, BOOL
 	free(methods);
 }
 
+/**
+ * Memory layout of a block, as defined in the Block ABI.
+ */
+struct l8_block_layout {
+	void *isa;
+	int flags;
+	int reserved;
+	void *invoke;
+};
+
+void *l8_block_invoke_function(id block)
+{
+	return ((__bridge struct l8_block_layout *)block)->invoke;
+}
@@ -26,6 +26,8 @@
 #import "l8-defs.h"
 #import "L8Value_Private.h"
 #import "L8ArrayBuffer_Private.h"
+#import "L8WrapperMap.h"
+#import "L8ReleaseQueue.h"
 
 #ifdef L8_ENABLE_TYPED_ARRAYS
 
@@ -67,7 +69,8 @@ static void L8ArrayBufferWeakReferenceCallback(const WeakCallbackData<ArrayBuffe
 		_buffer = contents.Data();
 		_length = contents.ByteLength();
 
-		array->SetAlignedPointerInInternalField(0, (__bridge void *)self);
+		array->SetAlignedPointerInInternalField(L8_WRAPPER_FIELD_OBJECT, (__bridge void *)self);
+		array->SetAlignedPointerInInternalField(L8_WRAPPER_FIELD_TYPE, (void *)L8WrapperTypeArrayBuffer);
 
 		// Yes, this indeed causes a retain cycle.
 		// It also causes this object to stay alive.
@@ -92,7 +95,8 @@ static void L8ArrayBufferWeakReferenceCallback(const WeakCallbackData<ArrayBuffe
 		memcpy(_buffer, [data bytes], _length);
 
 		array = ArrayBuffer::New(_isolate, _buffer, _length);
-		array->SetAlignedPointerInInternalField(0, (__bridge void *)self);
+		array->SetAlignedPointerInInternalField(L8_WRAPPER_FIELD_OBJECT, (__bridge void *)self);
+		array->SetAlignedPointerInInternalField(L8_WRAPPER_FIELD_TYPE, (void *)L8WrapperTypeArrayBuffer);
 
 		_selfReference = self;
 
@@ -108,7 +112,7 @@ static void L8ArrayBufferWeakReferenceCallback(const WeakCallbackData<ArrayBuffe
 
 	array = v8value.As<ArrayBuffer>();
 	if(array->IsExternal())
-		return (__bridge L8ArrayBuffer *)array->GetAlignedPointerFromInternalField(0);
+		return (__bridge L8ArrayBuffer *)array->GetAlignedPointerFromInternalField(L8_WRAPPER_FIELD_OBJECT);
 	return [[L8ArrayBuffer alloc] initWithV8Value:v8value inIsolate:isolate];
 }
 
@@ -143,8 +147,11 @@ static void L8ArrayBufferWeakReferenceCallback(const WeakCallbackData<ArrayBuffe
 	ext = data.GetValue();
 	arrayBuffer = (__bridge L8ArrayBuffer *)data.GetParameter();
 
-	arrayBuffer.selfReference = nil;
 	arrayBuffer->_v8value.Reset();
+
+	// The buffer is released outside of the collection
+	L8ReleaseQueue::fromIsolate(data.GetIsolate())->push((__bridge_retained void *)arrayBuffer.selfReference);
+	arrayBuffer.selfReference = nil;
 }
 
 #endif
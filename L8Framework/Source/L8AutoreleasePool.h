@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "v8.h"
+#import "L8VirtualMachine_Private.h"
+#import "L8ReleaseQueue.h"
+
+extern "C" {
+	void *objc_autoreleasePoolPush(void);
+	void objc_autoreleasePoolPop(void *pool);
+}
+
+/**
+ * Number of native calls between two checks of the resident
+ * memory size against the autorelease memory limit.
+ */
+#define L8_AUTORELEASE_MEMORY_CHECK_INTERVAL 256
+
+/**
+ * Default growth of the resident memory size within a boundary
+ * after which the shared pool is drained.
+ */
+#define L8_AUTORELEASE_MEMORY_LIMIT (32 * 1024 * 1024)
+
+/**
+ * Get the resident memory size of the process.
+ *
+ * @return The size in bytes, or 0 when unknown.
+ */
+size_t l8_resident_memory_size(void);
+
+/**
+ * @brief Autorelease state of a virtual machine.
+ *
+ * Stored in the isolate, so native callbacks can find it without
+ * messaging the virtual machine.
+ */
+struct L8AutoreleaseState {
+	L8AutoreleasePolicy policy;
+	unsigned int interval;
+	size_t memoryLimit;
+
+	/// Pool of the active boundary, NULL outside of a boundary.
+	void *pool;
+
+	/// Number of active native calls within the boundary.
+	unsigned int depth;
+
+	/// Number of native calls since the pool was last drained.
+	unsigned int calls;
+
+	/// Number of native calls, never reset: drains do not delay the memory check.
+	unsigned int memoryCheckCalls;
+
+	/// Resident memory size when the boundary was entered or the memory limit last drained the pool.
+	size_t memoryBase;
+
+	/**
+	 * Get the state of an isolate.
+	 */
+	static inline L8AutoreleaseState *fromIsolate(v8::Isolate *isolate)
+	{
+		return (L8AutoreleaseState *)isolate->GetData(L8_ISOLATE_DATA_AUTORELEASE_STATE);
+	}
+
+	/**
+	 * Drain the pool of the boundary when the policy asks for it.
+	 *
+	 * Only called between top-level native calls: no native frame is
+	 * active between the boundary and here, so the boundary pool is
+	 * the innermost pool.
+	 */
+	inline void drainIfNeeded()
+	{
+		bool drain;
+
+		++calls;
+
+		drain = policy == L8AutoreleasePolicyInterval && calls >= interval;
+		if(!drain && memoryLimit > 0 && ++memoryCheckCalls % L8_AUTORELEASE_MEMORY_CHECK_INTERVAL == 0) {
+			size_t size = l8_resident_memory_size();
+
+			// Freed memory is seldom returned to the system: measure growth
+			// from here on, instead of draining on every check
+			if(size > memoryBase + memoryLimit) {
+				memoryBase = size;
+				drain = true;
+			}
+		}
+
+		if(drain) {
+			objc_autoreleasePoolPop(pool);
+			pool = objc_autoreleasePoolPush();
+			calls = 0;
+		}
+	}
+};
+
+/**
+ * @brief Autorelease boundary of a top-level evaluation.
+ *
+ * Created by evaluateScript: and executeBlockInContext:. Unless the policy
+ * is L8AutoreleasePolicyPerCall, native calls made within the boundary
+ * share its pool, which is drained when the boundary ends.
+ *
+ * Nested boundaries, such as a script evaluated by a native method,
+ * get their own pool and restore the outer boundary when destroyed.
+ *
+ * When the boundary ends, a batch of objects released by the garbage
+ * collector is released.
+ */
+class L8AutoreleaseBoundary {
+public:
+	/**
+	 * @param isolate The isolate.
+	 * @param native Whether the boundary runs native code itself, like
+	 * the block of executeBlockInContext:. The pool is then only drained
+	 * at the end of the boundary.
+	 */
+	inline L8AutoreleaseBoundary(v8::Isolate *isolate, bool native)
+	: _state(L8AutoreleaseState::fromIsolate(isolate)),
+	_releaseQueue(L8ReleaseQueue::fromIsolate(isolate))
+	{
+		if(_state->policy == L8AutoreleasePolicyPerCall) {
+			_state = NULL;
+			return;
+		}
+
+		_pool = _state->pool;
+		_depth = _state->depth;
+		_calls = _state->calls;
+		_memoryBase = _state->memoryBase;
+
+		_state->pool = objc_autoreleasePoolPush();
+		_state->depth = native ? 1 : 0;
+		_state->calls = 0;
+
+		// The memory limit is relative to the size at the start of the boundary
+		if(_state->memoryLimit > 0 && !native)
+			_state->memoryBase = l8_resident_memory_size();
+	}
+
+	inline ~L8AutoreleaseBoundary()
+	{
+		if(_state != NULL) {
+			objc_autoreleasePoolPop(_state->pool);
+
+			_state->pool = _pool;
+			_state->depth = _depth;
+			_state->calls = _calls;
+			_state->memoryBase = _memoryBase;
+		}
+
+		_releaseQueue->drainBatchIfNeeded();
+	}
+
+private:
+	L8AutoreleaseState *_state;
+	L8ReleaseQueue *_releaseQueue;
+	void *_pool;
+	unsigned int _depth;
+	unsigned int _calls;
+	size_t _memoryBase;
+};
+
+/**
+ * @brief Autorelease scope of a native call.
+ *
+ * Pushes a pool for the call when the policy is L8AutoreleasePolicyPerCall,
+ * or when the call is not made within a boundary. Otherwise the call uses
+ * the pool of the boundary, which is drained before the call when the
+ * policy or the memory limit asks for it.
+ *
+ * Before the call, a batch of objects released by the garbage collector
+ * is released.
+ */
+class L8AutoreleaseScope {
+public:
+	inline explicit L8AutoreleaseScope(v8::Isolate *isolate)
+	: _state(L8AutoreleaseState::fromIsolate(isolate)),
+	_pool(NULL)
+	{
+		L8ReleaseQueue::fromIsolate(isolate)->drainBatchIfNeeded();
+
+		if(_state->pool == NULL) {
+			_pool = objc_autoreleasePoolPush();
+			return;
+		}
+
+		if(_state->depth == 0)
+			_state->drainIfNeeded();
+		++_state->depth;
+	}
+
+	inline ~L8AutoreleaseScope()
+	{
+		if(_pool != NULL)
+			objc_autoreleasePoolPop(_pool);
+		else
+			--_state->depth;
+	}
+
+private:
+	L8AutoreleaseState *_state;
+	void *_pool;
+};
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "L8Binding.h"
+#import "L8AutoreleasePool.h"
+#import "L8Context_Private.h"
+#import "L8MethodDescriptor.h"
+#import "L8Value_Private.h"
+#import "L8WrapperMap.h"
+#import "ObjCCallback.h"
+#import "ObjCRuntime+L8.h"
+
+#include <map>
+#include <new>
+#include <pthread.h>
+#include <string.h>
+
+using namespace v8;
+
+/**
+ * @brief A registered installer.
+ */
+struct L8RegisteredBinding {
+	L8BindingInstaller installer;
+
+	/// NULL-terminated names of the export protocols covered by the installer.
+	const char *const *protocols;
+};
+
+static std::map<Class, L8RegisteredBinding> l8_binding_installers;
+static pthread_mutex_t l8_binding_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void L8RegisterBinding(Class cls, L8BindingInstaller installer, const char *const *protocols)
+{
+	L8RegisteredBinding binding = { installer, protocols };
+
+	pthread_mutex_lock(&l8_binding_lock);
+	l8_binding_installers[cls] = binding;
+	pthread_mutex_unlock(&l8_binding_lock);
+}
+
+/**
+ * Get whether a binding installs the members of every export protocol
+ * of a class.
+ *
+ * The generator only sees the headers it is given: protocols adopted in
+ * other headers, class extensions or categories would otherwise disappear.
+ */
+static bool l8_binding_covers_class(const L8RegisteredBinding& binding, Class cls)
+{
+	__block bool covered = true;
+
+	l8_for_each_protocol_implementing_protocol(cls, objc_getProtocol("L8Export"), ^(Protocol *protocol) {
+		const char *name = protocol_getName(protocol);
+		const char *const *it;
+
+		for(it = binding.protocols; *it != NULL; ++it) {
+			if(strcmp(*it, name) == 0)
+				return;
+		}
+
+		NSLog(@"Binding of class %@ does not cover protocol %s. Falling back to reflection.",
+			  NSStringFromClass(cls), name);
+		covered = false;
+	});
+
+	return covered;
+}
+
+L8BindingInstaller L8BindingInstallerForClass(Class cls)
+{
+	std::map<Class, L8RegisteredBinding>::iterator it;
+	L8RegisteredBinding binding = { NULL, NULL };
+
+	pthread_mutex_lock(&l8_binding_lock);
+
+	it = l8_binding_installers.find(cls);
+	if(it != l8_binding_installers.end())
+		binding = it->second;
+
+	pthread_mutex_unlock(&l8_binding_lock);
+
+	if(binding.installer == NULL)
+		return NULL;
+
+	// Lazy classes install their methods on first use, which needs reflection
+	if(class_conformsToProtocol(cls, objc_getProtocol("L8LazyExport")))
+		return NULL;
+
+	if(!l8_binding_covers_class(binding, cls))
+		return NULL;
+
+	return binding.installer;
+}
+
+id L8BindingUnwrap(Local<Object> object)
+{
+	return l8_unwrap_objc_object(object->GetIsolate(), object);
+}
+
+id L8BindingToObject(Isolate *isolate, Class expectedClass, Local<Value> value)
+{
+	L8Context *context;
+
+	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
+
+	return objCConvertObjectArgument(isolate, context, expectedClass, value);
+}
+
+double L8BindingToNumber(Isolate *isolate, Local<Value> value)
+{
+	if(!value->IsNumber())
+		isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+
+	return value->NumberValue();
+}
+
+long long L8BindingToInteger(Isolate *isolate, Local<Value> value, const char *encoding)
+{
+	long long result;
+
+	if(!objCConvertInteger(isolate, l8_type_descriptor_from_encoding(encoding), value, &result))
+		return 0;
+
+	return result;
+}
+
+Local<Value> L8BindingFromObject(Isolate *isolate, id object)
+{
+	L8Context *context;
+
+	// A thrown value is an exception without unwinding, see objCConvertReturnValue
+	if([object isKindOfClass:[L8Value class]] && [(L8Value *)object isThrown])
+		return isolate->ThrowException([(L8Value *)object V8Value]);
+
+	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
+
+	return objectToValue(isolate, context, object);
+}
+
+void L8BindingThrow(Isolate *isolate, id exception)
+{
+	L8Context *context;
+
+	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
+
+	handleInvocationException(isolate, context, exception);
+}
+
+static_assert(sizeof(L8AutoreleaseScope) <= sizeof(void *[2]), "L8AutoreleaseScope must fit L8BindingAutoreleaseScope");
+
+L8BindingAutoreleaseScope::L8BindingAutoreleaseScope(Isolate *isolate)
+{
+	new (_storage) L8AutoreleaseScope(isolate);
+}
+
+L8BindingAutoreleaseScope::~L8BindingAutoreleaseScope()
+{
+	((L8AutoreleaseScope *)_storage)->~L8AutoreleaseScope();
+}
+
+static_assert(sizeof(L8CallbackScope) <= sizeof(void *[2]), "L8CallbackScope must fit L8BindingCallScope");
+
+L8BindingCallScope::L8BindingCallScope(const FunctionCallbackInfo<Value>& info)
+{
+	new (_storage) L8CallbackScope(info);
+}
+
+L8BindingCallScope::~L8BindingCallScope()
+{
+	((L8CallbackScope *)_storage)->~L8CallbackScope();
+}
@@ -32,6 +32,9 @@
 #import "L8Reporter_Private.h"
 #import "L8WrapperMap.h"
 #import "L8ManagedValue_Private.h"
+#import "ObjCCallback.h"
+#import "L8AutoreleasePool.h"
+#import "L8ReleaseQueue.h"
 
 #import "NSString+L8.h"
 
@@ -77,6 +80,7 @@ using namespace v8;
 		Local<Context> context = Context::New(isolate);
 		context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_SELF, External::New(isolate,(__bridge void *)self));
 		_v8context.Reset(isolate, context);
+		L8ReleaseQueue::fromIsolate(isolate)->handleCreated();
 
 		// Start the context scope
 		Context::Scope contextScope(context);
@@ -90,11 +94,9 @@ using namespace v8;
 - (void)dealloc
 {
 	Isolate *isolate = _virtualMachine.V8Isolate;
-	HandleScope mainScope(isolate);
-	Local<Context> context = Local<Context>::New(isolate, _v8context);
-	Context::Scope contextScope(context);
 
-	_v8context.ClearAndLeak();
+	// Contexts can be deallocated on any thread
+	L8ReleaseQueue::fromIsolate(isolate)->disposeHandle(isolate, _v8context);
 }
 
 - (void)executeBlockInContext:(void(^)(L8Context *context))block
@@ -102,6 +104,7 @@ using namespace v8;
 	Isolate *isolate = _virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
 	Context::Scope contextScope(Local<Context>::New(isolate,_v8context));
+	L8AutoreleaseBoundary autoreleaseBoundary(isolate, true);
 
 	TryCatch tryCatch;
 
@@ -131,6 +134,7 @@ using namespace v8;
 
 	Isolate *isolate = _virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
+	L8AutoreleaseBoundary autoreleaseBoundary(isolate, false);
 	ScriptOrigin scriptOrigin = ScriptOrigin([name V8StringInIsolate:isolate]);
 
 	Local<Script> script;
@@ -176,11 +180,45 @@ using namespace v8;
 
 - (L8Value *)evaluateScript:(NSString *)scriptData withName:(NSString *)name
 {
+	return [self evaluateScript:scriptData withName:name scriptError:NULL];
+}
+
+- (L8Value *)evaluateScript:(NSString *)scriptData error:(NSError **)error
+{
+	return [self evaluateScript:scriptData withName:@"" error:error];
+}
+
+- (L8Value *)evaluateScript:(NSString *)scriptData withName:(NSString *)name error:(NSError **)error
+{
+	NSError *scriptError;
+	L8Value *result;
+
+	// Autoreleased objects do not outlive the autorelease boundary: keep the error strong
+	result = [self evaluateScript:scriptData withName:name scriptError:&scriptError];
+
+	if(error)
+		*error = scriptError;
+
+	return result;
+}
+
+/**
+ * Evaluate a script, reporting a compilation error or exception
+ * in error. When error is NULL, it is reported to the L8Reporter.
+ */
+- (L8Value *)evaluateScript:(NSString *)scriptData
+				   withName:(NSString *)name
+				scriptError:(NSError * __strong *)error
+{
+	if(error)
+		*error = nil;
+
 	if(scriptData == nil)
 		return nil;
 
 	Isolate *isolate = _virtualMachine.V8Isolate;
 	EscapableHandleScope localScope(isolate);
+	L8AutoreleaseBoundary autoreleaseBoundary(isolate, false);
 	ScriptOrigin scriptOrigin = ScriptOrigin([name V8StringInIsolate:isolate]);
 
 	Local<Script> script;
@@ -189,7 +227,10 @@ using namespace v8;
 
 		script = Script::Compile([scriptData V8StringInIsolate:isolate], &scriptOrigin);
 		if(script.IsEmpty()) {
-			[L8Reporter reportTryCatch:&tryCatch inContext:self];
+			if(error)
+				*error = [L8Reporter errorForTryCatch:&tryCatch code:L8ErrorCompilationFailed inContext:self];
+			else
+				[L8Reporter reportTryCatch:&tryCatch inContext:self];
 			return nil;
 		}
 	}
@@ -199,7 +240,10 @@ using namespace v8;
 		Local<Value> retVal = script->Run();
 
 		if(tryCatch.HasCaught()) {
-			[L8Reporter reportTryCatch:&tryCatch inContext:self];
+			if(error)
+				*error = [L8Reporter errorForTryCatch:&tryCatch code:L8ErrorExceptionThrown inContext:self];
+			else
+				[L8Reporter reportTryCatch:&tryCatch inContext:self];
 			return nil;
 		}
 
@@ -223,75 +267,46 @@ using namespace v8;
 
 + (L8Value *)currentThis
 {
-	Local<Value> thisObject;
-	Local<Context> v8context;
-	L8Context *context;
-
-	v8context = Isolate::GetCurrent()->GetCurrentContext();
-	if(v8context.IsEmpty())
-		return nil;
+	const FunctionCallbackInfo<Value> *info;
+	Isolate *isolate = Isolate::GetCurrent();
 
-	// Retrieve the object from the store
-	thisObject = v8context->GetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_CB_THIS);
-	if(thisObject.IsEmpty() || thisObject->IsNull())
+	info = L8CallbackScope::currentInfo(isolate);
+	if(info == NULL)
 		return nil;
 
-	context = [self contextWithV8Context:v8context];
-
-	assert(thisObject->IsObject());
-
-	return [L8Value valueWithV8Value:thisObject inContext:context];
+	return [L8Value valueWithV8Value:info->This()
+						   inContext:[self contextWithV8Context:isolate->GetCurrentContext()]];
 }
 
 + (L8Value *)currentCallee
 {
-	Local<Value> thisObject;
-	Local<Context> v8context;
-	L8Context *context;
-
-	v8context = Isolate::GetCurrent()->GetCurrentContext();
-	if(v8context.IsEmpty())
-		return nil;
+	const FunctionCallbackInfo<Value> *info;
+	Isolate *isolate = Isolate::GetCurrent();
 
-	// Retrieve the function from the store
-	thisObject = v8context->GetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_CB_CALLEE);
-	if(thisObject.IsEmpty() || thisObject->IsNull())
+	info = L8CallbackScope::currentInfo(isolate);
+	if(info == NULL)
 		return nil;
 
-	context = [self contextWithV8Context:v8context];
-
-	// Callee should be a function
-	assert(thisObject->IsFunction());
-
-	return [L8Value valueWithV8Value:thisObject inContext:context];
+	return [L8Value valueWithV8Value:info->Callee()
+						   inContext:[self contextWithV8Context:isolate->GetCurrentContext()]];
 }
 
 + (NSArray *)currentArguments
 {
-	Local<Value> thisObject;
-	Local<Context> v8context;
-	Local<Array> argArray;
+	const FunctionCallbackInfo<Value> *info;
+	Isolate *isolate = Isolate::GetCurrent();
 	NSMutableArray *arguments;
 	L8Context *context;
 
-	v8context = Isolate::GetCurrent()->GetCurrentContext();
-	if(v8context.IsEmpty())
-		return nil;
-
-	thisObject = v8context->GetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_CB_ARGS);
-	if(thisObject.IsEmpty() || thisObject->IsNull())
+	info = L8CallbackScope::currentInfo(isolate);
+	if(info == NULL)
 		return nil;
 
-	context = [self contextWithV8Context:v8context];
-
-	// Callee should be an array
-	assert(thisObject->IsArray());
+	context = [self contextWithV8Context:isolate->GetCurrentContext()];
+	arguments = [[NSMutableArray alloc] initWithCapacity:info->Length()];
 
-	argArray = Local<Array>::Cast(thisObject);
-	arguments = [[NSMutableArray alloc] init];
-
-	for(unsigned int i = 0; i < argArray->Length(); ++i)
-		arguments[i] = [L8Value valueWithV8Value:argArray->Get(i) inContext:context];
+	for(int i = 0; i < info->Length(); ++i)
+		[arguments addObject:[L8Value valueWithV8Value:(*info)[i] inContext:context]];
 
 	return arguments;
 }
@@ -302,6 +317,16 @@ using namespace v8;
 	return Local<Context>::New(isolate, _v8context);
 }
 
+- (NSUInteger)wrapperCacheHits
+{
+	return _wrapperMap.wrapperCacheHits;
+}
+
+- (NSUInteger)wrapperCacheMisses
+{
+	return _wrapperMap.wrapperCacheMisses;
+}
+
 - (L8Value *)wrapperForObjCObject:(id)object
 {
 	@synchronized(_wrapperMap) {
@@ -30,9 +30,6 @@
 
 #define L8_CONTEXT_EMBEDDER_DATA_SELF 0
 //#define L8_CONTEXT_EMBEDDER_DATA_SELF_2 1 // TODO: This seems wrong
-#define L8_CONTEXT_EMBEDDER_DATA_CB_THIS 2
-#define L8_CONTEXT_EMBEDDER_DATA_CB_CALLEE 3
-#define L8_CONTEXT_EMBEDDER_DATA_CB_ARGS 4
 #define L8_CONTEXT_EMBEDDER_DATA_SKIP_CONSTRUCTING 5
 
 /**
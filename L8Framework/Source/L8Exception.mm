@@ -30,6 +30,9 @@
 
 using namespace v8;
 
+NSString *const L8ErrorDomain = @"L8ErrorDomain";
+NSString *const L8ExceptionErrorKey = @"L8Exception";
+
 @implementation L8Exception {
 	L8StackTrace *_backtrace;
 	Isolate *_v8isolate;
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef L8_USE_LIBFFI
+
+struct L8MethodDescriptor;
+
+/**
+ * Maximum number of native arguments (including self and _cmd)
+ * a method can have to be called using libffi.
+ */
+#define L8_FFI_MAX_ARGUMENTS 16
+
+extern "C" {
+	/**
+	 * Whether libffi is used. Defaults to true.
+	 *
+	 * Only meant for comparing the call engines in benchmarks: when false,
+	 * every call uses NSInvocation.
+	 */
+	extern bool l8_ffi_enabled;
+}
+
+/**
+ * Prepare the libffi call interface of a method descriptor.
+ *
+ * The interface is prepared only once, on the first call. Later
+ * calls return the cached result. Safe to call from multiple threads:
+ * block descriptors are shared by all virtual machines.
+ *
+ * @param descriptor The method descriptor.
+ * @return true when the method can be called using libffi, false when
+ * a type is not supported and NSInvocation must be used instead.
+ */
+bool l8_ffi_prepare(L8MethodDescriptor *descriptor);
+
+/**
+ * Call a function using the prepared call interface of a descriptor.
+ *
+ * @param descriptor The prepared method descriptor.
+ * @param function The IMP or block invoke function to call.
+ * @param argumentValues Pointers to the argument values, including
+ * the receiver (and _cmd for methods).
+ * @param returnValue Buffer for the return value. It must be at least
+ * the size of a register (ffi_arg).
+ */
+void l8_ffi_call(const L8MethodDescriptor *descriptor,
+				 void *function,
+				 void **argumentValues,
+				 void *returnValue);
+
+#endif
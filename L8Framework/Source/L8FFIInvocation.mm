@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "L8FFIInvocation.h"
+#import "L8MethodDescriptor.h"
+
+#ifdef L8_USE_LIBFFI
+
+bool l8_ffi_enabled = true;
+
+/**
+ * Get the libffi type for given type encoding.
+ *
+ * @param type The type descriptor.
+ * @return The ffi type, or NULL when not supported.
+ */
+static ffi_type *l8_ffi_type_for_type(const L8TypeDescriptor& type)
+{
+	switch(type.type) {
+		case 'c': return &ffi_type_sint8;
+		case 's': return &ffi_type_sint16;
+		case 'i': return &ffi_type_sint32;
+		case 'l': return &ffi_type_sint32;
+		case 'q': return &ffi_type_sint64;
+		case 'C': return &ffi_type_uint8;
+		case 'S': return &ffi_type_uint16;
+		case 'I': return &ffi_type_uint32;
+		case 'L': return &ffi_type_uint32;
+		case 'Q': return &ffi_type_uint64;
+		case 'f': return &ffi_type_float;
+		case 'd': return &ffi_type_double;
+		case 'B': return &ffi_type_uint8;
+		case 'v': return &ffi_type_void;
+		case '*': // char *
+		case '@': // object
+		case '#': // Class
+		case ':': // SEL
+		case '^': // pointer
+			return &ffi_type_pointer;
+		default: // structs, unions, arrays, bitfields
+			return NULL;
+	}
+}
+
+/**
+ * Build the call interface of a descriptor.
+ *
+ * @return The interface, or NULL when a type is not supported.
+ */
+static ffi_cif *l8_ffi_create_cif(const L8MethodDescriptor *descriptor)
+{
+	ffi_cif *cif;
+	ffi_type **argumentTypes;
+	ffi_type *returnType;
+	size_t count;
+
+	count = descriptor->arguments.size();
+	if(count > L8_FFI_MAX_ARGUMENTS)
+		return NULL;
+
+	returnType = l8_ffi_type_for_type(descriptor->returnType);
+	if(returnType == NULL)
+		return NULL;
+
+	// One block for the interface and its argument types
+	cif = (ffi_cif *)malloc(sizeof(ffi_cif) + count * sizeof(ffi_type *));
+	argumentTypes = (ffi_type **)(cif + 1);
+
+	for(size_t i = 0; i < count; ++i) {
+		argumentTypes[i] = l8_ffi_type_for_type(descriptor->arguments[i]);
+
+		if(argumentTypes[i] == NULL) {
+			free(cif);
+			return NULL;
+		}
+	}
+
+	if(ffi_prep_cif(cif, FFI_DEFAULT_ABI, (unsigned int)count,
+					returnType, argumentTypes) != FFI_OK) {
+		free(cif);
+		return NULL;
+	}
+
+	return cif;
+}
+
+bool l8_ffi_prepare(L8MethodDescriptor *descriptor)
+{
+	ffi_cif *cif;
+
+	if(L8_UNLIKELY(!l8_ffi_enabled))
+		return false;
+
+	// A published interface is always complete. A stale NULL only means NSInvocation is used
+	if(L8_LIKELY(descriptor->cif != NULL))
+		return true;
+	if(descriptor->cifPrepared)
+		return false;
+
+	// Block descriptors are shared by threads: the first complete interface is published
+	cif = l8_ffi_create_cif(descriptor);
+	if(cif != NULL) {
+		__sync_synchronize();
+
+		if(!__sync_bool_compare_and_swap(&descriptor->cif, (ffi_cif *)NULL, cif))
+			free(cif);
+	}
+
+	__sync_synchronize();
+	descriptor->cifPrepared = true;
+
+	return descriptor->cif != NULL;
+}
+
+void l8_ffi_call(const L8MethodDescriptor *descriptor,
+				 void *function,
+				 void **argumentValues,
+				 void *returnValue)
+{
+	assert(descriptor->cif != NULL && "Call interface is not prepared");
+
+	ffi_call(descriptor->cif, FFI_FN(function), returnValue, argumentValues);
+}
+
+#endif
@@ -27,6 +27,7 @@
 #import "L8Value_Private.h"
 #import "L8Context_Private.h"
 #import "L8VirtualMachine_Private.h"
+#import "L8ReleaseQueue.h"
 
 #include "v8.h"
 
@@ -78,6 +79,7 @@ static void L8ManagedValueWeakReferenceCallback(const WeakCallbackData<Value, vo
 												capacity:1];
 
 		_persist.Reset(_context.virtualMachine.V8Isolate, value.V8Value);
+		L8ReleaseQueue::fromIsolate(_context.virtualMachine.V8Isolate)->handleCreated();
 		void *p = (__bridge void *)self;
 		_persist.SetWeak(p, L8ManagedValueWeakReferenceCallback);
 	}
@@ -143,7 +145,13 @@ static void L8ManagedValueWeakReferenceCallback(const WeakCallbackData<Value, vo
 
 - (void)removeValue
 {
-	_persist.ClearAndLeak();
+	Isolate *isolate;
+
+	if(_persist.IsEmpty())
+		return;
+
+	isolate = _context.virtualMachine.V8Isolate;
+	L8ReleaseQueue::fromIsolate(isolate)->disposeHandle(isolate, _persist);
 }
 
 @end
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#include <objc/runtime.h>
+#include <vector>
+
+#ifdef L8_USE_LIBFFI
+# include <ffi/ffi.h>
+#endif
+
+struct L8StructLayout;
+
+/**
+ * @brief Parsed information about a single argument or return value.
+ */
+struct L8TypeDescriptor {
+	/// Type encoding character, with any qualifiers (const, in, out...) removed.
+	char type;
+
+	/// Class named in an extended object encoding (@"NSString"), or Nil.
+	Class objectClass;
+
+	/// Layout of a struct type, or NULL when not a struct or not convertible.
+	const L8StructLayout *structLayout;
+
+	/// Type encoding character of the pointee of a pointer type (^d), or 0.
+	char pointee;
+};
+
+/**
+ * @brief Precompiled call information for an exported method.
+ *
+ * A descriptor is built once when a method is installed in a
+ * template, and is handed to the callbacks as a v8::External. This
+ * way a call does no string parsing, allocation or selector registration.
+ */
+struct L8MethodDescriptor {
+	/**
+	 * Create a descriptor for given selector and (extended) type encoding.
+	 *
+	 * @param selector The selector of the method.
+	 * @param types The type encoding of the method.
+	 * @param isClassMethod Whether the method is a class method.
+	 */
+	L8MethodDescriptor(SEL selector, const char *types, bool isClassMethod);
+
+	/**
+	 * Create a descriptor for an existing method signature.
+	 *
+	 * @param selector The selector of the method, or NULL for blocks.
+	 * @param signature The method signature.
+	 */
+	L8MethodDescriptor(SEL selector, NSMethodSignature *signature);
+
+	~L8MethodDescriptor();
+
+	/// The selector, registered once.
+	SEL selector;
+
+	/// The cached method signature.
+	NSMethodSignature *signature;
+
+	/// The return type.
+	L8TypeDescriptor returnType;
+
+	/// The argument types, including the receiver and _cmd.
+	std::vector<L8TypeDescriptor> arguments;
+
+	/// Whether the method is a class method.
+	bool isClassMethod;
+
+	/// Index of a trailing NSError ** argument of a selector ending in error:, or 0 when there is none.
+	size_t errorArgumentIndex;
+
+	/// For class methods the receiving class, for initializers the class to allocate. Nil otherwise.
+	Class boundClass;
+
+	/// Class of the last receiver, see implementationForReceiver().
+	Class cachedClass;
+
+	/// Implementation of the selector in cachedClass.
+	IMP cachedImplementation;
+
+	/**
+	 * Get the implementation of the method for given receiver.
+	 *
+	 * The implementation for the class of the last receiver is cached,
+	 * so repeated calls on objects of one class need no method lookup.
+	 *
+	 * @param receiver The receiver of the call. Must not be nil.
+	 * @return The implementation of the method.
+	 */
+	inline IMP implementationForReceiver(id receiver)
+	{
+		Class cls = object_getClass(receiver);
+
+		if(L8_UNLIKELY(cls != cachedClass)) {
+			cachedImplementation = class_getMethodImplementation(cls, selector);
+			cachedClass = cls;
+		}
+
+		return cachedImplementation;
+	}
+
+	/**
+	 * Get the end of the arguments that are converted from JavaScript
+	 * arguments. A trailing NSError ** argument is not.
+	 */
+	inline size_t argumentsEnd() const
+	{
+		return errorArgumentIndex ? errorArgumentIndex : arguments.size();
+	}
+
+#ifdef L8_USE_LIBFFI
+	/// The libffi call interface, or NULL when not (yet) prepared. See l8_ffi_prepare().
+	ffi_cif *volatile cif;
+
+	/// Whether preparing the call interface has been attempted. Set after cif.
+	volatile bool cifPrepared;
+#endif
+
+private:
+	L8MethodDescriptor(const L8MethodDescriptor&);
+	L8MethodDescriptor& operator=(const L8MethodDescriptor&);
+
+	void parseSignature();
+};
+
+/**
+ * @brief Precompiled accessor information for an exported property.
+ */
+struct L8PropertyDescriptor {
+	/// The type of the property value.
+	L8TypeDescriptor type;
+
+	/// The getter method.
+	L8MethodDescriptor *getter;
+
+	/// The setter method, or NULL when the property is readonly.
+	L8MethodDescriptor *setter;
+
+	/**
+	 * Whether the backing instance variable can be accessed directly,
+	 * instead of calling the accessors. See l8_setup_direct_ivar_access().
+	 */
+	bool directAccess;
+
+	/// Offset of the backing instance variable.
+	ptrdiff_t ivarOffset;
+
+	/// Size of the backing instance variable.
+	size_t ivarSize;
+
+	/// Whether the synthesized accessors are atomic.
+	bool atomic;
+
+	/// Whether the synthesized setter copies the new value.
+	bool copy;
+
+	/// Synthesized getter implementation. Receivers with another implementation call the getter.
+	IMP getterImplementation;
+
+	/// Synthesized setter implementation. Receivers with another implementation call the setter.
+	IMP setterImplementation;
+};
+
+/**
+ * Parse a single (extended) type encoding.
+ *
+ * @param encoding The type encoding, such as <code>r*</code> or <code>@"NSString"</code>.
+ * @return The parsed type descriptor.
+ */
+L8TypeDescriptor l8_type_descriptor_from_encoding(const char *encoding);
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "L8MethodDescriptor.h"
+#import "L8StructLayout.h"
+
+#include <string.h>
+
+L8TypeDescriptor l8_type_descriptor_from_encoding(const char *encoding)
+{
+	L8TypeDescriptor descriptor = { 0, Nil, NULL, 0 };
+
+	if(encoding == NULL)
+		return descriptor;
+
+	// Skip the qualifiers: const, in, inout, out, bycopy, byref, oneway
+	while(*encoding && strchr("rnNoORV", *encoding))
+		++encoding;
+
+	descriptor.type = *encoding;
+
+	// Struct: {name=types}
+	if(*encoding == '{')
+		descriptor.structLayout = l8_struct_layout_for_encoding(encoding);
+
+	// Pointer: ^type, with the qualifiers of the pointee skipped (^rd)
+	if(*encoding == '^') {
+		const char *pointee = encoding + 1;
+
+		while(*pointee && strchr("rnNoORV", *pointee))
+			++pointee;
+		descriptor.pointee = *pointee;
+	}
+
+	// Extended object encoding: @"ClassName"
+	if(*encoding == '@' && *(encoding+1) == '"') {
+		const char *start, *end;
+
+		start = encoding + 2;
+		end = strchr(start, '"');
+
+		if(end) {
+			char *className = strndup(start, end - start);
+			descriptor.objectClass = objc_getClass(className);
+			free(className);
+		}
+	}
+
+	return descriptor;
+}
+
+L8MethodDescriptor::L8MethodDescriptor(SEL selector, const char *types, bool isClassMethod)
+: selector(selector), isClassMethod(isClassMethod)
+{
+	signature = [NSMethodSignature signatureWithObjCTypes:types];
+	parseSignature();
+}
+
+L8MethodDescriptor::L8MethodDescriptor(SEL selector, NSMethodSignature *signature)
+: selector(selector), signature(signature), isClassMethod(false)
+{
+	parseSignature();
+}
+
+L8MethodDescriptor::~L8MethodDescriptor()
+{
+#ifdef L8_USE_LIBFFI
+	// The argument types are allocated in the same block
+	free(cif);
+#endif
+}
+
+/**
+ * Checks whether a selector ends in error:, like -save:error:.
+ */
+static bool l8_selector_has_error_argument(SEL selector)
+{
+	const char *name = sel_getName(selector);
+	size_t length = strlen(name);
+
+	return length >= 6 && strcmp(name + length - 6, "error:") == 0;
+}
+
+void L8MethodDescriptor::parseSignature()
+{
+	NSUInteger count;
+
+	boundClass = Nil;
+	cachedClass = Nil;
+	cachedImplementation = NULL;
+
+#ifdef L8_USE_LIBFFI
+	cif = NULL;
+	cifPrepared = false;
+#endif
+
+	returnType = l8_type_descriptor_from_encoding(signature.methodReturnType);
+
+	count = signature.numberOfArguments;
+	arguments.reserve(count);
+
+	for(NSUInteger i = 0; i < count; ++i)
+		arguments.push_back(l8_type_descriptor_from_encoding([signature getArgumentTypeAtIndex:i]));
+
+	// A trailing NSError ** returns the error of a failed call. Only the
+	// Cocoa convention opts in: the selector ends in error:, so that other
+	// out-arguments such as id * are still passed by the script
+	errorArgumentIndex = 0;
+	if(selector && count > 2 && l8_selector_has_error_argument(selector)) {
+		const char *encoding;
+
+		encoding = [signature getArgumentTypeAtIndex:count - 1];
+		encoding += strspn(encoding, "rnNoORV");
+
+		if(strcmp(encoding, "^@") == 0)
+			errorArgumentIndex = count - 1;
+	}
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#include <objc/runtime.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief An exported method of a protocol.
+ */
+struct L8ExportedMethod {
+	/// The selector.
+	SEL selector;
+
+	/// The extended type encoding, owned by the runtime.
+	const char *types;
+
+	/// The JavaScript name, after renaming with L8_EXPORT_AS.
+	std::string name;
+};
+
+/**
+ * @brief An exported property of a protocol.
+ */
+struct L8ExportedProperty {
+	/// The name of the property.
+	std::string name;
+
+	/// The type encoding of the property.
+	std::string type;
+
+	/// The getter.
+	SEL getter;
+
+	/// Type encoding of the getter: from the protocol when listed, or built from the property type.
+	std::string getterTypes;
+
+	/// The setter, or NULL when the property is readonly.
+	SEL setter;
+
+	/// Type encoding of the setter.
+	std::string setterTypes;
+};
+
+/**
+ * @brief Everything L8 exports from a protocol, parsed once.
+ *
+ * Protocol metadata does not change after loading, so a description
+ * is created once per process and shared by all virtual machines.
+ */
+struct L8ProtocolDescription {
+	/// Instance methods, except initializers and property accessors.
+	std::vector<L8ExportedMethod> instanceMethods;
+
+	/// Class methods.
+	std::vector<L8ExportedMethod> classMethods;
+
+	/// Properties.
+	std::vector<L8ExportedProperty> properties;
+
+	/// Initializers, which are not exported as methods.
+	std::vector<SEL> initializers;
+};
+
+/**
+ * @brief The export protocols of a class, parsed once.
+ */
+struct L8ClassDescription {
+	/// Descriptions of the protocols of the class implementing L8Export.
+	std::vector<const L8ProtocolDescription *> protocols;
+
+	/// The initializer used to construct instances from JavaScript.
+	SEL initializer;
+};
+
+/**
+ * Get the description of an export protocol.
+ *
+ * Thread safe. The description lives as long as the process.
+ *
+ * @param protocol The protocol.
+ * @return The description.
+ */
+const L8ProtocolDescription *l8_protocol_description(Protocol *protocol);
+
+/**
+ * Get the export description of a class.
+ *
+ * Thread safe. The description lives as long as the process.
+ *
+ * @param cls The class.
+ * @return The description.
+ */
+const L8ClassDescription *l8_class_description(Class cls);
@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "L8ProtocolDescription.h"
+#import "ObjCRuntime+L8.h"
+
+#include <map>
+#include <set>
+#include <pthread.h>
+
+static std::map<Protocol *, L8ProtocolDescription *> g_l8_protocol_descriptions;
+static std::map<Class, L8ClassDescription *> g_l8_class_descriptions;
+static pthread_mutex_t g_l8_description_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Extract a propertyname from a selectorname.
+ *
+ * Removes ':' and makes every letter following such colon uppercase. For example,
+ * 'initWithName:surname:' becomes 'initWithNameSurname'. Return value is stored in
+ * an NSString due to the locally allocated buffer.
+ *
+ * @return An NSString containing the property name
+ */
+static NSString *l8_selector_to_property_name(const char *start, bool instanceMethod = true)
+{
+	const char *firstColon, *input;
+	char *buffer, *output;
+	size_t header;
+	NSString *result;
+
+	// Find the first semicolon
+	firstColon = index(start, ':');
+	if(!firstColon)
+		return [NSString stringWithUTF8String:start];
+
+	header = firstColon - start;
+	buffer = (char *)malloc(header + strlen(firstColon + 1) + 1);
+	memcpy(buffer, start, header);
+
+	output = buffer + header;
+	input = start + header + 1;
+
+	while(true) {
+		char c;
+
+		while((c = *(input++)) == ':');
+
+		if(!(*(output++) = toupper(c)))
+			goto done;
+
+		while((c = *(input++)) != ':') {
+			if(!(*(output++) = c))
+				goto done;
+		}
+	}
+
+done:
+	result = [NSString stringWithUTF8String:buffer];
+	free(buffer);
+
+	return result;
+}
+
+static NSMutableDictionary *l8_create_rename_map(Protocol *protocol, BOOL isInstanceMethod)
+{
+	NSMutableDictionary *renameMap;
+
+	renameMap = [NSMutableDictionary dictionary];
+
+	l8_for_each_method_in_protocol(protocol, NO, isInstanceMethod, ^(SEL sel, const char *types)
+	{
+		const char *selName;
+		NSString *rename, *selector, *name;
+		NSUInteger begin, length;
+		NSRange range;
+		BOOL hasNoArguments = NO;
+
+		selName = sel_getName(sel);
+		rename = @(selName);
+		range = [rename rangeOfString:@"__L8_EXPORT_AS__"];
+		if(range.location == NSNotFound)
+			return;
+
+		if(selName[strlen(selName)-1] != ':')
+			hasNoArguments = YES;
+
+		selector = [rename substringToIndex:range.location];
+		begin = range.location + range.length;
+		length = [rename length] - begin - (hasNoArguments?0:1);
+		name = [rename substringWithRange:(NSRange){ begin, length }];
+		renameMap[selector] = name;
+	});
+
+	return renameMap;
+}
+
+/*
+ * Create the default setter name using only the property name.
+ * A setter name is built with: 'set'<name with first letter capital>':'
+ */
+static char *l8_make_setter_name(const char *name)
+{
+	size_t length = strlen(name);
+	char *setterName = (char *)malloc(length + 5); // 'set' Name ':' 0
+
+	setterName[0] = 's';
+	setterName[1] = 'e';
+	setterName[2] = 't';
+	setterName[3] = toupper(*name);
+
+	memcpy(setterName + 4, name + 1, length - 1);
+
+	setterName[length + 3] = ':';
+	setterName[length + 4] = 0;
+
+	return setterName;
+}
+
+static bool l8_is_method_initializer(SEL sel)
+{
+	char *selStr;
+
+	selStr = (char *)sel_getName(sel);
+
+	while(*selStr == '_')
+		++selStr;
+
+	if(*selStr == '\0')
+		return false;
+
+	if(strncmp(selStr, "init", 4) != 0)
+		return false;
+	selStr += 4;
+
+	if(*selStr == '\0' || isupper(*selStr) || *selStr == ':')
+		return true;
+
+	return false;
+}
+
+/**
+ * Get whether the given method should not be copied
+ * to the JavaScript object.
+ */
+static bool l8_should_skip_method_when_copying(SEL sel)
+{
+	return l8_is_method_initializer(sel);
+}
+
+/*
+ * Find useful attributes in the ObjC context about given property.
+ */
+static void l8_parse_property_attributes(objc_property_t property,
+								  char *&getterName,
+								  char *&setterName,
+								  bool &readonly,
+								  char *&type)
+{
+	unsigned int count;
+	objc_property_attribute_t *attributes = property_copyAttributeList(property, &count);
+	readonly = false;
+
+	for(unsigned int i = 0; i < count; ++i) {
+		switch(*(attributes[i].name)) {
+			case 'R': // read-only (readonly)
+				readonly = true;
+				break;
+			case 'G': // G<name> custom getter name (eg GcustomGetter)
+				getterName = strdup(attributes[i].value);
+				break;
+			case 'S': // S<name> custom setter name (eg ScustomSetter:)
+				setterName = strdup(attributes[i].value);
+				break;
+			case 'T': // T<encoding>, type
+				type = strdup(attributes[i].value);
+				break;
+			case 'C': // copy of last value assigned (copy)
+			case '&': // reference to last value assigned (retain)
+			case 'N': // non-atomic (nonatomic)
+			case 'D': // dynamic (@dynamic)
+			case 'W': // weak reference (__weak / weak)
+			case 'P': // eligible for garbage collection
+			case 't': // t<encoding>, old style encoding
+				break;
+			default:
+				break;
+		}
+	}
+
+	free(attributes);
+}
+
+/**
+ * Parse the export description of a protocol.
+ *
+ * Because the list of methods of a protocol also contains the getters (and setters)
+ * of its properties, the properties are parsed first. Their accessors are then
+ * left out of the methods.
+ */
+static L8ProtocolDescription *l8_parse_protocol_description(Protocol *protocol)
+{
+	struct property_t {
+		const char *name;
+		char *getterName;
+		char *setterName;
+		char *type;
+		bool readonly;
+	};
+	L8ProtocolDescription *description = new L8ProtocolDescription();
+	std::vector<property_t> propertyList;
+	std::map<std::string,const char *> accessorTypes;
+	std::map<std::string,const char *> *accessors = &accessorTypes;
+	std::vector<property_t> *properties = &propertyList;
+	NSMutableDictionary *instanceRenames, *classRenames;
+
+	instanceRenames = l8_create_rename_map(protocol, YES);
+	classRenames = l8_create_rename_map(protocol, NO);
+
+	l8_for_each_property_in_protocol(protocol, ^(objc_property_t property) {
+		property_t prop = { property_getName(property), NULL, NULL, NULL, false };
+
+		l8_parse_property_attributes(property, prop.getterName, prop.setterName, prop.readonly, prop.type);
+
+		if(prop.getterName == NULL)
+			prop.getterName = strdup(prop.name);
+		(*accessors)[prop.getterName] = NULL;
+
+		if(!prop.readonly) {
+			if(prop.setterName == NULL)
+				prop.setterName = l8_make_setter_name(prop.name);
+			(*accessors)[prop.setterName] = NULL;
+		}
+
+		properties->push_back(prop);
+	});
+
+	l8_for_each_method_in_protocol(protocol, YES, YES, ^(SEL sel, const char *types) {
+		const char *selName = sel_getName(sel);
+		const char *extraTypes;
+		std::map<std::string,const char *>::iterator accessor;
+		NSString *name;
+
+		if(l8_is_method_initializer(sel)) {
+			description->initializers.push_back(sel);
+			return;
+		}
+
+		extraTypes = _protocol_getMethodTypeEncoding(protocol, sel, YES, YES);
+
+		accessor = accessors->find(selName);
+		if(accessor != accessors->end()) {
+			accessor->second = extraTypes;
+			return;
+		}
+
+		name = instanceRenames[@(selName)];
+		if(name == nil)
+			name = l8_selector_to_property_name(selName, true);
+
+		L8ExportedMethod method = { sel, extraTypes, [name UTF8String] };
+		description->instanceMethods.push_back(method);
+	});
+
+	l8_for_each_method_in_protocol(protocol, YES, NO, ^(SEL sel, const char *types) {
+		const char *selName = sel_getName(sel);
+		NSString *name;
+
+		if(l8_should_skip_method_when_copying(sel))
+			return;
+
+		name = classRenames[@(selName)];
+		if(name == nil)
+			name = l8_selector_to_property_name(selName, false);
+
+		L8ExportedMethod method = { sel, _protocol_getMethodTypeEncoding(protocol, sel, YES, NO), [name UTF8String] };
+		description->classMethods.push_back(method);
+	});
+
+	// Accessors not listed by the protocol get a type encoding built from the property type
+	for(size_t i = 0; i < propertyList.size(); ++i) {
+		property_t& prop = propertyList[i];
+		L8ExportedProperty exported;
+		const char *listedTypes;
+
+		exported.name = prop.name;
+		exported.type = prop.type;
+
+		exported.getter = sel_registerName(prop.getterName);
+		listedTypes = accessorTypes[prop.getterName];
+		exported.getterTypes = listedTypes ? listedTypes : exported.type + "@:";
+
+		exported.setter = NULL;
+		if(!prop.readonly) {
+			exported.setter = sel_registerName(prop.setterName);
+			listedTypes = accessorTypes[prop.setterName];
+			exported.setterTypes = listedTypes ? listedTypes : "v@:" + exported.type;
+		}
+
+		description->properties.push_back(exported);
+
+		free(prop.type);
+		free(prop.getterName);
+		free(prop.setterName);
+	}
+
+	return description;
+}
+
+/**
+ * Parse the export description of a class.
+ *
+ * When the protocols declare exactly one initializer, that is used.
+ * Otherwise -[init] is.
+ */
+static L8ClassDescription *l8_parse_class_description(Class cls)
+{
+	L8ClassDescription *description = new L8ClassDescription();
+	SEL selector = NULL;
+	BOOL foundMultiple = NO;
+
+	l8_for_each_protocol_implementing_protocol(cls, objc_getProtocol("L8Export"), ^(Protocol *protocol) {
+		description->protocols.push_back(l8_protocol_description(protocol));
+	});
+
+	for(size_t i = 0; i < description->protocols.size(); ++i) {
+		const std::vector<SEL>& initializers = description->protocols[i]->initializers;
+
+		for(size_t j = 0; j < initializers.size(); ++j) {
+			if(selector != NULL && sel_isEqual(initializers[j], selector))
+				continue;
+
+			if(selector != NULL) {
+				NSLog(@"Found multiple init methods for class %@. Falling back to -[init].",NSStringFromClass(cls));
+				foundMultiple = YES;
+				continue;
+			}
+
+			selector = initializers[j];
+		}
+	}
+
+	if(selector == NULL || foundMultiple)
+		selector = @selector(init);
+	description->initializer = selector;
+
+	return description;
+}
+
+const L8ProtocolDescription *l8_protocol_description(Protocol *protocol)
+{
+	std::map<Protocol *, L8ProtocolDescription *>::iterator it;
+	L8ProtocolDescription *description;
+
+	pthread_mutex_lock(&g_l8_description_lock);
+	it = g_l8_protocol_descriptions.find(protocol);
+	description = it != g_l8_protocol_descriptions.end() ? it->second : NULL;
+	pthread_mutex_unlock(&g_l8_description_lock);
+
+	if(description)
+		return description;
+
+	// Parsed outside the lock: parsing a class description takes it again
+	description = l8_parse_protocol_description(protocol);
+
+	pthread_mutex_lock(&g_l8_description_lock);
+	it = g_l8_protocol_descriptions.find(protocol);
+	if(it != g_l8_protocol_descriptions.end()) {
+		delete description;
+		description = it->second;
+	} else
+		g_l8_protocol_descriptions[protocol] = description;
+	pthread_mutex_unlock(&g_l8_description_lock);
+
+	return description;
+}
+
+const L8ClassDescription *l8_class_description(Class cls)
+{
+	std::map<Class, L8ClassDescription *>::iterator it;
+	L8ClassDescription *description;
+
+	pthread_mutex_lock(&g_l8_description_lock);
+	it = g_l8_class_descriptions.find(cls);
+	description = it != g_l8_class_descriptions.end() ? it->second : NULL;
+	pthread_mutex_unlock(&g_l8_description_lock);
+
+	if(description)
+		return description;
+
+	// Parsed outside the lock, which l8_protocol_description() takes
+	description = l8_parse_class_description(cls);
+
+	pthread_mutex_lock(&g_l8_description_lock);
+	it = g_l8_class_descriptions.find(cls);
+	if(it != g_l8_class_descriptions.end()) {
+		delete description;
+		description = it->second;
+	} else
+		g_l8_class_descriptions[cls] = description;
+	pthread_mutex_unlock(&g_l8_description_lock);
+
+	return description;
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "L8VirtualMachine_Private.h"
+
+#include "v8.h"
+
+/// Default number of objects released by one drain of the queue.
+#define L8_RELEASE_QUEUE_DEFAULT_BATCH_SIZE 64
+
+/// Number of list nodes allocated up front, and kept for reuse at most.
+#define L8_RELEASE_QUEUE_SPARE_NODES 1024
+
+/**
+ * Get whether the calling thread may use an isolate.
+ *
+ * @param isolate The isolate.
+ * @return true when the isolate is entered on this thread and, when
+ * lockers are used, locked by it.
+ */
+static inline bool l8_isolate_is_usable(v8::Isolate *isolate)
+{
+	return v8::Isolate::GetCurrent() == isolate && (!v8::Locker::IsActive() || v8::Locker::IsLocked(isolate));
+}
+
+/**
+ * @brief Objects and handles waiting to be released.
+ *
+ * Weak callbacks run within the garbage collection pause. Releasing the
+ * wrapped object there runs its dealloc, and that of the objects only it
+ * owns, within the pause. Instead, the weak callbacks push the object on
+ * this queue, which is drained in batches at the next native call, at the
+ * end of an evaluation or when the application is idle.
+ *
+ * The global handles of framework objects deallocated on a thread that
+ * can not use the isolate are queued as well, and disposed with the objects.
+ *
+ * Pushing handles is lock-free. Objects are pushed, and the queue drained,
+ * by the thread using the isolate. The nodes of released objects are kept
+ * for reuse, so pushing within the pause does not allocate.
+ */
+class L8ReleaseQueue {
+public:
+	L8ReleaseQueue();
+
+	/// Releases all objects still in the queue.
+	~L8ReleaseQueue();
+
+	/**
+	 * Get the queue of an isolate.
+	 */
+	static inline L8ReleaseQueue *fromIsolate(v8::Isolate *isolate)
+	{
+		return (L8ReleaseQueue *)isolate->GetData(L8_ISOLATE_DATA_RELEASE_QUEUE);
+	}
+
+	/**
+	 * Queue an object for release.
+	 *
+	 * Must be called by the thread using the isolate, like weak callbacks are.
+	 *
+	 * @param object The object, of which the reference is transferred to the queue.
+	 */
+	void push(const void *object);
+
+	/**
+	 * Release a number of objects from the queue, and dispose the
+	 * queued handles.
+	 *
+	 * Must be called by the thread using the isolate.
+	 *
+	 * Objects conforming to L8BackgroundRelease are released on a
+	 * background dispatch queue.
+	 *
+	 * @param limit The maximum number of objects to release, 0 for all.
+	 * @return The number of objects released.
+	 */
+	size_t drain(size_t limit);
+
+	/**
+	 * Release a batch of objects when the queue is not empty.
+	 */
+	inline void drainBatchIfNeeded()
+	{
+		if(L8_UNLIKELY(_objects.depth != 0 || _handles.depth != 0))
+			drain(batchSize);
+	}
+
+	/**
+	 * Count a global handle created for a framework object.
+	 *
+	 * Must be called by the thread using the isolate.
+	 */
+	inline void handleCreated()
+	{
+		__sync_fetch_and_add(&_liveHandles, 1);
+	}
+
+	/**
+	 * Dispose the global handle of a framework object.
+	 *
+	 * The handle is reset right away when the calling thread can use the isolate,
+	 * otherwise it is queued and reset when the queue is next drained.
+	 *
+	 * @param isolate The isolate owning the handle.
+	 * @param handle The handle, which is empty afterwards.
+	 */
+	template<class T>
+	inline void disposeHandle(v8::Isolate *isolate, v8::Persistent<T>& handle)
+	{
+		if(handle.IsEmpty())
+			return;
+
+		if(l8_isolate_is_usable(isolate)) {
+			handle.Reset();
+			__sync_fetch_and_sub(&_liveHandles, 1);
+			return;
+		}
+
+		_handles.push(new Node(handle.ClearAndLeak()));
+	}
+
+	/// The number of objects in the queue.
+	inline size_t depth() const
+	{
+		return _objects.depth;
+	}
+
+	/// The number of global handles of framework objects, including queued handles.
+	inline size_t liveHandles() const
+	{
+		return _liveHandles;
+	}
+
+	/// Total time spent draining, in seconds.
+	inline NSTimeInterval drainTime() const
+	{
+		return _drainTime;
+	}
+
+	/// Number of objects released by drainBatchIfNeeded().
+	size_t batchSize;
+
+private:
+	struct Node {
+		const void *item;
+		Node *next;
+
+		explicit Node(const void *item = NULL) : item(item), next(NULL) {}
+	};
+
+	/**
+	 * @brief A lock-free list of pushed items.
+	 */
+	struct List {
+		/// Pushed items, shared with the pushing threads.
+		Node *volatile head;
+
+		/// Items taken from the head, only used when draining.
+		Node *pending;
+
+		volatile long depth;
+
+		void push(Node *node);
+
+		/// Take a node, NULL when the list is empty.
+		Node *pop();
+	};
+
+	List _objects;
+	List _handles;
+
+	/// Nodes for push(), only used by the thread using the isolate.
+	Node *_spareNodes;
+	size_t _spareNodeCount;
+
+	/// Keep a node taken from the object list for reuse.
+	void recycle(Node *node);
+	volatile long _liveHandles;
+	NSTimeInterval _drainTime;
+};
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "L8ReleaseQueue.h"
+#import "L8Export.h"
+
+#include <dispatch/dispatch.h>
+
+using namespace v8;
+
+L8ReleaseQueue::L8ReleaseQueue()
+: batchSize(L8_RELEASE_QUEUE_DEFAULT_BATCH_SIZE),
+_spareNodes(NULL),
+_spareNodeCount(0),
+_liveHandles(0),
+_drainTime(0)
+{
+	_objects.head = _objects.pending = NULL;
+	_objects.depth = 0;
+	_handles.head = _handles.pending = NULL;
+	_handles.depth = 0;
+
+	for(size_t i = 0; i < L8_RELEASE_QUEUE_SPARE_NODES; ++i)
+		recycle(new Node());
+}
+
+L8ReleaseQueue::~L8ReleaseQueue()
+{
+	Node *node;
+
+	// The isolate is gone, and its handles with it
+	while((node = _handles.pop()) != NULL)
+		delete node;
+
+	while((node = _objects.pop()) != NULL) {
+		CFRelease(node->item);
+		delete node;
+	}
+
+	while(_spareNodes != NULL) {
+		node = _spareNodes;
+		_spareNodes = node->next;
+		delete node;
+	}
+}
+
+void L8ReleaseQueue::List::push(Node *node)
+{
+	Node *oldHead;
+
+	do {
+		oldHead = head;
+		node->next = oldHead;
+	} while(!__sync_bool_compare_and_swap(&head, oldHead, node));
+
+	__sync_fetch_and_add(&depth, 1);
+}
+
+L8ReleaseQueue::Node *L8ReleaseQueue::List::pop()
+{
+	Node *node;
+
+	// Take everything pushed so far at once, so taking does not race with pushing
+	if(pending == NULL) {
+		pending = __sync_lock_test_and_set(&head, (Node *)NULL);
+		if(pending == NULL)
+			return NULL;
+	}
+
+	node = pending;
+	pending = node->next;
+
+	__sync_fetch_and_sub(&depth, 1);
+
+	return node;
+}
+
+void L8ReleaseQueue::recycle(Node *node)
+{
+	if(_spareNodeCount >= L8_RELEASE_QUEUE_SPARE_NODES) {
+		delete node;
+		return;
+	}
+
+	node->next = _spareNodes;
+	_spareNodes = node;
+	++_spareNodeCount;
+}
+
+void L8ReleaseQueue::push(const void *object)
+{
+	Node *node;
+
+	node = _spareNodes;
+	if(L8_LIKELY(node != NULL)) {
+		_spareNodes = node->next;
+		--_spareNodeCount;
+	} else
+		node = new Node();
+
+	node->item = object;
+	_objects.push(node);
+}
+
+size_t L8ReleaseQueue::drain(size_t limit)
+{
+	CFAbsoluteTime start;
+	dispatch_queue_t background = NULL;
+	const void *item;
+	Node *node;
+	size_t released = 0;
+
+	start = CFAbsoluteTimeGetCurrent();
+
+	// Disposing a handle is cheap, so all of them are
+	while((node = _handles.pop()) != NULL) {
+		item = node->item;
+		delete node;
+
+		// A Persistent is a single pointer to its global handle
+		static_assert(sizeof(Persistent<Value>) == sizeof(void *), "Persistent must be a single pointer");
+		reinterpret_cast<Persistent<Value> *>(&item)->Reset();
+		__sync_fetch_and_sub(&_liveHandles, 1);
+	}
+
+	while(limit == 0 || released < limit) {
+		node = _objects.pop();
+		if(node == NULL)
+			break;
+
+		item = node->item;
+		recycle(node);
+
+		if([(__bridge id)item conformsToProtocol:@protocol(L8BackgroundRelease)]) {
+			if(background == NULL)
+				background = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0);
+			dispatch_async_f(background, (void *)item, (dispatch_function_t)CFRelease);
+		} else
+			CFRelease(item);
+
+		++released;
+	}
+
+	_drainTime += CFAbsoluteTimeGetCurrent() - start;
+
+	return released;
+}
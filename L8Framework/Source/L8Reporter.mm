@@ -81,6 +81,22 @@ static L8Reporter *g_sharedReporter = nil;
 #endif
 }
 
++ (NSError *)errorForTryCatch:(TryCatch *)tryCatch
+						 code:(NSInteger)code
+					inContext:(L8Context *)context
+{
+	L8Exception *exception;
+	NSDictionary *userInfo;
+
+	exception = [self objcExceptionForTryCatch:tryCatch
+									 inContext:context];
+
+	userInfo = @{ NSLocalizedDescriptionKey: exception.message ?: @"",
+				  L8ExceptionErrorKey: exception };
+
+	return [NSError errorWithDomain:L8ErrorDomain code:code userInfo:userInfo];
+}
+
 + (L8Exception *)objcExceptionForTryCatch:(TryCatch *)tryCatch inContext:(L8Context *)context
 {
 	if(!tryCatch->HasCaught())
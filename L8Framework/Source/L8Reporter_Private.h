@@ -37,4 +37,19 @@
 + (void)reportTryCatch:(v8::TryCatch *)tryCatch
 			 inContext:(L8Context *)context;
 
+/**
+ * Create an error for the exception caught by a TryCatch.
+ *
+ * The exception is reported through the error only: it is not thrown
+ * and the exception handler is not called.
+ *
+ * @param tryCatch The TryCatch that caught the exception.
+ * @param code The error code in L8ErrorDomain.
+ * @param context The context the exception was thrown in.
+ * @return The error, with the L8Exception under L8ExceptionErrorKey.
+ */
++ (NSError *)errorForTryCatch:(v8::TryCatch *)tryCatch
+						 code:(NSInteger)code
+					inContext:(L8Context *)context;
+
 @end
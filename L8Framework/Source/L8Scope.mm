@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "L8Scope.h"
+#import "L8Context_Private.h"
+#import "L8Value_Private.h"
+#import "L8VirtualMachine_Private.h"
+#import "L8Reporter_Private.h"
+#import "L8AutoreleasePool.h"
+#import "NSString+L8.h"
+
+#include <alloca.h>
+
+using namespace v8;
+
+NSString *L8Local::toString() const
+{
+	if(_value.IsEmpty())
+		return nil;
+
+	return [NSString stringWithV8Value:_value inIsolate:_isolate];
+}
+
+L8Local L8Local::call(const L8Local& receiver, int argc, const L8Local *argv) const
+{
+	Local<Value> *arguments, result;
+	Local<Object> thisObject;
+	L8Context *context;
+
+	if(!isFunction())
+		return L8Local();
+
+	// L8Local is a handle with the isolate, copy the handles only
+	arguments = (Local<Value> *)alloca(argc * sizeof(Local<Value>));
+	for(int i = 0; i < argc; ++i)
+		arguments[i] = argv[i].isEmpty() ? (Local<Value>)Undefined(_isolate) : argv[i]._value;
+
+	if(!receiver.isEmpty() && receiver._value->IsObject())
+		thisObject = receiver._value.As<Object>();
+	else
+		thisObject = _isolate->GetCurrentContext()->Global();
+
+	{
+		TryCatch tryCatch;
+
+		result = _value.As<Function>()->Call(thisObject, argc, arguments);
+
+		if(tryCatch.HasCaught()) {
+			context = [L8Context contextWithV8Context:_isolate->GetCurrentContext()];
+			[L8Reporter reportTryCatch:&tryCatch inContext:context];
+			return L8Local();
+		}
+	}
+
+	return L8Local(_isolate, result);
+}
+
+L8Scope::L8Scope(L8Context *context)
+: _context(context),
+_isolate(context.virtualMachine.V8Isolate),
+_handleScope(_isolate),
+_contextScope(context.V8Context)
+{
+}
+
+L8Scope::~L8Scope()
+{
+}
+
+L8Local L8Scope::global() const
+{
+	return L8Local(_isolate, _context.V8Context->Global());
+}
+
+L8Local L8Scope::evaluate(NSString *script) const
+{
+	L8AutoreleaseBoundary autoreleaseBoundary(_isolate, false);
+	ScriptOrigin scriptOrigin = ScriptOrigin(String::NewFromUtf8(_isolate, ""));
+	Local<Script> compiled;
+	Local<Value> result;
+	TryCatch tryCatch;
+
+	if(script == nil)
+		return L8Local();
+
+	compiled = Script::Compile([script V8StringInIsolate:_isolate], &scriptOrigin);
+	if(!compiled.IsEmpty())
+		result = compiled->Run();
+
+	if(tryCatch.HasCaught()) {
+		[L8Reporter reportTryCatch:&tryCatch inContext:_context];
+		return L8Local();
+	}
+
+	return L8Local(_isolate, result);
+}
+
+L8Local L8Scope::local(L8Value *value) const
+{
+	if(value == nil)
+		return L8Local();
+
+	return L8Local(_isolate, value.V8Value);
+}
+
+L8Local L8Scope::fromObject(id object) const
+{
+	return L8Local(_isolate, objectToValue(_isolate, _context, object));
+}
+
+L8Value *L8Scope::value(const L8Local& local) const
+{
+	if(local.isEmpty())
+		return nil;
+
+	return [L8Value valueWithV8Value:local.V8Value() inContext:_context];
+}
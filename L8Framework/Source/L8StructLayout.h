@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "L8Struct.h"
+#include "v8.h"
+#include <string>
+#include <vector>
+
+@class L8Context;
+struct L8StructLayout;
+
+/**
+ * @brief A field of a struct layout.
+ */
+struct L8StructField {
+	/// Type encoding character of the field: a number type or '{'.
+	char type;
+
+	/// Offset of the field in the struct.
+	size_t offset;
+
+	/// Layout of a nested struct, or NULL.
+	const L8StructLayout *layout;
+};
+
+/**
+ * @brief Memory layout of a struct, parsed once from its type encoding.
+ */
+struct L8StructLayout {
+	/// Name of the struct, as in the type encoding.
+	std::string name;
+
+	/// Size of the struct in bytes.
+	size_t size;
+
+	/// Alignment of the struct in bytes.
+	size_t alignment;
+
+	/// The fields in declaration order.
+	std::vector<L8StructField> fields;
+
+	/// Names of the fields. Empty when unknown: the struct is then an array.
+	std::vector<std::string> fieldNames;
+
+	/// Number of numeric fields, counting those of nested structs.
+	size_t flattenedCount;
+
+	/// Representation in JavaScript.
+	L8StructRepresentation representation;
+};
+
+/**
+ * @brief JavaScript objects of a struct layout, cached per context.
+ */
+struct L8StructTemplate {
+	/// Template of the objects, with the fields already present.
+	v8::Eternal<v8::ObjectTemplate> objectTemplate;
+
+	/// The field names.
+	std::vector<v8::Eternal<v8::String> > fieldNames;
+};
+
+/**
+ * Get the layout of a struct type encoding.
+ *
+ * Layouts are parsed once and shared by all descriptors.
+ *
+ * @param encoding The type encoding, starting at '{'.
+ * @return The layout, or NULL when the struct has fields that can not
+ * be converted.
+ */
+const L8StructLayout *l8_struct_layout_for_encoding(const char *encoding);
+
+/**
+ * Convert a native struct to a JavaScript value.
+ *
+ * @param layout The layout of the struct.
+ * @param buffer The struct.
+ * @return The JavaScript representation of the struct.
+ */
+v8::Local<v8::Value> l8_struct_to_value(v8::Isolate *isolate,
+										L8Context *context,
+										const L8StructLayout *layout,
+										const void *buffer);
+
+/**
+ * Convert a JavaScript value to a native struct.
+ *
+ * Accepts objects with the fields as properties, arrays with an element
+ * per field and Float64Arrays with the flattened fields. Missing fields
+ * are zero. A TypeError is thrown when the value is not an object. When
+ * reading a field throws, the exception is left pending.
+ *
+ * @param layout The layout of the struct.
+ * @param value The value to convert.
+ * @param buffer The struct to fill. Must be layout->size bytes.
+ * @return false when the value could not be converted.
+ */
+bool l8_struct_from_value(v8::Isolate *isolate,
+						  L8Context *context,
+						  const L8StructLayout *layout,
+						  v8::Local<v8::Value> value,
+						  void *buffer);
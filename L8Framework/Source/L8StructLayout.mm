@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "L8StructLayout.h"
+#import "L8Context_Private.h"
+#import "L8WrapperMap.h"
+
+#include <map>
+#include <pthread.h>
+#include <string.h>
+
+using namespace v8;
+
+/**
+ * @brief A struct registered with L8RegisterStruct().
+ */
+struct L8StructRegistration {
+	std::vector<std::string> fieldNames;
+	L8StructRepresentation representation;
+};
+
+static std::map<std::string, L8StructRegistration> g_l8_struct_registrations;
+static std::map<std::string, L8StructLayout *> g_l8_struct_layouts;
+static pthread_mutex_t g_l8_struct_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Field names of common structs, terminated by NULL.
+ */
+static const char *const l8_builtin_struct_fields[][7] = {
+	{ "_NSRange", "location", "length", NULL },
+	{ "CGPoint", "x", "y", NULL },
+	{ "_NSPoint", "x", "y", NULL },
+	{ "CGSize", "width", "height", NULL },
+	{ "_NSSize", "width", "height", NULL },
+	{ "CGRect", "origin", "size", NULL },
+	{ "_NSRect", "origin", "size", NULL },
+	{ "CGVector", "dx", "dy", NULL },
+	{ "CGAffineTransform", "a", "b", "c", "d", "tx", "ty" },
+	{ "NSEdgeInsets", "top", "left", "bottom", "right", NULL },
+	{ "UIEdgeInsets", "top", "left", "bottom", "right", NULL },
+	{ NULL }
+};
+
+void L8RegisterStruct(const char *name, NSArray *fieldNames, L8StructRepresentation representation)
+{
+	L8StructRegistration registration;
+
+	for(NSString *fieldName in fieldNames)
+		registration.fieldNames.push_back([fieldName UTF8String]);
+	registration.representation = representation;
+
+	pthread_mutex_lock(&g_l8_struct_lock);
+	g_l8_struct_registrations[name] = registration;
+	pthread_mutex_unlock(&g_l8_struct_lock);
+}
+
+/**
+ * Get the size of a numeric field type.
+ *
+ * @return The size, or 0 when the type is not numeric.
+ */
+static size_t l8_struct_number_size(char type)
+{
+	switch(type) {
+		case 'c': case 'C': case 'B': return 1;
+		case 's': case 'S': return 2;
+		case 'i': case 'I': case 'l': case 'L': case 'f': return 4;
+		case 'q': case 'Q': case 'd': return 8;
+		default: return 0;
+	}
+}
+
+/**
+ * Find the end of the struct encoding starting at encoding.
+ */
+static const char *l8_struct_encoding_end(const char *encoding)
+{
+	int depth = 0;
+
+	do {
+		if(*encoding == '"') // Field name
+			encoding = strchr(encoding + 1, '"');
+		else if(*encoding == '{')
+			++depth;
+		else if(*encoding == '}')
+			--depth;
+
+		if(encoding == NULL || *encoding == '\0')
+			return NULL;
+
+		++encoding;
+	} while(depth > 0);
+
+	return encoding;
+}
+
+static L8StructLayout *l8_cached_struct_layout(const char *encoding, const char *end);
+
+/**
+ * Parse a struct encoding. Must be called with the lock held.
+ *
+ * @return A new layout, or NULL when the struct can not be converted.
+ */
+static L8StructLayout *l8_parse_struct_layout(const char *encoding, const char *end)
+{
+	L8StructLayout *layout;
+	std::vector<std::string> encodedNames;
+	std::map<std::string, L8StructRegistration>::iterator registration;
+	const char *p;
+	size_t offset = 0;
+
+	layout = new L8StructLayout();
+	layout->alignment = 1;
+	layout->flattenedCount = 0;
+	layout->representation = L8StructRepresentationObject;
+
+	// {name=fields}
+	p = encoding + 1;
+	while(p < end && *p != '=' && *p != '}')
+		++p;
+	layout->name.assign(encoding + 1, p - encoding - 1);
+
+	if(*p != '=')
+		goto unsupported;
+	++p;
+
+	while(*p != '}') {
+		L8StructField field;
+		size_t size, alignment;
+
+		// Extended encodings name the fields: "name"type
+		if(*p == '"') {
+			const char *nameEnd = strchr(p + 1, '"');
+
+			if(nameEnd == NULL)
+				goto unsupported;
+
+			encodedNames.push_back(std::string(p + 1, nameEnd - p - 1));
+			p = nameEnd + 1;
+		}
+
+		field.type = *p;
+		field.layout = NULL;
+
+		if(*p == '{') {
+			const char *fieldEnd = l8_struct_encoding_end(p);
+			L8StructLayout *nested;
+
+			if(fieldEnd == NULL)
+				goto unsupported;
+
+			nested = l8_cached_struct_layout(p, fieldEnd);
+			if(nested == NULL)
+				goto unsupported;
+
+			field.layout = nested;
+			size = nested->size;
+			alignment = nested->alignment;
+			layout->flattenedCount += nested->flattenedCount;
+			p = fieldEnd;
+		} else {
+			size = alignment = l8_struct_number_size(*p);
+			if(size == 0)
+				goto unsupported;
+
+			++layout->flattenedCount;
+			++p;
+		}
+
+		offset = (offset + alignment - 1) & ~(alignment - 1);
+		field.offset = offset;
+		offset += size;
+
+		layout->alignment = MAX(layout->alignment, alignment);
+		layout->fields.push_back(field);
+	}
+
+	layout->size = (offset + layout->alignment - 1) & ~(layout->alignment - 1);
+
+	// Registered names first, then the encoded names, then the built in names
+	registration = g_l8_struct_registrations.find(layout->name);
+	if(registration != g_l8_struct_registrations.end()) {
+		layout->fieldNames = registration->second.fieldNames;
+		layout->representation = registration->second.representation;
+	}
+
+	if(layout->fieldNames.empty() && encodedNames.size() == layout->fields.size())
+		layout->fieldNames = encodedNames;
+
+	for(size_t i = 0; layout->fieldNames.empty() && l8_builtin_struct_fields[i][0]; ++i) {
+		if(layout->name != l8_builtin_struct_fields[i][0])
+			continue;
+
+		for(size_t j = 1; j < 7 && l8_builtin_struct_fields[i][j]; ++j)
+			layout->fieldNames.push_back(l8_builtin_struct_fields[i][j]);
+	}
+
+	if(layout->fieldNames.size() != layout->fields.size())
+		layout->fieldNames.clear();
+
+	return layout;
+
+unsupported:
+	delete layout;
+	return NULL;
+}
+
+/**
+ * Get the layout of a struct encoding from the cache, parsing it when
+ * not cached yet. Must be called with the lock held.
+ */
+static L8StructLayout *l8_cached_struct_layout(const char *encoding, const char *end)
+{
+	std::map<std::string, L8StructLayout *>::iterator it;
+	std::string key(encoding, end - encoding);
+	L8StructLayout *layout;
+
+	it = g_l8_struct_layouts.find(key);
+	if(it != g_l8_struct_layouts.end())
+		return it->second;
+
+	layout = l8_parse_struct_layout(encoding, end);
+	g_l8_struct_layouts[key] = layout;
+
+	return layout;
+}
+
+const L8StructLayout *l8_struct_layout_for_encoding(const char *encoding)
+{
+	L8StructLayout *layout;
+	const char *end;
+
+	end = l8_struct_encoding_end(encoding);
+	if(end == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&g_l8_struct_lock);
+	layout = l8_cached_struct_layout(encoding, end);
+	pthread_mutex_unlock(&g_l8_struct_lock);
+
+	return layout;
+}
+
+#pragma mark Conversion
+
+static inline double l8_struct_read_number(char type, const char *field)
+{
+	switch(type) {
+		case 'c': return *(const int8_t *)field;
+		case 'C': return *(const uint8_t *)field;
+		case 'B': return *(const bool *)field;
+		case 's': return *(const int16_t *)field;
+		case 'S': return *(const uint16_t *)field;
+		case 'i': case 'l': return *(const int32_t *)field;
+		case 'I': case 'L': return *(const uint32_t *)field;
+		case 'q': return *(const int64_t *)field;
+		case 'Q': return *(const uint64_t *)field;
+		case 'f': return *(const float *)field;
+		case 'd': return *(const double *)field;
+		default: return 0;
+	}
+}
+
+/**
+ * Write a numeric field.
+ *
+ * @param value The value of the field. Empty when reading it threw.
+ * @return false when the value is empty.
+ */
+static inline bool l8_struct_write_number(char type, char *field, Local<Value> value)
+{
+	double number;
+
+	if(L8_UNLIKELY(value.IsEmpty()))
+		return false;
+
+	if(type == 'B') {
+		*(bool *)field = value->BooleanValue();
+		return true;
+	}
+
+	// Undefined fields, and other values that are not a number, are zero
+	number = value->NumberValue();
+	if(number != number)
+		number = 0;
+
+	switch(type) {
+		case 'c': *(int8_t *)field = (int8_t)number; break;
+		case 'C': *(uint8_t *)field = (uint8_t)number; break;
+		case 's': *(int16_t *)field = (int16_t)number; break;
+		case 'S': *(uint16_t *)field = (uint16_t)number; break;
+		case 'i': case 'l': *(int32_t *)field = (int32_t)number; break;
+		case 'I': case 'L': *(uint32_t *)field = (uint32_t)number; break;
+		case 'q': *(int64_t *)field = (int64_t)number; break;
+		case 'Q': *(uint64_t *)field = (uint64_t)number; break;
+		case 'f': *(float *)field = (float)number; break;
+		case 'd': *(double *)field = number; break;
+	}
+
+	return true;
+}
+
+#ifdef L8_ENABLE_TYPED_ARRAYS
+/**
+ * Write the numeric fields of a struct into a flat array, starting at index.
+ */
+static void l8_struct_flatten(Local<Object> array, uint32_t *index,
+							  const L8StructLayout *layout, const char *buffer)
+{
+	for(size_t i = 0; i < layout->fields.size(); ++i) {
+		const L8StructField& field = layout->fields[i];
+
+		if(field.layout)
+			l8_struct_flatten(array, index, field.layout, buffer + field.offset);
+		else
+			array->Set((*index)++, Number::New(array->GetIsolate(),
+											   l8_struct_read_number(field.type, buffer + field.offset)));
+	}
+}
+#endif
+
+/**
+ * Read the numeric fields of a struct from a flat array, starting at index.
+ *
+ * @return false when reading an element threw.
+ */
+static bool l8_struct_unflatten(Local<Object> array, uint32_t *index,
+								const L8StructLayout *layout, char *buffer)
+{
+	for(size_t i = 0; i < layout->fields.size(); ++i) {
+		const L8StructField& field = layout->fields[i];
+
+		if(field.layout) {
+			if(!l8_struct_unflatten(array, index, field.layout, buffer + field.offset))
+				return false;
+		} else if(!l8_struct_write_number(field.type, buffer + field.offset, array->Get((*index)++)))
+			return false;
+	}
+
+	return true;
+}
+
+Local<Value> l8_struct_to_value(Isolate *isolate,
+								L8Context *context,
+								const L8StructLayout *layout,
+								const void *buffer)
+{
+	EscapableHandleScope localScope(isolate);
+	const char *bytes = (const char *)buffer;
+	L8StructTemplate *structTemplate;
+	Local<Object> object;
+
+#ifdef L8_ENABLE_TYPED_ARRAYS
+	if(layout->representation == L8StructRepresentationFloat64Array) {
+		Local<ArrayBuffer> arrayBuffer;
+		uint32_t index = 0;
+
+		arrayBuffer = ArrayBuffer::New(isolate, layout->flattenedCount * sizeof(double));
+		object = Float64Array::New(arrayBuffer, 0, layout->flattenedCount);
+		l8_struct_flatten(object, &index, layout, bytes);
+
+		return localScope.Escape(object);
+	}
+#endif
+
+	if(layout->fieldNames.empty()) {
+		object = Array::New(isolate, (int)layout->fields.size());
+		structTemplate = NULL;
+	} else {
+		structTemplate = [context.wrapperMap templateForStructLayout:layout];
+		object = structTemplate->objectTemplate.Get(isolate)->NewInstance();
+	}
+
+	for(size_t i = 0; i < layout->fields.size(); ++i) {
+		const L8StructField& field = layout->fields[i];
+		Local<Value> value;
+
+		if(field.layout)
+			value = l8_struct_to_value(isolate, context, field.layout, bytes + field.offset);
+		else
+			value = Number::New(isolate, l8_struct_read_number(field.type, bytes + field.offset));
+
+		if(structTemplate)
+			object->Set(structTemplate->fieldNames[i].Get(isolate), value);
+		else
+			object->Set((uint32_t)i, value);
+	}
+
+	return localScope.Escape(object);
+}
+
+bool l8_struct_from_value(Isolate *isolate,
+						  L8Context *context,
+						  const L8StructLayout *layout,
+						  Local<Value> value,
+						  void *buffer)
+{
+	HandleScope localScope(isolate);
+	char *bytes = (char *)buffer;
+	L8StructTemplate *structTemplate = NULL;
+	Local<Object> object;
+	bool indexed;
+
+	memset(buffer, 0, layout->size);
+
+	if(!value->IsObject()) {
+		isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a struct")));
+		return false;
+	}
+
+	object = value.As<Object>();
+
+	// Flattened numbers
+#ifdef L8_ENABLE_TYPED_ARRAYS
+	if(object->IsFloat64Array() || (layout->representation == L8StructRepresentationFloat64Array && object->IsArray())) {
+#else
+	if(layout->representation == L8StructRepresentationFloat64Array && object->IsArray()) {
+#endif
+		uint32_t index = 0;
+
+		return l8_struct_unflatten(object, &index, layout, bytes);
+	}
+
+	indexed = object->IsArray() || layout->fieldNames.empty();
+	if(!indexed)
+		structTemplate = [context.wrapperMap templateForStructLayout:layout];
+
+	for(size_t i = 0; i < layout->fields.size(); ++i) {
+		const L8StructField& field = layout->fields[i];
+		Local<Value> fieldValue;
+
+		if(indexed)
+			fieldValue = object->Get((uint32_t)i);
+		else
+			fieldValue = object->Get(structTemplate->fieldNames[i].Get(isolate));
+
+		// A throwing getter
+		if(fieldValue.IsEmpty())
+			return false;
+
+		if(field.layout) {
+			if(!l8_struct_from_value(isolate, context, field.layout, fieldValue, bytes + field.offset))
+				return false;
+		} else
+			l8_struct_write_number(field.type, bytes + field.offset, fieldValue);
+	}
+
+	return true;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <map>
+#include <tr1/unordered_map>
+#include <vector>
+#include <string>
+
+#import "L8MethodDescriptor.h"
+#import "L8StructLayout.h"
+
+#include "v8.h"
+
+struct L8TemplateCache;
+
+/**
+ * @brief An instance method of a lazy class.
+ *
+ * The method is described and its function template created when
+ * it is first accessed.
+ */
+struct L8LazyMethod {
+	/// The selector.
+	SEL selector;
+
+	/// The extended type encoding, owned by the runtime.
+	const char *types;
+
+	/// The method descriptor, or NULL when not accessed yet.
+	L8MethodDescriptor *descriptor;
+
+	/// The function template, set together with the descriptor.
+	v8::Eternal<v8::FunctionTemplate> function;
+};
+
+/**
+ * @brief The instance methods of a class exporting with L8LazyExport.
+ *
+ * Instead of the methods, the prototype of the class gets a resolver
+ * object as prototype. Its named interceptor installs a method on the
+ * prototype when the method is first accessed, so later accesses find
+ * a normal property.
+ */
+struct L8LazyClass {
+	/// The methods by JavaScript name.
+	std::map<std::string,L8LazyMethod> methods;
+
+	/// Template of the resolver objects, with the interceptor.
+	v8::Eternal<v8::ObjectTemplate> resolverTemplate;
+
+	/// The cache owning this class.
+	L8TemplateCache *templates;
+};
+
+/**
+ * @brief Templates and descriptors shared by all contexts of a virtual machine.
+ *
+ * Templates are isolate scoped, so a class is reflected once per
+ * virtual machine instead of once per context. The descriptors are
+ * owned by the cache, because the templates refer to them.
+ *
+ * The maps are keyed by pointer and looked up on every wrap, so they
+ * are hash maps. Their elements do not move when they grow.
+ */
+struct L8TemplateCache {
+	typedef std::tr1::unordered_map<Class,v8::Eternal<v8::FunctionTemplate>> ClassTemplateMap;
+	typedef std::tr1::unordered_map<const L8StructLayout *,L8StructTemplate> StructTemplateMap;
+	typedef std::tr1::unordered_map<Class,L8LazyClass *> LazyClassMap;
+
+	/// The function templates of exported classes.
+	ClassTemplateMap classTemplates;
+
+	/// Method descriptors used by the templates.
+	std::vector<L8MethodDescriptor *> methodDescriptors;
+
+	/// Property descriptors used by the templates.
+	std::vector<L8PropertyDescriptor *> propertyDescriptors;
+
+	/// Object templates and field names of struct layouts.
+	StructTemplateMap structTemplates;
+
+	/// Lazily installed methods of classes exporting with L8LazyExport.
+	LazyClassMap lazyClasses;
+
+	/// Number of methods installed by the resolvers of lazy classes.
+	size_t lazyMembersInstalled;
+
+	L8TemplateCache() : lazyMembersInstalled(0) {}
+
+	~L8TemplateCache()
+	{
+		for(size_t i = 0; i < methodDescriptors.size(); ++i)
+			delete methodDescriptors[i];
+		for(size_t i = 0; i < propertyDescriptors.size(); ++i)
+			delete propertyDescriptors[i];
+		for(LazyClassMap::iterator it = lazyClasses.begin(); it != lazyClasses.end(); ++it)
+			delete it->second;
+	}
+};
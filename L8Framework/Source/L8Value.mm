@@ -32,6 +32,7 @@
 #import "L8WrapperMap.h"
 #import "NSString+L8.h"
 #import "L8ArrayBuffer_Private.h"
+#import "L8ReleaseQueue.h"
 
 #include "v8.h"
 #import <objc/runtime.h>
@@ -41,8 +42,68 @@
 
 using namespace v8;
 
+/**
+ * Type of a value, determined when the value is created.
+ *
+ * Undefined, null, booleans and numbers are stored in the value
+ * itself, without a handle.
+ */
+typedef enum L8ValueType : uint8_t {
+	L8ValueTypeUndefined,
+	L8ValueTypeNull,
+	L8ValueTypeBoolean,
+	L8ValueTypeNumber,
+	L8ValueTypeString,
+	L8ValueTypeObject,
+	L8ValueTypeFunction,
+	L8ValueTypeOther
+} L8ValueType;
+
+/**
+ * Convert a number to an unsigned 32-bit integer, like JavaScript does.
+ */
+static inline uint32_t l8_number_to_uint32(double number)
+{
+	double truncated;
+
+	if(!isfinite(number))
+		return 0;
+
+	truncated = fmod(trunc(number), 4294967296.0);
+	if(truncated < 0)
+		truncated += 4294967296.0;
+
+	return (uint32_t)truncated;
+}
+
 @implementation L8Value {
+	/// The value, empty for inline primitives.
 	Persistent<Value> _v8value;
+
+	/// Inline number, or boolean as 0 or 1.
+	double _number;
+
+	L8ValueType _type;
+	BOOL _thrown;
+}
+
+/**
+ * Get a local handle of a value, creating one for inline primitives.
+ */
+static inline Local<Value> l8_value_local(L8Value *value, Isolate *isolate)
+{
+	switch(value->_type) {
+		case L8ValueTypeUndefined:
+			return Undefined(isolate);
+		case L8ValueTypeNull:
+			return Null(isolate);
+		case L8ValueTypeBoolean:
+			return v8::Boolean::New(isolate, value->_number != 0);
+		case L8ValueTypeNumber:
+			return Number::New(isolate, value->_number);
+		default:
+			return Local<Value>::New(isolate, value->_v8value);
+	}
 }
 
 #pragma mark Value creations
@@ -54,22 +115,22 @@ using namespace v8;
 
 + (instancetype)valueWithBool:(BOOL)value inContext:(L8Context *)context
 {
-	return [self valueWithV8Value:v8::Boolean::New(context.virtualMachine.V8Isolate,value) inContext:context];
+	return [[self alloc] initWithType:L8ValueTypeBoolean number:value ? 1 : 0 inContext:context];
 }
 
 + (instancetype)valueWithDouble:(double)value inContext:(L8Context *)context
 {
-	return [self valueWithV8Value:Number::New(context.virtualMachine.V8Isolate,value) inContext:context];
+	return [[self alloc] initWithType:L8ValueTypeNumber number:value inContext:context];
 }
 
 + (instancetype)valueWithInt32:(int32_t)value inContext:(L8Context *)context
 {
-	return [self valueWithV8Value:Int32::New(context.virtualMachine.V8Isolate,value) inContext:context];
+	return [[self alloc] initWithType:L8ValueTypeNumber number:value inContext:context];
 }
 
 + (instancetype)valueWithUInt32:(uint32_t)value inContext:(L8Context *)context
 {
-	return [self valueWithV8Value:Uint32::New(context.virtualMachine.V8Isolate,value) inContext:context];
+	return [[self alloc] initWithType:L8ValueTypeNumber number:value inContext:context];
 }
 
 + (instancetype)valueWithNewObjectInContext:(L8Context *)context
@@ -109,14 +170,30 @@ using namespace v8;
 	return [self valueWithV8Value:error inContext:context];
 }
 
++ (instancetype)valueWithNewErrorFromError:(NSError *)error inContext:(L8Context *)context
+{
+	return [self valueWithV8Value:errorToValue(context.virtualMachine.V8Isolate, context, error)
+						inContext:context];
+}
+
++ (instancetype)valueWithThrownValue:(id)value inContext:(L8Context *)context
+{
+	L8Value *result;
+
+	result = [self valueWithObject:value inContext:context];
+	result->_thrown = YES;
+
+	return result;
+}
+
 + (instancetype)valueWithNullInContext:(L8Context *)context
 {
-	return [self valueWithV8Value:Null(context.virtualMachine.V8Isolate) inContext:context];
+	return [[self alloc] initWithType:L8ValueTypeNull number:0 inContext:context];
 }
 
 + (instancetype)valueWithUndefinedInContext:(L8Context *)context
 {
-	return [self valueWithV8Value:Undefined(context.virtualMachine.V8Isolate) inContext:context];
+	return [[self alloc] initWithType:L8ValueTypeUndefined number:0 inContext:context];
 }
 
 #ifdef L8_ENABLE_SYMBOLS
@@ -150,7 +227,7 @@ using namespace v8;
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return valueToObject(isolate, _context, Local<Value>::New(isolate,_v8value));
+	return valueToObject(isolate, _context, l8_value_local(self, isolate));
 }
 
 - (id)toObjectOfClass:(Class)expectedClass
@@ -161,52 +238,76 @@ using namespace v8;
 
 - (id)toBlockFunction
 {
-	Local<Function> function;
-	Local<Value> isBlock, v8value;
+	Local<Value> v8value;
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
 
-	v8value = Local<Value>::New(isolate,_v8value);
+	v8value = l8_value_local(self, isolate);
 
 	if(!v8value->IsFunction())
 		return nil;
 
-	function = v8value.As<Function>();
-
-	isBlock = function->GetHiddenValue(String::NewFromUtf8(isolate, "isBlock"));
-	if(!isBlock.IsEmpty() && isBlock->IsTrue()) {
-		id block;
-
-		block = l8_unwrap_block(isolate,function);
-
-		return block;
-	}
-
-	return nil;
+	return l8_unwrap_block(isolate, v8value.As<Function>());
 }
 
 - (BOOL)toBool
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
+	Isolate *isolate;
+
+	switch(_type) {
+		case L8ValueTypeUndefined:
+		case L8ValueTypeNull:
+			return NO;
+		case L8ValueTypeBoolean:
+		case L8ValueTypeNumber:
+			return _number != 0 && !isnan(_number);
+		default:
+			break;
+	}
+
+	isolate = _context.virtualMachine.V8Isolate;
 	return (BOOL)Local<Value>::New(isolate,_v8value)->ToBoolean()->IsTrue();
 }
 
 - (double)toDouble
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
+	Isolate *isolate;
+
+	switch(_type) {
+		case L8ValueTypeUndefined:
+			return NAN;
+		case L8ValueTypeNull:
+		case L8ValueTypeBoolean:
+		case L8ValueTypeNumber:
+			return _number;
+		default:
+			break;
+	}
+
+	isolate = _context.virtualMachine.V8Isolate;
 	return Local<Value>::New(isolate,_v8value)->NumberValue();
 }
 
 - (int32_t)toInt32
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
+	Isolate *isolate;
+
+	if(_type <= L8ValueTypeNumber)
+		return (int32_t)l8_number_to_uint32(_number);
+
+	isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
 	return Local<Value>::New(isolate,_v8value)->Int32Value();
 }
 
 - (uint32_t)toUInt32
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
+	Isolate *isolate;
+
+	if(_type <= L8ValueTypeNumber)
+		return l8_number_to_uint32(_number);
+
+	isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
 	return Local<Value>::New(isolate,_v8value)->Uint32Value();
 }
@@ -215,35 +316,35 @@ using namespace v8;
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return valueToNumber(isolate, _context, Local<Value>::New(isolate,_v8value));
+	return valueToNumber(isolate, _context, l8_value_local(self, isolate));
 }
 
 - (NSString *)toString
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return valueToString(isolate, _context, Local<Value>::New(isolate,_v8value));
+	return valueToString(isolate, _context, l8_value_local(self, isolate));
 }
 
 - (NSDate *)toDate
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return valueToDate(isolate, _context, Local<Value>::New(isolate,_v8value));
+	return valueToDate(isolate, _context, l8_value_local(self, isolate));
 }
 
 - (NSArray *)toArray
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return valueToArray(isolate, _context, Local<Value>::New(isolate,_v8value));
+	return valueToArray(isolate, _context, l8_value_local(self, isolate));
 }
 
 - (NSDictionary *)toDictionary
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return valueToDictionary(isolate, _context, Local<Value>::New(isolate,_v8value));
+	return valueToDictionary(isolate, _context, l8_value_local(self, isolate));
 }
 
 #ifdef L8_ENABLE_TYPED_ARRAYS
@@ -251,7 +352,7 @@ using namespace v8;
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return [L8ArrayBuffer arrayBufferWithV8Value:Local<Value>::New(isolate,_v8value) inIsolate:isolate];
+	return [L8ArrayBuffer arrayBufferWithV8Value:l8_value_local(self, isolate) inIsolate:isolate];
 }
 #endif
 
@@ -264,7 +365,7 @@ using namespace v8;
 	Local<Object> object;
 	Local<Value> value;
 
-	object = Local<Value>::New(isolate,_v8value)->ToObject();
+	object = l8_value_local(self, isolate)->ToObject();
 	value = object->Get([property V8StringInIsolate:isolate]);
 
 	return [L8Value valueWithV8Value:localScope.Escape(value) inContext:_context];
@@ -273,21 +374,21 @@ using namespace v8;
 - (void)setValue:(id)value forProperty:(NSString *)property
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	Local<Object> object = Local<Value>::New(isolate,_v8value)->ToObject();
+	Local<Object> object = l8_value_local(self, isolate)->ToObject();
 	object->Set([property V8StringInIsolate:isolate],objectToValue(isolate,_context,value));
 }
 
 - (BOOL)deleteProperty:(NSString *)property
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	Local<Object> object = Local<Value>::New(isolate,_v8value)->ToObject();
+	Local<Object> object = l8_value_local(self, isolate)->ToObject();
 	return object->Delete([property V8StringInIsolate:isolate]);
 }
 
 - (BOOL)hasProperty:(NSString *)property
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	Local<Object> object = Local<Value>::New(isolate,_v8value)->ToObject();
+	Local<Object> object = l8_value_local(self, isolate)->ToObject();
 	return object->Has([property V8StringInIsolate:isolate]);
 }
 
@@ -303,7 +404,7 @@ using namespace v8;
 		return [self valueForProperty:propertyName];
 	}
 
-	object = Local<Value>::New(isolate,_v8value)->ToObject();
+	object = l8_value_local(self, isolate)->ToObject();
 
 	return [L8Value valueWithV8Value:object->Get((uint32_t)index) inContext:_context];
 }
@@ -320,7 +421,7 @@ using namespace v8;
 		return [self setValue:value forProperty:propertyName];
 	}
 
-	object = Local<Value>::New(isolate,_v8value)->ToObject();
+	object = l8_value_local(self, isolate)->ToObject();
 	object->Set((uint32_t)index, objectToValue(isolate,_context,value));
 }
 
@@ -334,58 +435,46 @@ using namespace v8;
 
 - (BOOL)isUndefined
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	HandleScope localScope(isolate);
-	return Local<Value>::New(isolate,_v8value)->IsUndefined();
+	return _type == L8ValueTypeUndefined;
 }
 
 - (BOOL)isNull
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	HandleScope localScope(isolate);
-	return Local<Value>::New(isolate,_v8value)->IsNull();
+	return _type == L8ValueTypeNull;
 }
 
 - (BOOL)isBoolean
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	HandleScope localScope(isolate);
-	Local<Value> v8value = Local<Value>::New(isolate,_v8value);
-	return v8value->IsBoolean() || (v8value->IsNumber() && v8value->Uint32Value() <= 1);
+	return _type == L8ValueTypeBoolean || (_type == L8ValueTypeNumber && l8_number_to_uint32(_number) <= 1);
 }
 
 - (BOOL)isNumber
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	HandleScope localScope(isolate);
-	return Local<Value>::New(isolate,_v8value)->IsNumber();
+	return _type == L8ValueTypeNumber;
 }
 
 - (BOOL)isString
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	HandleScope localScope(isolate);
-	return Local<Value>::New(isolate,_v8value)->IsString();
+	return _type == L8ValueTypeString;
 }
 
 - (BOOL)isObject
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	HandleScope localScope(isolate);
-	Local<Value> v8value = Local<Value>::New(isolate,_v8value);
-	return v8value->IsObject() && !v8value->IsFunction();
+	return _type == L8ValueTypeObject;
 }
 
 - (BOOL)isFunction
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	HandleScope localScope(isolate);
-	return Local<Value>::New(isolate,_v8value)->IsFunction();
+	return _type == L8ValueTypeFunction;
 }
 
 - (BOOL)isRegularExpression
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
+
+	if(_type != L8ValueTypeObject)
+		return NO;
+
 	HandleScope localScope(isolate);
 	return Local<Value>::New(isolate,_v8value)->IsRegExp();
 }
@@ -393,6 +482,10 @@ using namespace v8;
 - (BOOL)isNativeError
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
+
+	if(_type != L8ValueTypeObject)
+		return NO;
+
 	HandleScope localScope(isolate);
 	return Local<Value>::New(isolate,_v8value)->IsNativeError();
 }
@@ -402,7 +495,7 @@ using namespace v8;
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return Local<Value>::New(isolate,_v8value)->IsSymbol();
+	return l8_value_local(self, isolate)->IsSymbol();
 }
 #endif
 
@@ -411,14 +504,14 @@ using namespace v8;
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return Local<Value>::New(isolate,_v8value)->IsArrayBuffer();
+	return l8_value_local(self, isolate)->IsArrayBuffer();
 }
 
 - (BOOL)isArrayBufferView
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return Local<Value>::New(isolate,_v8value)->IsArrayBufferView();
+	return l8_value_local(self, isolate)->IsArrayBufferView();
 }
 #endif
 
@@ -426,14 +519,14 @@ using namespace v8;
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return 	Local<Value>::New(isolate,_v8value)->StrictEquals(objectToValue(isolate,_context,value));
+	return 	l8_value_local(self, isolate)->StrictEquals(objectToValue(isolate,_context,value));
 }
 
 - (BOOL)isEqualWithTypeCoercionToObject:(id)value
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	return 	Local<Value>::New(isolate,_v8value)->Equals(objectToValue(isolate,_context,value));
+	return 	l8_value_local(self, isolate)->Equals(objectToValue(isolate,_context,value));
 }
 
 - (BOOL)isInstanceOf:(id)value
@@ -454,7 +547,7 @@ using namespace v8;
 	if(funcTemplate.IsEmpty())
 		return NO;
 
-	return funcTemplate->HasInstance(Local<Value>::New(isolate,_v8value));
+	return funcTemplate->HasInstance(l8_value_local(self, isolate));
 }
 
 #pragma mark Throwing exceptions
@@ -463,7 +556,7 @@ using namespace v8;
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	HandleScope localScope(isolate);
-	isolate->ThrowException(Local<Value>::New(isolate,_v8value));
+	isolate->ThrowException(l8_value_local(self, isolate));
 }
 
 #pragma mark Invoking methods and constructors
@@ -475,7 +568,7 @@ using namespace v8;
 	Local<Value> *argv, result, v8value;
 	Local<Object> function;
 
-	if(!Local<Value>::New(isolate,_v8value)->IsFunction())
+	if(!l8_value_local(self, isolate)->IsFunction())
 		return [L8Value valueWithUndefinedInContext:_context];
 
 	argv = (Local<Value> *)calloc(arguments.count,sizeof(Local<Value>));
@@ -483,7 +576,7 @@ using namespace v8;
 		argv[idx] = objectToValue(isolate,_context, obj);
 	}];
 
-	v8value = Local<Value>::New(isolate,_v8value);
+	v8value = l8_value_local(self, isolate);
 	function = v8value->ToObject();
 
 	{
@@ -510,7 +603,7 @@ using namespace v8;
 
 	// Just like ObjC, we want no need to check the validity of
 	// self when invoking this method.
-	v8value = Local<Value>::New(isolate,_v8value);
+	v8value = l8_value_local(self, isolate);
 	if(!v8value->IsFunction())
 		return [L8Value valueWithUndefinedInContext:_context];
 
@@ -546,15 +639,15 @@ using namespace v8;
 
 	// Just like ObjC, we want no need to check the validity of
 	// self when invoking this method.
-	selfV8value = Local<Value>::New(isolate,_v8value);
+	selfV8value = l8_value_local(self, isolate);
 	if(selfV8value->IsUndefined() || selfV8value->IsNull())
 		return [L8Value valueWithUndefinedInContext:_context];
 
 	function = self[method];
-	if(!function || Local<Value>::New(isolate,_v8value)->IsUndefined())
+	if(!function || l8_value_local(self, isolate)->IsUndefined())
 		return [L8Value valueWithUndefinedInContext:_context];
 
-	v8value = Local<Value>::New(isolate,function->_v8value);
+	v8value = l8_value_local(function, isolate);
 	v8function = v8value.As<Function>();
 
 	argv = (Local<Value> *)calloc(arguments.count,sizeof(Local<Value>));
@@ -582,7 +675,7 @@ using namespace v8;
 	NSString *value;
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 
-	if(id wrapped = l8_unwrap_objc_object(isolate, Local<Value>::New(isolate,_v8value)))
+	if(id wrapped = l8_unwrap_objc_object(isolate, l8_value_local(self, isolate)))
 		value = [wrapped description];
 	else
 		value = [self toString];
@@ -604,21 +697,69 @@ using namespace v8;
 
 	self = [super init];
 	if(self) {
+		Isolate *isolate = context.virtualMachine.V8Isolate;
+
 		_context = context;
-		_v8value.Reset(_context.virtualMachine.V8Isolate,value);
+
+		// Primitives without identity are stored inline
+		if(value->IsUndefined())
+			_type = L8ValueTypeUndefined;
+		else if(value->IsNull())
+			_type = L8ValueTypeNull;
+		else if(value->IsBoolean()) {
+			_type = L8ValueTypeBoolean;
+			_number = value->IsTrue() ? 1 : 0;
+		} else if(value->IsNumber()) {
+			_type = L8ValueTypeNumber;
+			_number = value->NumberValue();
+		} else {
+			if(value->IsString())
+				_type = L8ValueTypeString;
+			else if(value->IsFunction())
+				_type = L8ValueTypeFunction;
+			else if(value->IsObject())
+				_type = L8ValueTypeObject;
+			else
+				_type = L8ValueTypeOther;
+
+			_v8value.Reset(isolate,value);
+			L8ReleaseQueue::fromIsolate(isolate)->handleCreated();
+		}
 	}
 	return self;
 }
 
+- (instancetype)initWithType:(L8ValueType)type number:(double)number inContext:(L8Context *)context
+{
+	self = [super init];
+	if(self) {
+		_context = context;
+		_type = type;
+		_number = number;
+	}
+	return self;
+}
+
+- (BOOL)isThrown
+{
+	return _thrown;
+}
+
 - (Local<Value>)V8Value
 {
-	Isolate *isolate = _context.virtualMachine.V8Isolate;
-	return Local<Value>::New(isolate,_v8value);
+	return l8_value_local(self, _context.virtualMachine.V8Isolate);
 }
 
 - (void)dealloc
 {
-	_v8value.ClearAndLeak();
+	Isolate *isolate;
+
+	if(_v8value.IsEmpty())
+		return;
+
+	// Values can be deallocated on any thread
+	isolate = _context.virtualMachine.V8Isolate;
+	L8ReleaseQueue::fromIsolate(isolate)->disposeHandle(isolate, _v8value);
 }
 
 enum COLLECTION_TYPE {
@@ -1016,6 +1157,23 @@ Local<Value> objectToValue(Isolate *isolate, L8Context *context, id object)
 	return handleScope.Escape(job.value);
 }
 
+Local<Value> errorToValue(Isolate *isolate, L8Context *context, NSError *error)
+{
+	EscapableHandleScope handleScope(isolate);
+	Local<Object> value;
+	NSString *message;
+
+	message = error.localizedDescription;
+	if(message == nil)
+		message = @"";
+
+	value = Exception::Error([message V8StringInIsolate:isolate]).As<Object>();
+	value->Set(String::NewFromUtf8(isolate, "domain"), [error.domain V8StringInIsolate:isolate]);
+	value->Set(String::NewFromUtf8(isolate, "code"), Number::New(isolate, error.code));
+
+	return handleScope.Escape(value);
+}
+
 @end
 
 @implementation L8Value (Subscripting)
@@ -36,6 +36,9 @@
 /// v8::Value wrapped by this L8Value.
 @property (nonatomic,readonly) v8::Local<v8::Value> V8Value;
 
+/// Whether the value is thrown when returned from native code. See valueWithThrownValue:inContext:.
+@property (nonatomic,readonly) BOOL isThrown;
+
 + (instancetype)valueWithV8Value:(v8::Local<v8::Value>)value L8_UNAVAILABLE("Use valueWithV8Value:inContext: instead.");
 + (instancetype)valueWithV8Value:(v8::Local<v8::Value>)value inContext:(L8Context *)context;
 
@@ -46,6 +49,7 @@
 @end
 
 v8::Local<v8::Value> objectToValue(v8::Isolate *isolate, L8Context *context, id object);
+v8::Local<v8::Value> errorToValue(v8::Isolate *isolate, L8Context *context, NSError *error);
 
 id valueToObject(v8::Isolate *isolate, L8Context *context, v8::Local<v8::Value> value);
 NSNumber *valueToNumber(v8::Isolate *isolate, L8Context *context, v8::Local<v8::Value> value);
@@ -29,6 +29,13 @@
 #import "L8ManagedValue_Private.h"
 #import "L8WrapperMap.h"
 #import "L8ArrayBufferAllocator.h"
+#import "L8AutoreleasePool.h"
+#import "L8TemplateCache.h"
+#import "L8ReleaseQueue.h"
+
+#ifdef __APPLE__
+# include <mach/mach.h>
+#endif
 
 using namespace v8;
 
@@ -37,6 +44,11 @@ static L8ArrayBufferAllocator *g_l8_array_buffer_allocator = nullptr;
 @implementation L8VirtualMachine {
 	Isolate *_v8isolate;
 	NSMapTable *_managedObjectGraph;
+	L8AutoreleaseState _autoreleaseState;
+	L8PrivateKeys _privateKeys;
+	L8TemplateCache _templateCache;
+	L8ReleaseQueue *_releaseQueue;
+	L8ExternalMemoryStats _externalMemoryStats;
 }
 
 + (void)initialize
@@ -53,6 +65,30 @@ static L8ArrayBufferAllocator *g_l8_array_buffer_allocator = nullptr;
 		_v8isolate = Isolate::New();
 		_v8isolate->Enter();
 
+		_autoreleaseState.policy = L8AutoreleasePolicyPerCall;
+		_autoreleaseState.interval = 64;
+		_autoreleaseState.memoryLimit = L8_AUTORELEASE_MEMORY_LIMIT;
+		_autoreleaseState.pool = NULL;
+		_autoreleaseState.depth = 0;
+		_autoreleaseState.calls = 0;
+		_autoreleaseState.memoryCheckCalls = 0;
+		_autoreleaseState.memoryBase = 0;
+		_v8isolate->SetData(L8_ISOLATE_DATA_AUTORELEASE_STATE, &_autoreleaseState);
+
+		_externalMemoryStats.bytes = 0;
+		_externalMemoryStats.objects = 0;
+
+		_releaseQueue = new L8ReleaseQueue();
+		_v8isolate->SetData(L8_ISOLATE_DATA_RELEASE_QUEUE, _releaseQueue);
+
+		{
+			HandleScope localScope(_v8isolate);
+
+			_privateKeys.block.Set(_v8isolate, String::NewFromUtf8(_v8isolate, "l8::block"));
+			_privateKeys.boundClass.Set(_v8isolate, String::NewFromUtf8(_v8isolate, "l8::class"));
+			_v8isolate->SetData(L8_ISOLATE_DATA_PRIVATE_KEYS, &_privateKeys);
+		}
+
 		_managedObjectGraph = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPersonality
 														valueOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPersonality
 															capacity:0];
@@ -82,11 +118,18 @@ static L8ArrayBufferAllocator *g_l8_array_buffer_allocator = nullptr;
 
 - (void)dealloc
 {
+	// Handles queued by other threads belong to the isolate
+	if(l8_isolate_is_usable(_v8isolate))
+		_releaseQueue->drain(0);
+
 	if(Isolate::GetCurrent() == _v8isolate)
 	   _v8isolate->Exit();
 
 	_v8isolate->Dispose();
 	_v8isolate = NULL;
+
+	// Disposing the isolate can queue more objects
+	delete _releaseQueue;
 }
 
 - (v8::Isolate *)V8Isolate
@@ -94,6 +137,95 @@ static L8ArrayBufferAllocator *g_l8_array_buffer_allocator = nullptr;
 	return _v8isolate;
 }
 
+- (L8TemplateCache *)templateCache
+{
+	return &_templateCache;
+}
+
+- (L8ExternalMemoryStats *)externalMemoryStats
+{
+	return &_externalMemoryStats;
+}
+
+- (int64_t)externalMemoryReported
+{
+	return _externalMemoryStats.bytes;
+}
+
+- (NSUInteger)externalMemoryObjects
+{
+	return _externalMemoryStats.objects;
+}
+
+- (NSUInteger)lazyMembersInstalled
+{
+	return _templateCache.lazyMembersInstalled;
+}
+
+- (NSUInteger)releaseQueueDepth
+{
+	return _releaseQueue->depth();
+}
+
+- (NSUInteger)liveHandles
+{
+	return _releaseQueue->liveHandles();
+}
+
+- (NSTimeInterval)releaseQueueDrainTime
+{
+	return _releaseQueue->drainTime();
+}
+
+- (NSUInteger)releaseBatchSize
+{
+	return _releaseQueue->batchSize;
+}
+
+- (void)setReleaseBatchSize:(NSUInteger)releaseBatchSize
+{
+	_releaseQueue->batchSize = MAX(releaseBatchSize, 1u);
+}
+
+- (NSUInteger)drainReleaseQueue:(NSUInteger)maximumCount
+{
+	// The queue is drained by the thread using the isolate only
+	if(!l8_isolate_is_usable(_v8isolate))
+		return 0;
+
+	return _releaseQueue->drain(maximumCount);
+}
+
+- (L8AutoreleasePolicy)autoreleasePolicy
+{
+	return _autoreleaseState.policy;
+}
+
+- (void)setAutoreleasePolicy:(L8AutoreleasePolicy)autoreleasePolicy
+{
+	_autoreleaseState.policy = autoreleasePolicy;
+}
+
+- (unsigned int)autoreleaseInterval
+{
+	return _autoreleaseState.interval;
+}
+
+- (void)setAutoreleaseInterval:(unsigned int)autoreleaseInterval
+{
+	_autoreleaseState.interval = MAX(autoreleaseInterval, 1u);
+}
+
+- (size_t)autoreleaseMemoryLimit
+{
+	return _autoreleaseState.memoryLimit;
+}
+
+- (void)setAutoreleaseMemoryLimit:(size_t)autoreleaseMemoryLimit
+{
+	_autoreleaseState.memoryLimit = autoreleaseMemoryLimit;
+}
+
 - (id)getInternalObjCObject:(id)object
 {
 	HandleScope localScope(_v8isolate);
@@ -186,7 +318,23 @@ static L8ArrayBufferAllocator *g_l8_array_buffer_allocator = nullptr;
 {
 #ifdef DEBUG
 	while(!V8::IdleNotification()) {};
+	_releaseQueue->drain(0);
 #endif
 }
 
 @end
+
+size_t l8_resident_memory_size(void)
+{
+#ifdef __APPLE__
+	struct mach_task_basic_info info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+	if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+		return 0;
+
+	return info.resident_size;
+#else
+	return 0;
+#endif
+}
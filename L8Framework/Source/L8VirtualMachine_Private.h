@@ -26,6 +26,65 @@
 #import "L8VirtualMachine.h"
 #include "v8.h"
 
+struct L8TemplateCache;
+
+/// Isolate data slot holding the FunctionCallbackInfo of the active native callback.
+#define L8_ISOLATE_DATA_CALLBACK_INFO 0
+
+/// Isolate data slot holding the L8AutoreleaseState of the virtual machine.
+#define L8_ISOLATE_DATA_AUTORELEASE_STATE 1
+
+/// Isolate data slot holding the L8PrivateKeys of the virtual machine.
+#define L8_ISOLATE_DATA_PRIVATE_KEYS 2
+
+/// Isolate data slot holding the L8ReleaseQueue of the virtual machine.
+#define L8_ISOLATE_DATA_RELEASE_QUEUE 3
+
+/**
+ * @brief Keys of the hidden values set by the framework.
+ *
+ * The strings are created once per isolate, so setting and looking up
+ * hidden values allocates nothing.
+ */
+struct L8PrivateKeys {
+	/// Key of the wrapped block of a function.
+	v8::Eternal<v8::String> block;
+
+	/// Key of the class bound to a class function.
+	v8::Eternal<v8::String> boundClass;
+
+	/**
+	 * Get the keys of an isolate.
+	 */
+	static inline L8PrivateKeys *fromIsolate(v8::Isolate *isolate)
+	{
+		return (L8PrivateKeys *)isolate->GetData(L8_ISOLATE_DATA_PRIVATE_KEYS);
+	}
+
+	/// The block key of an isolate.
+	static inline v8::Local<v8::String> blockKey(v8::Isolate *isolate)
+	{
+		return fromIsolate(isolate)->block.Get(isolate);
+	}
+
+	/// The class key of an isolate.
+	static inline v8::Local<v8::String> classKey(v8::Isolate *isolate)
+	{
+		return fromIsolate(isolate)->boundClass.Get(isolate);
+	}
+};
+
+/**
+ * @brief Native memory reported to the garbage collector by wrappers.
+ */
+struct L8ExternalMemoryStats {
+	/// Total reported size in bytes.
+	int64_t bytes;
+
+	/// Number of live wrappers with a reported size.
+	size_t objects;
+};
+
 /**
  * @brief Virtual machine extension with private methods
  */
@@ -34,4 +93,10 @@
 /// v8::Isolate wrapped by this virtual machine.
 @property (nonatomic,readonly) v8::Isolate *V8Isolate L8_RETURNS_INNER_POINTER;
 
+/// Class templates and descriptors shared by the contexts of this virtual machine.
+@property (nonatomic,readonly) struct L8TemplateCache *templateCache L8_RETURNS_INNER_POINTER;
+
+/// Native memory reported by the wrappers in the contexts of this virtual machine.
+@property (nonatomic,readonly) struct L8ExternalMemoryStats *externalMemoryStats L8_RETURNS_INNER_POINTER;
+
 @end
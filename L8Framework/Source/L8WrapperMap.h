@@ -26,6 +26,35 @@
 #include "v8.h"
 
 @class L8Context, L8Value;
+struct L8MethodDescriptor;
+struct L8PropertyDescriptor;
+struct L8StructLayout;
+struct L8StructTemplate;
+
+/// Internal field of a wrapper holding the wrapped object, as aligned pointer.
+#define L8_WRAPPER_FIELD_OBJECT 0
+
+/// Internal field of a wrapper holding its L8WrapperType, as aligned pointer.
+#define L8_WRAPPER_FIELD_TYPE 1
+
+/// Number of internal fields of a wrapper.
+#define L8_WRAPPER_FIELD_COUNT 2
+
+/**
+ * Type tag of an object created by L8.
+ *
+ * Instances and array buffers carry the tag in L8_WRAPPER_FIELD_TYPE.
+ * Functions have no internal fields: classes and blocks are tagged by their
+ * hidden value (see L8PrivateKeys). Tags are stored as aligned pointers,
+ * so the values are even.
+ */
+typedef enum {
+	L8WrapperTypeNone = 0,
+	L8WrapperTypeInstance = 2,
+	L8WrapperTypeClass = 4,
+	L8WrapperTypeBlock = 6,
+	L8WrapperTypeArrayBuffer = 8
+} L8WrapperType;
 
 /**
  * @brief A structure that maps between JS and ObjC objects.
@@ -35,6 +64,12 @@
 /// Context using this wrapper map
 @property (nonatomic,readonly) L8Context *context;
 
+/// Number of wrappers returned from the wrapper cache.
+@property (nonatomic,readonly) NSUInteger wrapperCacheHits;
+
+/// Number of wrappers created for Objective-C objects.
+@property (nonatomic,readonly) NSUInteger wrapperCacheMisses;
+
 /**
  * Create a new Wrapper Map for specified context.
  *
@@ -45,13 +80,26 @@
 /**
  * Create a JavaScript wrapper for an Objective-C object.
  *
- * @todo Add caching to increase performance and decrease memory usage.
+ * The wrapper of an object is cached weakly: as long as it is alive,
+ * the same wrapper is returned, so wrappers of one object are identical (===).
  *
  * @param object The Objective-C object.
  * @return A JavaScript value.
  */
 - (L8Value *)JSWrapperForObject:(id)object;
 
+/**
+ * Bind an Objective-C object to a JavaScript wrapper instance.
+ *
+ * The object is retained and stored in the internal fields of the wrapper
+ * until the wrapper is collected, and the wrapper is added to the wrapper
+ * cache. Used for all instances, including objects constructed from JavaScript.
+ *
+ * @param object The Objective-C object.
+ * @param wrapper The JavaScript wrapper, an instance of a class template.
+ */
+- (void)bindObject:(id)object toJSWrapper:(v8::Local<v8::Object>)wrapper;
+
 /**
  * Create a JavaScript wrapper for an Objective-C object.
  *
@@ -66,7 +114,8 @@
 /**
  * Get the cached function template for given class.
  *
- * Used by -[L8Value isInstanceOf:]
+ * Templates are cached by the virtual machine, and shared by
+ * all of its contexts. Used by -[L8Value isInstanceOf:]
  *
  * @param cls Class to get the template for.
  * @return The function template, or an Empty handle when cache
@@ -74,11 +123,63 @@
  */
 - (v8::Local<v8::FunctionTemplate>)getCachedFunctionTemplateForClass:(Class)cls;
 
+/**
+ * Create a method descriptor owned by the template cache of the virtual machine.
+ *
+ * The descriptor lives as long as the virtual machine, and thus as
+ * long as the templates using it.
+ *
+ * @param selector The selector of the method.
+ * @param types The (extended) type encoding of the method.
+ * @param isClassMethod Whether the method is a class method.
+ * @return A new method descriptor.
+ */
+- (struct L8MethodDescriptor *)methodDescriptorForSelector:(SEL)selector
+													 types:(const char *)types
+											 isClassMethod:(BOOL)isClassMethod;
+
+/**
+ * Create the descriptor of the initializer used to construct
+ * instances of a class from JavaScript.
+ *
+ * The class, signature and implementation are resolved once.
+ *
+ * @param cls The class to construct.
+ * @param selector The initializer selector.
+ * @return A new method descriptor with the class bound.
+ */
+- (struct L8MethodDescriptor *)initializerDescriptorForClass:(Class)cls
+													selector:(SEL)selector;
+
+/**
+ * Create a property descriptor owned by the template cache of the virtual machine.
+ *
+ * @param type The type encoding of the property.
+ * @param getter The descriptor of the getter.
+ * @param setter The descriptor of the setter, or NULL when readonly.
+ * @return A new property descriptor.
+ */
+- (struct L8PropertyDescriptor *)propertyDescriptorWithType:(const char *)type
+													 getter:(struct L8MethodDescriptor *)getter
+													 setter:(struct L8MethodDescriptor *)setter;
+
+/**
+ * Get the JavaScript objects of a struct layout with field names.
+ *
+ * The template and field name strings are created on first use.
+ *
+ * @param layout The struct layout.
+ * @return The struct template, owned by the template cache of the virtual machine.
+ */
+- (struct L8StructTemplate *)templateForStructLayout:(const struct L8StructLayout *)layout;
+
 @end
 
 /**
  * Wrap an ObjC object in a simple v8 object with weak memory.
  *
+ * Used for blocks, which are functions and have no internal fields.
+ *
  * @param context The v8 context to create the wrapper in.
  * @param wrappedObject The ObjC object to wrap.
  * @return A v8 value.
@@ -86,12 +187,32 @@
 v8::Local<v8::External> l8_make_wrapper(v8::Local<v8::Context> context, id object);
 
 /**
- * Get an ObjC object from a V8 object with weak memory.
+ * Get the type tag of an object with wrapper internal fields.
+ *
+ * @param object The v8 object.
+ * @return The type tag, or L8WrapperTypeNone when the object is not tagged by L8.
+ */
+inline L8WrapperType l8_wrapper_type(v8::Local<v8::Object> object)
+{
+	if(object->InternalFieldCount() < L8_WRAPPER_FIELD_COUNT)
+		return L8WrapperTypeNone;
+
+	return (L8WrapperType)(intptr_t)object->GetAlignedPointerFromInternalField(L8_WRAPPER_FIELD_TYPE);
+}
+
+/**
+ * Get the ObjC object from a wrapper instance.
  *
  * @param wrapper The v8 object containing the ObjC object.
- * @return The ObjC object, or nil on failure.
+ * @return The ObjC object, or nil when the object is not a bound instance.
  */
-id l8_object_from_wrapper(v8::Local<v8::Value> wrapper);
+inline id l8_object_from_wrapper(v8::Local<v8::Object> wrapper)
+{
+	if(L8_UNLIKELY(l8_wrapper_type(wrapper) != L8WrapperTypeInstance))
+		return nil;
+
+	return (__bridge id)wrapper->GetAlignedPointerFromInternalField(L8_WRAPPER_FIELD_OBJECT);
+}
 
 /**
  * Get the wrapped ObjC object from an V8 object, created using -[JSWrapperForObject:]
@@ -105,6 +226,9 @@ id l8_unwrap_objc_object(v8::Isolate *isolate, v8::Local<v8::Value> value);
 /**
  * Wrap a C block into a V8 function object.
  *
+ * The block is stored once, as call data and as hidden value under
+ * the block key of L8PrivateKeys, which marks the function as block.
+ *
  * @param context The v8 context to create the wrapper in.
  * @param object The C block.
  * @return A v8 Function object.
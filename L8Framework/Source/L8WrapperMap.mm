@@ -27,6 +27,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
 #include <iterator>
 
 #import "L8WrapperMap.h"
@@ -39,60 +40,18 @@
 #import "NSString+L8.h"
 #import "ObjCRuntime+L8.h"
 #import "ObjCCallback.h"
+#import "L8MethodDescriptor.h"
+#import "ObjCTrampoline.h"
+#import "L8StructLayout.h"
+#import "L8TemplateCache.h"
+#import "L8ProtocolDescription.h"
+#import "L8ReleaseQueue.h"
+#import "L8Binding.h"
 
 #include "v8.h"
 
 using namespace v8;
 
-/**
- * Extract a propertyname from a selectorname.
- *
- * Removes ':' and makes every letter following such colon uppercase. For example,
- * 'initWithName:surname:' becomes 'initWithNameSurname'. Return value is stored in
- * an NSString due to the locally allocated buffer.
- *
- * @return An NSString containing the property name
- */
-static NSString *l8_selector_to_property_name(const char *start, bool instanceMethod = true)
-{
-	const char *firstColon, *input;
-	char *buffer, *output;
-	size_t header;
-	NSString *result;
-
-	// Find the first semicolon
-	firstColon = index(start, ':');
-	if(!firstColon)
-		return [NSString stringWithUTF8String:start];
-
-	header = firstColon - start;
-	buffer = (char *)malloc(header + strlen(firstColon + 1) + 1);
-	memcpy(buffer, start, header);
-
-	output = buffer + header;
-	input = start + header + 1;
-
-	while(true) {
-		char c;
-
-		while((c = *(input++)) == ':');
-
-		if(!(*(output++) = toupper(c)))
-			goto done;
-
-		while((c = *(input++)) != ':') {
-			if(!(*(output++) = c))
-				goto done;
-		}
-	}
-
-done:
-	result = [NSString stringWithUTF8String:buffer];
-	free(buffer);
-
-	return result;
-}
-
 /**
  * Creates a v8 handle containing the given ObjC object, with memory management
  * taken care of.
@@ -113,200 +72,112 @@ Local<External> l8_make_wrapper(Local<Context> context, id wrappedObject)
 	return ext;
 }
 
-/**
- * Obtains the ObjC object withing the wrapper
- *
- * @return Objective-C object withing wrapper, or nil on failure
- */
-id l8_object_from_wrapper(Local<Value> wrapper)
-{
-	id object;
-
-	if(!wrapper->IsExternal())
-		return nil;
-
-	object = (__bridge id)External::Cast(*wrapper)->Value();
-
-	return object;
-}
-
-static NSMutableDictionary *l8_create_rename_map(Protocol *protocol, BOOL isInstanceMethod)
-{
-	NSMutableDictionary *renameMap;
-
-	renameMap = [NSMutableDictionary dictionary];
-
-	l8_for_each_method_in_protocol(protocol, NO, isInstanceMethod, ^(SEL sel, const char *types)
-	{
-		const char *selName;
-		NSString *rename, *selector, *name;
-		NSUInteger begin, length;
-		NSRange range;
-		BOOL hasNoArguments = NO;
-
-		selName = sel_getName(sel);
-		rename = @(selName);
-		range = [rename rangeOfString:@"__L8_EXPORT_AS__"];
-		if(range.location == NSNotFound)
-			return;
-
-		if(selName[strlen(selName)-1] != ':')
-			hasNoArguments = YES;
-
-		selector = [rename substringToIndex:range.location];
-		begin = range.location + range.length;
-		length = [rename length] - begin - (hasNoArguments?0:1);
-		name = [rename substringWithRange:(NSRange){ begin, length }];
-		renameMap[selector] = name;
-	});
-
-	return renameMap;
-}
-
 /*
- * Create the default setter name using only the property name.
- * A setter name is built with: 'set'<name with first letter capital>':'
+ * Create the function template calling a method.
  */
-static char *l8_make_setter_name(const char *name)
+static Local<FunctionTemplate> l8_method_function_template(Isolate *isolate, L8MethodDescriptor *descriptor)
 {
-	size_t length = strlen(name);
-	char *setterName = (char *)malloc(length + 5); // 'set' Name ':' 0
+	Local<FunctionTemplate> function;
+	FunctionCallback callback;
 
-	setterName[0] = 's';
-	setterName[1] = 'e';
-	setterName[2] = 't';
-	setterName[3] = toupper(*name);
+	// Use a specialized trampoline for common signatures
+	callback = l8_trampoline_for_descriptor(descriptor);
+	if(callback == NULL)
+		callback = ObjCMethodCall;
 
-	memcpy(setterName + 4, name + 1, length - 1);
-
-	setterName[length + 3] = ':';
-	setterName[length + 4] = 0;
-
-	return setterName;
-}
-
-bool l8_is_method_initializer(SEL sel)
-{
-	char *selStr;
-
-	selStr = (char *)sel_getName(sel);
-
-	while(*selStr == '_')
-		++selStr;
-
-	if(*selStr == '\0')
-		return false;
-
-	if(strncmp(selStr, "init", 4) != 0)
-		return false;
-	selStr += 4;
-
-	if(*selStr == '\0' || isupper(*selStr) || *selStr == ':')
-		return true;
-
-	return false;
-}
+	function = FunctionTemplate::New(isolate);
+	function->SetCallHandler(callback, External::New(isolate, descriptor));
 
-/**
- * Get whether the given method should not be copied
- * to the JavaScript object.
- */
-bool l8_should_skip_method_when_copying(SEL sel)
-{
-	return l8_is_method_initializer(sel);
+	return function;
 }
 
 /*
- * Install the ObjC methods from the protocol in the JS prototype.
- * If isInstanceMethod is YES, only instance methods will be installed.
- * If non-YES, it will install class-methods.
- * This method also stores type-information of accessor methods in the given
- * dictionary, if given.
+ * Install the described ObjC methods in the JS template.
+ * If isInstanceMethod is YES, the methods are instance methods.
+ * If non-YES, they are class-methods, which are always sent to the class.
+ * When lazyClass is given, instance methods are only recorded in it, and
+ * installed by the resolver of the class when accessed.
  */
 void l8_copy_method_to_object(L8WrapperMap *wrapperMap,
-						 Protocol *protocol,
+						 Class cls,
+						 const std::vector<L8ExportedMethod>& methods,
 						 BOOL isInstanceMethod,
 						 Local<Template> theTemplate,
-						 NSMutableDictionary *accessorMethods = nil)
+						 L8LazyClass *lazyClass = NULL)
 {
 	Isolate *isolate = wrapperMap.context.virtualMachine.V8Isolate;
-	NSMutableDictionary *renameMap = l8_create_rename_map(protocol, isInstanceMethod);
-
-	l8_for_each_method_in_protocol(protocol, YES, isInstanceMethod, ^(SEL sel, const char *types) {
-		const char *selName;
-		NSString *rawName;
-		const char *extraTypes;
-
-		if(l8_should_skip_method_when_copying(sel))
-			return;
 
-		selName = sel_getName(sel);
-		rawName = @(selName);
+	for(size_t i = 0; i < methods.size(); ++i) {
+		const L8ExportedMethod& exported = methods[i];
+		L8MethodDescriptor *descriptor;
 
-		extraTypes = _protocol_getMethodTypeEncoding(protocol, sel, YES, isInstanceMethod);
+		// Described and installed on first access
+		if(lazyClass) {
+			L8LazyMethod& method = lazyClass->methods[exported.name];
 
-		if(accessorMethods[rawName]) {
-			accessorMethods[rawName] = [L8Value valueWithV8Value:String::NewFromUtf8(isolate,extraTypes)
-													   inContext:wrapperMap.context];
-		} else {
-			NSString *propertyName;
-			Local<String> v8Name;
-			Local<FunctionTemplate> function;
-			Local<Array> extraData;
-
-			propertyName = renameMap[rawName];
-			if(propertyName == nil)
-				propertyName = l8_selector_to_property_name(selName,isInstanceMethod);
-
-			v8Name = [propertyName V8StringInIsolate:isolate];
+			method.selector = exported.selector;
+			method.types = exported.types;
+			method.descriptor = NULL;
+			continue;
+		}
 
-			function = FunctionTemplate::New(isolate);
+		descriptor = [wrapperMap methodDescriptorForSelector:exported.selector
+													   types:exported.types
+											   isClassMethod:!isInstanceMethod];
 
-			extraData = Array::New(isolate);
-			extraData->Set(0, String::NewFromUtf8(isolate, selName));
-			extraData->Set(1, String::NewFromUtf8(isolate, extraTypes));
-			extraData->Set(2, v8::Boolean::New(isolate,!isInstanceMethod));
-			function->SetCallHandler(ObjCMethodCall,extraData);
+		// Class methods are always sent to this class
+		if(!isInstanceMethod)
+			descriptor->boundClass = cls;
 
-			theTemplate->Set(v8Name, function);
-		}
-	});
+		theTemplate->Set(String::NewFromUtf8(isolate, exported.name.c_str()),
+						 l8_method_function_template(isolate, descriptor));
+	}
 }
 
+#ifdef L8_DIRECT_IVAR_ACCESS
 /*
- * Find useful attributes in the ObjC context about given property.
+ * Let the accessors of a property read and write the backing instance variable
+ * directly, when the property has one of a supported type. Only used for classes
+ * adopting L8DirectIvarAccess: the runtime does not tell whether the accessors
+ * are synthesized.
  */
-void l8_parse_property_attributes(objc_property_t property,
-								  char *&getterName,
-								  char *&setterName,
-								  bool &readonly,
-								  char *&type)
+static void l8_setup_direct_ivar_access(Class cls,
+										const char *propertyName,
+										L8PropertyDescriptor *descriptor)
 {
+	objc_property_t property;
+	objc_property_attribute_t *attributes;
 	unsigned int count;
-	objc_property_attribute_t *attributes = property_copyAttributeList(property, &count);
-	readonly = false;
+	Ivar ivar = NULL;
+	bool dynamic = false, weak = false, retained = false, copy = false, atomic = true;
+	const char *ivarType;
+	NSUInteger size;
+
+	property = class_getProperty(cls, propertyName);
+	if(property == NULL)
+		return;
+
+	attributes = property_copyAttributeList(property, &count);
 
 	for(unsigned int i = 0; i < count; ++i) {
 		switch(*(attributes[i].name)) {
-			case 'R': // read-only (readonly)
-				readonly = true;
+			case 'V': // V<name>, backing instance variable
+				ivar = class_getInstanceVariable(cls, attributes[i].value);
 				break;
-			case 'G': // G<name> custom getter name (eg GcustomGetter)
-				getterName = strdup(attributes[i].value);
+			case 'D': // dynamic (@dynamic)
+				dynamic = true;
 				break;
-			case 'S': // S<name> custom setter name (eg ScustomSetter:)
-				setterName = strdup(attributes[i].value);
+			case 'W': // weak reference (__weak / weak)
+				weak = true;
 				break;
-			case 'T': // T<encoding>, type
-				type = strdup(attributes[i].value);
+			case '&': // reference to last value assigned (retain)
+				retained = true;
 				break;
 			case 'C': // copy of last value assigned (copy)
-			case '&': // reference to last value assigned (retain)
+				copy = true;
+				break;
 			case 'N': // non-atomic (nonatomic)
-			case 'D': // dynamic (@dynamic)
-			case 'W': // weak reference (__weak / weak)
-			case 'P': // eligible for garbage collection
-			case 't': // t<encoding>, old style encoding
+				atomic = false;
 				break;
 			default:
 				break;
@@ -314,134 +185,235 @@ void l8_parse_property_attributes(objc_property_t property,
 	}
 
 	free(attributes);
+
+	if(ivar == NULL || dynamic || weak)
+		return;
+
+	// Unretained objects can not be set with objc_setProperty()
+	if(descriptor->type.type == '@' && !retained && !copy)
+		return;
+
+	if(strchr("cCsSiIlLqQfdB@", descriptor->type.type) == NULL)
+		return;
+
+	ivarType = ivar_getTypeEncoding(ivar);
+	if(ivarType == NULL || *ivarType != descriptor->type.type)
+		return;
+
+	NSGetSizeAndAlignment(ivarType, &size, NULL);
+
+	descriptor->ivarOffset = ivar_getOffset(ivar);
+	descriptor->ivarSize = size;
+	descriptor->atomic = atomic;
+	descriptor->copy = copy;
+	descriptor->getterImplementation = class_getMethodImplementation(cls, descriptor->getter->selector);
+	if(descriptor->setter)
+		descriptor->setterImplementation = class_getMethodImplementation(cls, descriptor->setter->selector);
+	descriptor->directAccess = true;
 }
+#endif
 
 /*
- * Because the list of methods from a class also contains getters (and setters) for properties,
- * we first need to find all properties and get their getter (and setter). Then, when copying
- * the methods, we should skip these as they are already covered by the property-accessors
+ * Install the instance methods and the property accessors of a protocol
+ * on the prototype.
  */
 void l8_copy_prototype_properties(L8WrapperMap *wrapperMap,
-							 Local<ObjectTemplate> prototypeTemplate,
-							 Local<ObjectTemplate> instanceTemplate,
-							 Protocol *protocol)
+							 Class cls,
+							 Local<FunctionTemplate> classTemplate,
+							 const L8ProtocolDescription *protocol,
+							 L8LazyClass *lazyClass = NULL)
 {
-	struct property_t {
-		const char *name;
-		char *getterName;
-		char *setterName;
-		char *type;
-		bool readonly;
-	};
 	Isolate *isolate = wrapperMap.context.virtualMachine.V8Isolate;
-	__block std::vector<property_t> propertyList;
-	NSMutableDictionary *accessorMethods;
-	L8Value *undefinedValue;
-
-	// This is not neccesary, just move them inside the block
-	// but it is to avoid analyzer errors: the allocation is in another loop
-	// than the freeing.
-	__block char *getterName = NULL;
-	__block char *setterName = NULL;
-	__block char *type = NULL;
-
-	// Dictionary containing all accessor methods so they can be skipped when copying methods
-	accessorMethods = [NSMutableDictionary dictionary];
-	undefinedValue = [L8Value valueWithUndefinedInContext:wrapperMap.context];
-
-	l8_for_each_property_in_protocol(protocol, ^(objc_property_t property) {
-		getterName = NULL;
-		setterName = NULL;
-		type = NULL;
-		bool readonly = false;
-		property_t prop;
-		const char *propertyName = property_getName(property);
-
-		// Get property information
-		l8_parse_property_attributes(property, getterName, setterName, readonly, type);
-
-		// Getter
-		if(getterName == NULL)
-			getterName = strdup((char *)propertyName);
-		accessorMethods[@(getterName)] = undefinedValue;
-
-		// Setter, if applicable
-		if(readonly == false) {
-			if(setterName == NULL)
-				setterName = l8_make_setter_name(propertyName);
-			accessorMethods[@(setterName)] = undefinedValue;
+	Local<ObjectTemplate> prototypeTemplate = classTemplate->PrototypeTemplate();
+	Local<AccessorSignature> signature = AccessorSignature::New(isolate, classTemplate);
+#ifdef L8_DIRECT_IVAR_ACCESS
+	bool directIvarAccess = class_conformsToProtocol(cls, objc_getProtocol("L8DirectIvarAccess"));
+#endif
+
+	// The accessors are not in the methods, they are covered by the properties
+	l8_copy_method_to_object(wrapperMap, cls, protocol->instanceMethods, YES, prototypeTemplate, lazyClass);
+
+	// Add accessors for each property with correct name, setter, getter and attributes
+	for(size_t i = 0; i < protocol->properties.size(); ++i) {
+		const L8ExportedProperty& property = protocol->properties[i];
+		L8MethodDescriptor *getter, *setter = NULL;
+		L8PropertyDescriptor *descriptor;
+		bool readonly = property.setter == NULL;
+
+		getter = [wrapperMap methodDescriptorForSelector:property.getter
+												   types:property.getterTypes.c_str()
+										   isClassMethod:NO];
+		if(!readonly) {
+			setter = [wrapperMap methodDescriptorForSelector:property.setter
+													   types:property.setterTypes.c_str()
+											   isClassMethod:NO];
 		}
 
-		prop = { propertyName, getterName, setterName, type, readonly };
-		propertyList.push_back(prop);
-	});
+		descriptor = [wrapperMap propertyDescriptorWithType:property.type.c_str()
+													 getter:getter
+													 setter:setter];
+
+#ifdef L8_DIRECT_IVAR_ACCESS
+		if(directIvarAccess)
+			l8_setup_direct_ivar_access(cls, property.name.c_str(), descriptor);
+#endif
+
+		// Installed once on the prototype, the signature makes sure the holder is a wrapper
+		prototypeTemplate->SetAccessor(String::NewFromUtf8(isolate, property.name.c_str()),
+									   ObjCAccessorGetter, ObjCAccessorSetter,
+									   External::New(isolate, descriptor),
+									   AccessControl::DEFAULT,
+									   readonly ? PropertyAttribute::ReadOnly : PropertyAttribute::None
+									   /*| PropertyAttribute::DontEnum*/,
+									   signature);
+	}
+}
 
-	// Copy the instance methods except the accessors, which we get info for
-	l8_copy_method_to_object(wrapperMap, protocol, YES, prototypeTemplate, accessorMethods);
+/**
+ * @brief A weak reference to the JavaScript wrapper of an Objective-C object.
+ *
+ * The entry owns the reference the wrapper holds on the object. When the
+ * wrapper is collected, the object is released and the entry removes
+ * itself from its cache.
+ */
+struct L8WrapperCacheEntry {
+	/// The wrapper, weak.
+	Persistent<Object> wrapper;
 
-	// Add accessors for each property with correct name, setter, getter and attributes
-	for(size_t i = 0; i < propertyList.size(); ++i) {
-		property_t& property = propertyList[i];
+	/// The cache holding this entry, or NULL when the wrapper map is gone.
+	std::map<void *,L8WrapperCacheEntry *> *cache;
 
-		Local<String> v8PropertyName = [@(property.name) V8StringInIsolate:isolate];
-		Local<Array> extraData = Array::New(isolate);
+	/// The wrapped object, retained. The key of the entry.
+	void *object;
 
-		extraData->Set(0, v8PropertyName);
-		extraData->Set(1, String::NewFromUtf8(isolate, property.type)); // value type
-		extraData->Set(2, String::NewFromUtf8(isolate, property.getterName)); // getter SEL
-		extraData->Set(3, [accessorMethods[@(property.getterName)] V8Value]); // getter Types
+	/// Native memory reported for the object, 0 when none.
+	int64_t externalMemory;
 
-		if(!property.readonly) {
-			extraData->Set(4, String::NewFromUtf8(isolate, property.setterName)); // setter SEL
-			extraData->Set(5, [accessorMethods[@(property.setterName)] V8Value]); // setter Types
-		}
+	/// Statistics of the virtual machine the memory is reported to.
+	L8ExternalMemoryStats *externalMemoryStats;
+};
+
+static void l8_wrapper_cache_weak_callback(const WeakCallbackData<Object, L8WrapperCacheEntry>& data)
+{
+	L8WrapperCacheEntry *entry = data.GetParameter();
+	std::map<void *,L8WrapperCacheEntry *>::iterator it;
+
+	if(entry->cache) {
+		it = entry->cache->find(entry->object);
+		if(it != entry->cache->end() && it->second == entry)
+			entry->cache->erase(it);
+	}
+
+	if(entry->externalMemory) {
+		data.GetIsolate()->AdjustAmountOfExternalAllocatedMemory(-entry->externalMemory);
+		entry->externalMemoryStats->bytes -= entry->externalMemory;
+		--entry->externalMemoryStats->objects;
+	}
+
+	L8ReleaseQueue::fromIsolate(data.GetIsolate())->push(entry->object);
+
+	entry->wrapper.Reset();
+	delete entry;
+}
+
+/**
+ * Named interceptor of the resolver of a lazy class.
+ *
+ * Installs a method on the prototype of the class when it is first
+ * accessed. Other names are left to the rest of the prototype chain.
+ */
+static void l8_lazy_method_getter(Local<String> property, const PropertyCallbackInfo<Value>& info)
+{
+	L8LazyClass *lazyClass = (L8LazyClass *)info.Data().As<External>()->Value();
+	Isolate *isolate = info.GetIsolate();
+	std::map<std::string,L8LazyMethod>::iterator it;
+	Local<Function> function;
+	Local<Value> prototype;
+	Local<Object> owner;
+
+	String::Utf8Value name(property);
+	it = lazyClass->methods.find(std::string(*name, name.length()));
+	if(it == lazyClass->methods.end())
+		return;
+
+	L8LazyMethod& method = it->second;
+	if(method.descriptor == NULL) {
+		method.descriptor = new L8MethodDescriptor(method.selector, method.types, false);
+		lazyClass->templates->methodDescriptors.push_back(method.descriptor);
+		method.function.Set(isolate, l8_method_function_template(isolate, method.descriptor));
+	}
 
-		free(property.type);
-		free(property.getterName);
-		free(property.setterName);
+	function = method.function.Get(isolate)->GetFunction();
+	info.GetReturnValue().Set(function);
 
-		instanceTemplate->SetAccessor(v8PropertyName, ObjCAccessorGetter,
-									  ObjCAccessorSetter, extraData,
-									  AccessControl::DEFAULT,
-									  property.readonly ? PropertyAttribute::ReadOnly : PropertyAttribute::None
-									  /*| PropertyAttribute::DontEnum*/);
+	// The prototype of the class is the object inheriting from this resolver
+	owner = info.This();
+	while(!(prototype = owner->GetPrototype())->StrictEquals(info.Holder())) {
+		if(!prototype->IsObject())
+			return;
+		owner = prototype.As<Object>();
 	}
+
+	owner->Set(property, function);
+	++lazyClass->templates->lazyMembersInstalled;
 }
 
-SEL l8_initializer_selector_for_class(Class cls)
+/**
+ * Named property enumerator of the resolver of a lazy class.
+ */
+static void l8_lazy_method_enumerator(const PropertyCallbackInfo<Array>& info)
 {
-	__block SEL selector;
-	__block BOOL found = NO;
-	__block BOOL foundMultiple = NO;
+	L8LazyClass *lazyClass = (L8LazyClass *)info.Data().As<External>()->Value();
+	Isolate *isolate = info.GetIsolate();
+	std::map<std::string,L8LazyMethod>::iterator it;
+	Local<Array> names;
+	uint32_t i = 0;
 
-	l8_for_each_protocol_implementing_protocol(cls, objc_getProtocol("L8Export"), ^(Protocol *protocol) {
+	names = Array::New(isolate, (int)lazyClass->methods.size());
+	for(it = lazyClass->methods.begin(); it != lazyClass->methods.end(); ++it)
+		names->Set(i++, String::NewFromUtf8(isolate, it->first.c_str()));
 
-		l8_for_each_method_in_protocol(protocol, YES, YES, ^(SEL sel, const char *encoding) {
-			if(!l8_is_method_initializer(sel))
-				return;
+	info.GetReturnValue().Set(names);
+}
 
-			if(sel_isEqual(sel, selector))
-				return;
+/**
+ * Put the resolver of a lazy class between the prototype of the
+ * class and the prototype of its superclass.
+ */
+static void l8_insert_lazy_resolver(Isolate *isolate, Local<Function> function, L8LazyClass *lazyClass)
+{
+	Local<Object> prototype, resolver;
 
-			if(found) {
-				NSLog(@"Found multiple init methods for class %@. Falling back to -[init].",NSStringFromClass(cls));
-				foundMultiple = YES;
-				return;
-			}
+	prototype = function->Get(String::NewFromUtf8(isolate, "prototype")).As<Object>();
 
-			found = YES;
-			selector = sel;
-		});
+	resolver = lazyClass->resolverTemplate.Get(isolate)->NewInstance();
+	resolver->SetPrototype(prototype->GetPrototype());
+	prototype->SetPrototype(resolver);
+}
 
-	});
+/**
+ * Get whether a class exports a class method with given JavaScript name.
+ *
+ * Installers cover the same protocols, see L8BindingInstallerForClass().
+ */
+static bool l8_class_exports_class_method(const L8ClassDescription *description, const char *name)
+{
+	for(size_t i = 0; i < description->protocols.size(); ++i) {
+		const std::vector<L8ExportedMethod>& methods = description->protocols[i]->classMethods;
+
+		for(size_t j = 0; j < methods.size(); ++j) {
+			if(methods[j].name == name)
+				return true;
+		}
+	}
 
-	if(found && !foundMultiple)
-		return selector;
-	return @selector(init);
+	return false;
 }
 
 @implementation L8WrapperMap {
-	std::map<std::string,Eternal<FunctionTemplate>> _classCache;
+	L8TemplateCache *_templates;
+	std::set<Class> _boundClassFunctions;
+	std::map<void *,L8WrapperCacheEntry *> _wrapperCache;
 	__weak L8Context *_context;
 }
 
@@ -450,17 +422,160 @@ SEL l8_initializer_selector_for_class(Class cls)
 	self = [super init];
 	if(self) {
 		_context = context;
+
+		// Owned by the virtual machine, which outlives its contexts
+		_templates = context.virtualMachine.templateCache;
 	}
 	return self;
 }
 
+- (void)dealloc
+{
+	// Wrappers that are still alive release their object when collected
+	for(std::map<void *,L8WrapperCacheEntry *>::iterator it = _wrapperCache.begin(); it != _wrapperCache.end(); ++it)
+		it->second->cache = NULL;
+}
+
+- (L8MethodDescriptor *)methodDescriptorForSelector:(SEL)selector
+											  types:(const char *)types
+									  isClassMethod:(BOOL)isClassMethod
+{
+	L8MethodDescriptor *descriptor;
+
+	descriptor = new L8MethodDescriptor(selector, types, isClassMethod);
+	_templates->methodDescriptors.push_back(descriptor);
+
+	return descriptor;
+}
+
+- (L8MethodDescriptor *)initializerDescriptorForClass:(Class)cls
+											 selector:(SEL)selector
+{
+	L8MethodDescriptor *descriptor;
+
+	descriptor = new L8MethodDescriptor(selector, [cls instanceMethodSignatureForSelector:selector]);
+	descriptor->boundClass = cls;
+
+	// Most constructed objects are of the class itself
+	descriptor->cachedClass = cls;
+	descriptor->cachedImplementation = class_getMethodImplementation(cls, selector);
+
+	_templates->methodDescriptors.push_back(descriptor);
+
+	return descriptor;
+}
+
+- (L8PropertyDescriptor *)propertyDescriptorWithType:(const char *)type
+											  getter:(L8MethodDescriptor *)getter
+											  setter:(L8MethodDescriptor *)setter
+{
+	L8PropertyDescriptor *descriptor;
+
+	descriptor = new L8PropertyDescriptor();
+	descriptor->type = l8_type_descriptor_from_encoding(type);
+	descriptor->getter = getter;
+	descriptor->setter = setter;
+	_templates->propertyDescriptors.push_back(descriptor);
+
+	return descriptor;
+}
+
+- (void)bindObject:(id)object toJSWrapper:(Local<Object>)wrapper
+{
+	L8VirtualMachine *virtualMachine = _context.virtualMachine;
+	L8WrapperCacheEntry *entry;
+	void *key;
+
+	key = (void *)CFBridgingRetain(object);
+
+	wrapper->SetAlignedPointerInInternalField(L8_WRAPPER_FIELD_OBJECT, key);
+	wrapper->SetAlignedPointerInInternalField(L8_WRAPPER_FIELD_TYPE, (void *)L8WrapperTypeInstance);
+
+	// A wrapper bound earlier is replaced, and removes nothing when collected
+	entry = new L8WrapperCacheEntry();
+	entry->wrapper.Reset(virtualMachine.V8Isolate, wrapper);
+	entry->wrapper.SetWeak(entry, l8_wrapper_cache_weak_callback);
+	entry->cache = &_wrapperCache;
+	entry->object = key;
+	entry->externalMemory = 0;
+	entry->externalMemoryStats = NULL;
+
+	// Let the collector know about the native memory the wrapper keeps alive
+	if([object conformsToProtocol:@protocol(L8ExternalMemory)]) {
+		entry->externalMemory = (int64_t)[(id<L8ExternalMemory>)object externalMemoryCost];
+		if(entry->externalMemory) {
+			entry->externalMemoryStats = virtualMachine.externalMemoryStats;
+			entry->externalMemoryStats->bytes += entry->externalMemory;
+			++entry->externalMemoryStats->objects;
+
+			virtualMachine.V8Isolate->AdjustAmountOfExternalAllocatedMemory(entry->externalMemory);
+		}
+	}
+
+	_wrapperCache[key] = entry;
+}
+
+/**
+ * Create the lazy method table and resolver template of a class.
+ */
+- (L8LazyClass *)lazyClassForClass:(Class)cls
+{
+	Isolate *isolate = _context.virtualMachine.V8Isolate;
+	Local<ObjectTemplate> resolverTemplate;
+	L8LazyClass *lazyClass;
+
+	lazyClass = new L8LazyClass();
+	lazyClass->templates = _templates;
+
+	resolverTemplate = ObjectTemplate::New(isolate);
+	resolverTemplate->SetNamedPropertyHandler(l8_lazy_method_getter, 0, 0, 0, l8_lazy_method_enumerator,
+											  External::New(isolate, lazyClass));
+	lazyClass->resolverTemplate.Set(isolate, resolverTemplate);
+
+	_templates->lazyClasses[cls] = lazyClass;
+
+	return lazyClass;
+}
+
+- (L8StructTemplate *)templateForStructLayout:(const L8StructLayout *)layout
+{
+	L8TemplateCache::StructTemplateMap::iterator it;
+	Isolate *isolate;
+	Local<ObjectTemplate> objectTemplate;
+	L8StructTemplate *structTemplate;
+
+	it = _templates->structTemplates.find(layout);
+	if(L8_LIKELY(it != _templates->structTemplates.end()))
+		return &it->second;
+
+	isolate = _context.virtualMachine.V8Isolate;
+	HandleScope localScope(isolate);
+
+	structTemplate = &_templates->structTemplates[layout];
+
+	// Objects start out with all fields, so they share one hidden class
+	objectTemplate = ObjectTemplate::New(isolate);
+	for(size_t i = 0; i < layout->fieldNames.size(); ++i) {
+		Local<String> name;
+		Eternal<String> eternalName;
+
+		name = String::NewFromUtf8(isolate, layout->fieldNames[i].c_str(), String::kInternalizedString);
+		objectTemplate->Set(name, Number::New(isolate, 0));
+
+		eternalName.Set(isolate, name);
+		structTemplate->fieldNames.push_back(eternalName);
+	}
+	structTemplate->objectTemplate.Set(isolate, objectTemplate);
+
+	return structTemplate;
+}
+
 - (void)cacheFunctionTemplate:(Local<FunctionTemplate>)funcTemplate
 					 forClass:(Class)cls
 {
-	std::string key(class_getName(cls));
 	Eternal<FunctionTemplate> myEternal;
 
-	assert(_classCache.find(key) == _classCache.end() && "Must only cache once");
+	assert(_templates->classTemplates.find(cls) == _templates->classTemplates.end() && "Must only cache once");
 
 	{
 		Isolate *isolate = _context.virtualMachine.V8Isolate;
@@ -469,35 +584,72 @@ SEL l8_initializer_selector_for_class(Class cls)
 		myEternal.Set(isolate, funcTemplate);
 	}
 
-	_classCache[key] = myEternal;
+	_templates->classTemplates[cls] = myEternal;
 }
 
 - (Local<FunctionTemplate>)getCachedFunctionTemplateForClass:(Class)cls
 {
-	std::string key(class_getName(cls));
-	std::map<std::string,Eternal<FunctionTemplate>>::iterator it;
+	L8TemplateCache::ClassTemplateMap::iterator it;
+
+	it = _templates->classTemplates.find(cls);
+	if(it != _templates->classTemplates.end())
+		return it->second.Get(_context.virtualMachine.V8Isolate);
+
+	return Local<FunctionTemplate>();
+}
+
+/**
+ * Get the function of a class in this context.
+ *
+ * The function of a template is created once per context. The first
+ * time, the class is bound to it and to the functions of its
+ * superclasses, so unwrapping needs no name lookup. Lazy classes get
+ * their resolver at that point.
+ */
+- (Local<Function>)functionForClass:(Class)cls template:(Local<FunctionTemplate>)classTemplate
+{
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
+	Local<Function> function;
+
+	function = classTemplate->GetFunction();
+
+	if(L8_UNLIKELY(_boundClassFunctions.find(cls) == _boundClassFunctions.end())) {
+		Local<String> classKey = L8PrivateKeys::classKey(isolate);
+		Class boundClass = cls;
+		Local<FunctionTemplate> boundTemplate = classTemplate;
+
+		while(!boundTemplate.IsEmpty() && _boundClassFunctions.insert(boundClass).second) {
+			Local<Function> boundFunction = boundTemplate->GetFunction();
+			L8TemplateCache::LazyClassMap::iterator lazy;
 
-	it = _classCache.find(key);
-	if(it != _classCache.end()) {
-		Eternal<FunctionTemplate> eternal;
+			boundFunction->SetHiddenValue(classKey, External::New(isolate, (__bridge void *)boundClass));
 
-		eternal = it->second;
-		return eternal.Get(isolate);
+			lazy = _templates->lazyClasses.find(boundClass);
+			if(lazy != _templates->lazyClasses.end())
+				l8_insert_lazy_resolver(isolate, boundFunction, lazy->second);
+
+			boundClass = class_getSuperclass(boundClass);
+			if(boundClass == Nil)
+				break;
+			boundTemplate = [self getCachedFunctionTemplateForClass:boundClass];
+		}
 	}
 
-	return Local<FunctionTemplate>();
+	return function;
 }
 
 - (Local<FunctionTemplate>)functionTemplateForClass:(Class)cls
 {
 	Isolate *isolate = _context.virtualMachine.V8Isolate;
 	Local<FunctionTemplate> classTemplate;
-	Local<ObjectTemplate> prototypeTemplate, instanceTemplate;
-	Local<Array> extraClassData;
+	Local<ObjectTemplate> instanceTemplate;
+	Local<FunctionTemplate> bulkConstructor;
+	L8MethodDescriptor *initializer;
 	NSString *className;
 	Class parentClass;
-	SEL initSelector;
+	const L8ClassDescription *description;
+	L8BindingInstaller installer;
+	L8LazyClass *lazyClass = NULL;
 
 	className = @(class_getName(cls));
 	classTemplate = FunctionTemplate::New(isolate);
@@ -513,25 +665,41 @@ SEL l8_initializer_selector_for_class(Class cls)
 			classTemplate->Inherit(parentTemplate);
 	}
 
-	initSelector = l8_initializer_selector_for_class(cls);
+	// Parsed once per process, shared with other virtual machines
+	description = l8_class_description(cls);
 
 	classTemplate->SetClassName([className V8StringInIsolate:isolate]);
 
-	prototypeTemplate = classTemplate->PrototypeTemplate();
 	instanceTemplate = classTemplate->InstanceTemplate();
-	instanceTemplate->SetInternalFieldCount(1);
+	instanceTemplate->SetInternalFieldCount(L8_WRAPPER_FIELD_COUNT);
+
+	// Prefer a generated binding over runtime reflection
+	installer = L8BindingInstallerForClass(cls);
+	if(installer)
+		installer(isolate, classTemplate);
+	else {
+		if(class_conformsToProtocol(cls, objc_getProtocol("L8LazyExport")))
+			lazyClass = [self lazyClassForClass:cls];
 
-	l8_for_each_protocol_implementing_protocol(cls, objc_getProtocol("L8Export"), ^(Protocol *protocol) {
-		l8_copy_prototype_properties(self, prototypeTemplate, instanceTemplate, protocol);
+		for(size_t i = 0; i < description->protocols.size(); ++i) {
+			const L8ProtocolDescription *protocol = description->protocols[i];
 
-		l8_copy_method_to_object(self, protocol, NO, classTemplate);
-	});
+			l8_copy_prototype_properties(self, cls, classTemplate, protocol, lazyClass);
+
+			l8_copy_method_to_object(self, cls, protocol->classMethods, NO, classTemplate);
+		}
+	}
 
 	// Set constructor callback
-	extraClassData = Array::New(isolate);
-	extraClassData->Set(0, String::NewFromUtf8(isolate, class_getName(cls))); // classname
-	extraClassData->Set(1, String::NewFromUtf8(isolate, sel_getName(initSelector))); // init selector
-	classTemplate->SetCallHandler(ObjCConstructor,extraClassData);
+	initializer = [self initializerDescriptorForClass:cls selector:description->initializer];
+	classTemplate->SetCallHandler(ObjCConstructor, External::New(isolate, initializer));
+
+	// Constructing many instances in one call, unless the class exports that name itself
+	if(!l8_class_exports_class_method(description, "constructMany")) {
+		bulkConstructor = FunctionTemplate::New(isolate);
+		bulkConstructor->SetCallHandler(ObjCBulkConstructor, External::New(isolate, initializer));
+		classTemplate->Set(String::NewFromUtf8(isolate, "constructMany"), bulkConstructor);
+	}
 
 	[self cacheFunctionTemplate:classTemplate
 					   forClass:cls];
@@ -542,6 +710,8 @@ SEL l8_initializer_selector_for_class(Class cls)
 /**
  * Create a wrapper-to-JavaScript for an Objective-C object
  *
+ * While the wrapper of an object is alive, it is returned again.
+ *
  * @return an L8Value containing the V8 handle wrapping the object
  */
 - (L8Value *)JSWrapperForObjCObject:(id)object
@@ -550,25 +720,40 @@ SEL l8_initializer_selector_for_class(Class cls)
 	EscapableHandleScope localScope(isolate);
 	Local<FunctionTemplate> classTemplate;
 	Local<Function> function;
+	std::map<void *,L8WrapperCacheEntry *>::iterator it;
 	Class cls;
+	bool isClass;
+
+	it = _wrapperCache.find((__bridge void *)object);
+	if(it != _wrapperCache.end()) {
+		++_wrapperCacheHits;
+
+		return [L8Value valueWithV8Value:localScope.Escape(Local<Object>::New(isolate, it->second->wrapper))
+							   inContext:_context];
+	}
 
+	// Templates are keyed by class: a class object uses its own template
 	cls = object_getClass(object);
+	isClass = class_isMetaClass(cls);
+	if(isClass)
+		cls = (Class)object;
 
 	classTemplate = [self getCachedFunctionTemplateForClass:cls];
 	if(classTemplate.IsEmpty())
 		classTemplate = [self functionTemplateForClass:cls];
 
 	// The class (constructor)
-	function = classTemplate->GetFunction();
+	function = [self functionForClass:cls template:classTemplate];
 
-	if(class_isMetaClass(object_getClass(object)))
+	if(isClass)
 		return [L8Value valueWithV8Value:localScope.Escape(function) inContext:_context];
 
 	_context.V8Context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_SKIP_CONSTRUCTING, True(isolate));
 	Local<Object> instance = function->NewInstance();
 	_context.V8Context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_SKIP_CONSTRUCTING, False(isolate));
 
-	instance->SetInternalField(0, l8_make_wrapper(_context.V8Context, object));
+	++_wrapperCacheMisses;
+	[self bindObject:object toJSWrapper:instance];
 
 	return [L8Value valueWithV8Value:localScope.Escape(instance) inContext:_context];
 }
@@ -622,32 +807,24 @@ id l8_unwrap_objc_object(Isolate *isolate, Local<Value> value)
 	if(!value->IsObject())
 		return nil;
 
-	object = value->ToObject();
-
-	if(object->InternalFieldCount() > 0) { // Instance
-		Local<Value> field;
+	object = value.As<Object>();
 
-		field = object->GetInternalField(0);
-		if(!field.IsEmpty() && field->IsExternal())
-			return (__bridge id)External::Cast(*field)->Value();
+	switch(l8_wrapper_type(object)) {
+		case L8WrapperTypeInstance:
+		case L8WrapperTypeArrayBuffer:
+			return (__bridge id)object->GetAlignedPointerFromInternalField(L8_WRAPPER_FIELD_OBJECT);
+		default:
+			break;
 	}
 
 	if(object->IsFunction()) { // Class (arguments.callee), or block
-		Local<Value> isBlockInfo;
-		bool isBlock;
-		NSString *name;
+		Local<Value> classInfo;
 
-		isBlockInfo = object->GetHiddenValue(String::NewFromUtf8(isolate, "isBlock"));
-		isBlock = !isBlockInfo.IsEmpty() && isBlockInfo->IsTrue();
+		classInfo = object->GetHiddenValue(L8PrivateKeys::classKey(isolate));
+		if(!classInfo.IsEmpty() && classInfo->IsExternal())
+			return (__bridge Class)classInfo.As<External>()->Value();
 
-		name = [NSString stringWithV8Value:object.As<Function>()->GetName() inIsolate:isolate];
-
-		if(isBlock) {
-			if(id target = l8_unwrap_block(isolate, object)) // Block
-				return target;
-			return nil;
-		}
-		return objc_getClass([name UTF8String]);
+		return l8_unwrap_block(isolate, object);
 	}
 
 	return nil;
@@ -658,36 +835,30 @@ Local<Function> l8_wrap_block(Local<Context> context, id object)
 	Isolate *isolate = context->GetIsolate();
 	EscapableHandleScope localScope(isolate);
 	Local<Function> function;
-	Local<FunctionTemplate> functionTemplate;
+	Local<External> wrapper;
 
-	functionTemplate = FunctionTemplate::New(isolate);
-	functionTemplate->SetCallHandler(ObjCBlockCall, l8_make_wrapper(context, object));
-	functionTemplate->PrototypeTemplate()->SetInternalFieldCount(1);
-	functionTemplate->InstanceTemplate()->SetInternalFieldCount(1);
+	// The block call descriptor is shared per signature, see objCBlockDescriptor().
+	// One wrapper is both the call data and the tag marking the function as block.
+	wrapper = l8_make_wrapper(context, object);
 
-	function = functionTemplate->GetFunction();
-	function->SetHiddenValue(String::NewFromUtf8(isolate, "isBlock"),
-							 v8::Boolean::New(isolate,true));
-	function->SetHiddenValue(String::NewFromUtf8(isolate, "cBlock"),
-							 l8_make_wrapper(context, object));
+	function = Function::New(isolate, ObjCBlockCall, wrapper);
+	function->SetHiddenValue(L8PrivateKeys::blockKey(isolate), wrapper);
 
 	return localScope.Escape(function);
 }
 
 id l8_unwrap_block(Isolate *isolate, Local<Object> object)
 {
-	Local<Value> cblock;
+	Local<Value> wrapper;
 	id blockObject;
 
 	assert(object->IsFunction());
 
-	if(object->GetHiddenValue(String::NewFromUtf8(isolate, "isBlock"))->IsTrue() == false)
+	wrapper = object->GetHiddenValue(L8PrivateKeys::blockKey(isolate));
+	if(wrapper.IsEmpty() || !wrapper->IsExternal())
 		return nil;
 
-	cblock = object->GetHiddenValue(String::NewFromUtf8(isolate, "cBlock"));
-	assert(cblock->IsExternal());
-
-	blockObject = (__bridge id)External::Cast(*cblock)->Value();
+	blockObject = (__bridge id)wrapper.As<External>()->Value();
 	assert([blockObject isKindOfClass:BlockClass()]);
 
 	return blockObject;
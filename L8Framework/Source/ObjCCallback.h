@@ -24,12 +24,31 @@
  */
 
 #include "v8.h"
+#import "L8VirtualMachine_Private.h"
+
+@class L8Context;
+struct L8MethodDescriptor;
+struct L8TypeDescriptor;
 
 /**
  * Callback for 'new <class>()'
  */
 void ObjCConstructor(const v8::FunctionCallbackInfo<v8::Value>& info);
 
+/**
+ * Callback for '<class>.constructMany([[args], [args], ...])'
+ *
+ * Constructs an object for every array of initializer arguments
+ * and returns an array with the wrapped objects. Throws a TypeError
+ * when This is not the class the function belongs to.
+ *
+ * When an initializer fails or throws, the exception is thrown and no
+ * array is returned. Objects constructed before are not rolled back:
+ * their initializers have run, and they are released when their
+ * unreachable wrappers are collected.
+ */
+void ObjCBulkConstructor(const v8::FunctionCallbackInfo<v8::Value>& info);
+
 /**
  * Callback for <class>() and <object>()
  */
@@ -75,4 +94,77 @@ void ObjCAccessorGetter(v8::Local<v8::String> property, const v8::PropertyCallba
 /**
  * Callback for stored objective-c values in Persisent<> that need freeing.
  */
-void ObjCWeakReferenceCallback(const v8::WeakCallbackData<v8::External, void>& data);
\ No newline at end of file
+void ObjCWeakReferenceCallback(const v8::WeakCallbackData<v8::External, void>& data);
+
+/**
+ * Get the receiver of a method call: the object wrapped
+ * by This, or the class for class methods.
+ */
+id objCMethodReceiver(const v8::FunctionCallbackInfo<v8::Value>& info, const L8MethodDescriptor *descriptor);
+
+/**
+ * Convert a JavaScript value to an object argument of given class.
+ *
+ * Undefined becomes nil, except for L8Value arguments which wrap it.
+ */
+id objCConvertObjectArgument(v8::Isolate *isolate, L8Context *context, Class objectClass, v8::Local<v8::Value> value);
+
+/**
+ * Convert a JavaScript value to an integer argument of given type.
+ *
+ * Applies the same type and range checks as the arguments of
+ * reflected calls.
+ *
+ * @param type The type of the argument, one of the integer types.
+ * @param result Receives the value. Unsigned values are stored as
+ * the same bits.
+ * @return Whether the value was converted. When not, an exception
+ * is thrown.
+ */
+bool objCConvertInteger(v8::Isolate *isolate, const L8TypeDescriptor& type, v8::Local<v8::Value> value, long long *result);
+
+/**
+ * Throw an exception from native code into JavaScript.
+ */
+v8::Local<v8::Value> handleInvocationException(v8::Isolate *isolate, L8Context *context, id exception);
+
+/**
+ * @brief Scope of a native callback.
+ *
+ * Makes the callback information available to +[L8Context currentThis]
+ * and friends. Only a pointer to the callback information is stored in
+ * the isolate: the values are created when one of these methods is called.
+ * Scopes nest, restoring the outer callback when destroyed.
+ */
+class L8CallbackScope {
+public:
+	inline explicit L8CallbackScope(const v8::FunctionCallbackInfo<v8::Value>& info)
+	: _isolate(info.GetIsolate()),
+	_previous(_isolate->GetData(L8_ISOLATE_DATA_CALLBACK_INFO))
+	{
+		_isolate->SetData(L8_ISOLATE_DATA_CALLBACK_INFO, (void *)&info);
+	}
+
+	inline ~L8CallbackScope()
+	{
+		_isolate->SetData(L8_ISOLATE_DATA_CALLBACK_INFO, _previous);
+	}
+
+	/**
+	 * Get the information of the innermost active callback.
+	 *
+	 * @param isolate The isolate.
+	 * @return The callback information, or NULL when not in a callback.
+	 */
+	static inline const v8::FunctionCallbackInfo<v8::Value> *currentInfo(v8::Isolate *isolate)
+	{
+		return (const v8::FunctionCallbackInfo<v8::Value> *)isolate->GetData(L8_ISOLATE_DATA_CALLBACK_INFO);
+	}
+
+private:
+	L8CallbackScope(const L8CallbackScope&);
+	L8CallbackScope& operator=(const L8CallbackScope&);
+
+	v8::Isolate *_isolate;
+	void *_previous;
+};
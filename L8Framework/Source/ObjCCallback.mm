@@ -36,300 +36,444 @@
 #import "ObjCRuntime+L8.h"
 #import "NSString+L8.h"
 #import "L8ArrayBuffer_Private.h"
+#import "L8MethodDescriptor.h"
+#import "L8FFIInvocation.h"
+#import "L8AutoreleasePool.h"
+#import "L8ReleaseQueue.h"
+#import "L8StructLayout.h"
+
+#include <map>
+#include <pthread.h>
 
 #include "v8.h"
 
 using namespace v8;
 
 /**
- * Creates a C string from given v8 value
+ * Storage for a single native argument or return value.
+ */
+typedef union {
+	long long s;
+	unsigned long long u;
+	float f;
+	double d;
+	bool b;
+	const char *string;
+	void *pointer;
+} L8ArgumentValue;
+
+/**
+ * A converted native argument.
+ *
+ * Objects (and the strings backing C strings) are kept alive by
+ * the argument until the call has been made.
+ */
+struct L8Argument {
+	L8ArgumentValue value;
+	__strong id object;
+};
+
+id objCConvertObjectArgument(Isolate *isolate,
+							 L8Context *context,
+							 Class objectClass,
+							 Local<Value> value)
+{
+	// An L8Value argument also wraps undefined
+	if(objectClass == [L8Value class])
+		return [L8Value valueWithV8Value:value inContext:context];
+	else if(value->IsUndefined())
+		return nil; // undefined <> nil
+	else if(objectClass == [NSString class])
+		return valueToString(isolate, context, value);
+	else if(objectClass == [NSNumber class])
+		return valueToNumber(isolate, context, value);
+	else if(objectClass == [NSDate class])
+		return valueToDate(isolate, context, value);
+	else if(objectClass == [NSArray class])
+		return valueToArray(isolate, context, value);
+	else if(objectClass == [NSDictionary class])
+		return valueToObject(isolate, context, value);
+	else if(objectClass == [L8ArrayBuffer class])
+		return valueToArrayBuffer(isolate, context, value);
+
+	return valueToObject(isolate, context, value);
+}
+
+/**
+ * Converts a JavaScript number to a signed integer argument.
+ *
+ * Throws a TypeError when the value is not a number, and a
+ * RangeError when it exceeds the maximum of the native type.
  *
- * @param value The V8 value
- * @return A string. Must be freed!
+ * @return Whether the value was converted.
  */
-const char *createStringFromV8Value(Local<Value> value)
+static inline bool objCConvertIntegerArgument(Isolate *isolate,
+											  Local<Value> value,
+											  long long maximum,
+											  const char *rangeError,
+											  long long *result)
 {
-	char *buffer;
-	Local<String> v8String;
+	if(L8_LIKELY(value->IsInt32()))
+		*result = value->Int32Value();
+	else {
+		if(!value->IsNumber()) {
+			isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+			return false;
+		}
 
-	if(!value->IsString())
-		return NULL;
-	v8String = value->ToString();
+		*result = value->IntegerValue();
+	}
 
-	buffer = (char *)malloc(v8String->Length()+1);
-	v8String->WriteUtf8(buffer);
+	if(*result > maximum) {
+		isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, rangeError)));
+		return false;
+	}
 
-	return buffer;
+	return true;
 }
 
-SEL selectorFromV8Value(Local<Value> value)
+/**
+ * Converts a JavaScript number to an unsigned integer argument.
+ *
+ * @see objCConvertIntegerArgument
+ */
+static inline bool objCConvertUnsignedArgument(Isolate *isolate,
+											   Local<Value> value,
+											   unsigned long long maximum,
+											   const char *rangeError,
+											   unsigned long long *result)
 {
-	const char *selName;
-	SEL selector;
+	if(L8_LIKELY(value->IsUint32()))
+		*result = value->Uint32Value();
+	else {
+		if(!value->IsNumber()) {
+			isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+			return false;
+		}
 
-	selName = createStringFromV8Value(value);
-	selector = sel_registerName(selName);
-	free((void *)selName);
+		*result = value->IntegerValue();
+	}
 
-	return selector;
+	if(*result > maximum) {
+		isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, rangeError)));
+		return false;
+	}
+
+	return true;
 }
 
+#ifdef L8_ENABLE_TYPED_ARRAYS
 /**
- * Finds first position of given needle in haystack
+ * Gets the size of the elements a pointer argument points to.
  *
- * @param haystack String to search in
- * @param needle String to find
- * @param count Maximum length string to search in haystack
- * @return position or -1 if not found
+ * @return The element size, or 0 when the pointee is not a scalar.
  */
-long strnpos(const char *haystack, const char *needle, long count)
+static inline size_t objCPointeeSize(char pointee)
 {
-	const char *p;
-
-	p = strnstr(haystack, needle, count);
-	if(p)
-		return p - haystack;
+	switch(pointee) {
+		case 'c': case 'C': case 'B': case 'v':
+			return 1;
+		case 's': case 'S':
+			return 2;
+		case 'i': case 'I': case 'l': case 'L': case 'f':
+			return 4;
+		case 'q': case 'Q': case 'd':
+			return 8;
+		default:
+			return 0;
+	}
+}
 
-	return -1;
+/**
+ * Checks whether a typed array can be passed for given pointee.
+ *
+ * Floating point pointees need an array of the same type. Integer
+ * pointees accept integer arrays of the same element size, so that
+ * signedness may differ. A DataView and void * accept anything.
+ */
+static bool objCTypedArrayMatchesPointee(Local<Value> view, char pointee)
+{
+	if(view->IsDataView() || pointee == 'v')
+		return true;
+
+	switch(pointee) {
+		case 'f':
+			return view->IsFloat32Array();
+		case 'd':
+			return view->IsFloat64Array();
+		case 'c': case 'C': case 'B':
+			return view->IsInt8Array() || view->IsUint8Array() || view->IsUint8ClampedArray();
+		case 's': case 'S':
+			return view->IsInt16Array() || view->IsUint16Array();
+		case 'i': case 'I': case 'l': case 'L':
+			return view->IsInt32Array() || view->IsUint32Array();
+		default: // There are no 64-bit integer arrays
+			return false;
+	}
 }
 
-void objCSetInvocationArgument(Isolate *isolate, L8Context *context, NSInvocation *invocation, int index, L8Value *val)
+/**
+ * Converts an ArrayBuffer or a view on one to a pointer argument.
+ *
+ * The backing store is passed as is: the native code reads and writes
+ * the memory of the script, and nothing is copied. The buffer is
+ * externalized by an L8ArrayBuffer, which is kept by the argument, and
+ * by the invocation when one is used, so that the memory stays alive
+ * during the call.
+ *
+ * Throws a TypeError when the value is not a buffer or the type of the
+ * view does not match the pointee, and a RangeError when the buffer
+ * does not hold a whole number of properly aligned elements.
+ *
+ * @return Whether the argument can be passed.
+ */
+static bool objCConvertPointerArgument(Isolate *isolate,
+									   const L8TypeDescriptor& type,
+									   Local<Value> value,
+									   L8Argument *argument)
 {
-	const char *type;
+	L8ArrayBuffer *arrayBuffer;
+	size_t elementSize, offset, length;
 
-	type = [invocation.methodSignature getArgumentTypeAtIndex:index];
+	argument->value.pointer = NULL;
 
-	switch(*type) {
-		case 'c': { // char (8)
-			long long value;
+	// null <> NULL
+	if(value->IsNull() || value->IsUndefined())
+		return true;
 
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+	// Such as id *, char ** and pointers to structs
+	elementSize = objCPointeeSize(type.pointee);
+	if(elementSize == 0) {
+		isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The type the native argument points to is not supported")));
+		return false;
+	}
 
-			value = [[val toNumber] longLongValue];
-			if(value > INT8_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (int8)")));
+	if(value->IsArrayBuffer()) {
+		arrayBuffer = [L8ArrayBuffer arrayBufferWithV8Value:value inIsolate:isolate];
+		offset = 0;
+		length = arrayBuffer.length;
+	} else if(value->IsArrayBufferView()) {
+		Local<ArrayBufferView> view = value.As<ArrayBufferView>();
 
-			[invocation setArgument:&value
-							atIndex:index];
-			break;
+		if(!objCTypedArrayMatchesPointee(value, type.pointee)) {
+			isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The type of the array does not match the native argument")));
+			return false;
 		}
-		case 'i': { // int
-			long long value;
 
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+		arrayBuffer = [L8ArrayBuffer arrayBufferWithV8Value:view->Buffer() inIsolate:isolate];
+		offset = view->ByteOffset();
+		length = view->ByteLength();
+	} else {
+		isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests an ArrayBuffer or typed array")));
+		return false;
+	}
 
-			value = [[val toNumber] longLongValue];
-			if(value > INT_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (int)")));
+	assert(offset + length <= arrayBuffer.length);
 
-			[invocation setArgument:&value
-							atIndex:index];
-			break;
-		}
-		case 's': { // short (16)
-			long long value;
+	if(length % elementSize != 0 || ((uintptr_t)arrayBuffer.buffer + offset) % elementSize != 0) {
+		isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "The buffer does not hold whole, aligned elements of the native argument")));
+		return false;
+	}
 
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+	argument->object = arrayBuffer;
+	argument->value.pointer = (uint8_t *)arrayBuffer.buffer + offset;
 
-			value = [[val toNumber] longLongValue];
-			if(value > INT16_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (int16)")));
+	return true;
+}
+#endif
 
-			[invocation setArgument:&value
-							atIndex:index];
+/**
+ * Converts a JavaScript value to a native argument.
+ *
+ * Scalars are read from the value directly. An L8Value is only
+ * created when the argument is of type L8Value.
+ *
+ * @param type The type of the native argument.
+ * @param value The value to convert.
+ * @param argument The argument storage to write into.
+ * @return Whether the argument can be passed. When not, an exception
+ * is thrown and the call must not be made.
+ */
+bool objCConvertArgument(Isolate *isolate,
+						 L8Context *context,
+						 const L8TypeDescriptor& type,
+						 Local<Value> value,
+						 L8Argument *argument)
+{
+	switch(type.type) {
+		case 'c': // char (8)
+			if(!objCConvertIntegerArgument(isolate, value, INT8_MAX, "Value exceeds native argument size (int8)", &argument->value.s))
+				return false;
 			break;
-		}
-		case 'l': { // long (32)
-			long long value;
-
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
-
-			value = [[val toNumber] longLongValue];
-			if(value > INT32_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (int32)")));
-
-			[invocation setArgument:&value
-							atIndex:index];
+		case 'i': // int
+			if(!objCConvertIntegerArgument(isolate, value, INT_MAX, "Value exceeds native argument size (int)", &argument->value.s))
+				return false;
 			break;
-		}
-		case 'q': { // long long (64)
-			long long value;
-
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
-
-			value = [[val toNumber] longLongValue];
-			if(value > INT64_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (int64)")));
-
-			[invocation setArgument:&value
-							atIndex:index];
+		case 's': // short (16)
+			if(!objCConvertIntegerArgument(isolate, value, INT16_MAX, "Value exceeds native argument size (int16)", &argument->value.s))
+				return false;
 			break;
-		}
-		case 'C': { // unsigned char (8)
-			unsigned long long value;
-
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
-
-			value = [[val toNumber] longLongValue];
-			if(value > UINT8_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (uint8)")));
-
-			[invocation setArgument:&value
-							atIndex:index];
+		case 'l': // long (32)
+			if(!objCConvertIntegerArgument(isolate, value, INT32_MAX, "Value exceeds native argument size (int32)", &argument->value.s))
+				return false;
 			break;
-		}
-		case 'I': { // unsigned int
-			unsigned long long value;
-
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
-
-			value = [[val toNumber] longLongValue];
-			if(value > UINT_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (uint)")));
-
-			[invocation setArgument:&value
-							atIndex:index];
+		case 'q': // long long (64)
+			if(!objCConvertIntegerArgument(isolate, value, INT64_MAX, "Value exceeds native argument size (int64)", &argument->value.s))
+				return false;
 			break;
-		}
-		case 'S': { // unsigned short (16)
-			unsigned long long value;
-
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
-
-			value = [[val toNumber] longLongValue];
-			if(value > UINT16_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (uint16)")));
-
-			[invocation setArgument:&value
-							atIndex:index];
+		case 'C': // unsigned char (8)
+			if(!objCConvertUnsignedArgument(isolate, value, UINT8_MAX, "Value exceeds native argument size (uint8)", &argument->value.u))
+				return false;
 			break;
-		}
-		case 'L': { // unsigned long (32)
-			unsigned long long value;
-
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
-
-			value = [[val toNumber] longLongValue];
-			if(value > UINT32_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (uint32)")));
-
-			[invocation setArgument:&value
-							atIndex:index];
+		case 'I': // unsigned int
+			if(!objCConvertUnsignedArgument(isolate, value, UINT_MAX, "Value exceeds native argument size (uint)", &argument->value.u))
+				return false;
 			break;
-		}
-		case 'Q': { // unsigned long long (64)
-			unsigned long long value;
-
-			if(![val isNumber])
-				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
-
-			value = [[val toNumber] longLongValue];
-			if(value > UINT64_MAX)
-				isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (uint64)")));
-
-			[invocation setArgument:&value
-							atIndex:index];
+		case 'S': // unsigned short (16)
+			if(!objCConvertUnsignedArgument(isolate, value, UINT16_MAX, "Value exceeds native argument size (uint16)", &argument->value.u))
+				return false;
+			break;
+		case 'L': // unsigned long (32)
+			if(!objCConvertUnsignedArgument(isolate, value, UINT32_MAX, "Value exceeds native argument size (uint32)", &argument->value.u))
+				return false;
+			break;
+		case 'Q': // unsigned long long (64)
+			if(!objCConvertUnsignedArgument(isolate, value, UINT64_MAX, "Value exceeds native argument size (uint64)", &argument->value.u))
+				return false;
 			break;
-		}
-
-		case 'f': { // float
-			float value;
 
-			if(![val isNumber])
+		case 'f': // float
+			if(!value->IsNumber()) {
 				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+				return false;
+			}
 
-			value = [[val toNumber] floatValue];
-			[invocation setArgument:&value
-							atIndex:index];
+			argument->value.f = value->NumberValue();
 			break;
-		}
-		case 'd': { // double
-			double value;
-			if(![val isNumber])
+		case 'd': // double
+			if(!value->IsNumber()) {
 				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+				return false;
+			}
 
-			value = [[val toNumber] doubleValue];
-			[invocation setArgument:&value
-							atIndex:index];
+			argument->value.d = value->NumberValue();
 			break;
-		}
-
-		case 'B': { // bool or _Bool
-			bool value;
 
-			value = [val toBool];
-			[invocation setArgument:&value
-							atIndex:index];
+		case 'B': // bool or _Bool
+			argument->value.b = value->BooleanValue();
 			break;
-		}
 		case 'v': // void
 			break;
 		case '*': { // char *
-			const char *value;
+			NSString *string;
 
-			if(![val isString])
+			if(!value->IsString()) {
 				isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a string")));
+				return false;
+			}
 
-			value = [[val toString] UTF8String];
-			[invocation setArgument:&value
-							atIndex:index];
+			string = [NSString stringWithV8Value:value inIsolate:isolate];
+			argument->object = string;
+			argument->value.string = [string UTF8String];
+			break;
 		}
 		case '@': { // object
-			id value;
-			Class objectClass = Nil;
-
-			// Try to find the classname of the object
-			if(*(type+1) == '"') {
-				long length;
-				char *className;
-
-				// Retrieve a Class object from the information
-				length = strnpos(type+2, "\"", strlen(type));
-				className = strndup(type+2, length);
-				objectClass = objc_getClass(className);
-				free((void *)className);
-			}
+			id object;
 
-			if([val isUndefined])
-				value = nil; // undefined <> nil
-			else if(objectClass == [L8Value class])
-				value = val;
-			else if(objectClass == [NSString class])
-				value = valueToString(isolate, context, val.V8Value);
-			else if(objectClass == [NSNumber class])
-				value = valueToNumber(isolate, context, val.V8Value);
-			else if(objectClass == [NSDate class])
-				value = valueToDate(isolate, context, val.V8Value);
-			else if(objectClass == [NSArray class])
-				value = valueToArray(isolate, context, val.V8Value);
-			else if(objectClass == [NSDictionary class])
-				value = valueToObject(isolate, context, val.V8Value);
-			else if(objectClass == [L8ArrayBuffer class])
-				value = valueToArrayBuffer(isolate, context, val.V8Value);
-			else
-				value = [val toObject];
+			object = objCConvertObjectArgument(isolate, context, type.objectClass, value);
 
-			[invocation setArgument:&value
-							atIndex:index];
+			argument->object = object;
+			argument->value.pointer = (__bridge void *)object;
 			break;
 		}
+#ifdef L8_ENABLE_TYPED_ARRAYS
+		case '^': // pointer, backed by an ArrayBuffer
+			return objCConvertPointerArgument(isolate, type, value, argument);
+#endif
 		case '#': // Class
 		case ':': // SEL
-		case '^': // pointer
 		case '?': // Unknown (also function pointers, eg blocks)
 		default:
 			assert(0 && "Type not implemented");
 			break;
 	}
+
+	return true;
+}
+
+bool objCConvertInteger(Isolate *isolate,
+						const L8TypeDescriptor& type,
+						Local<Value> value,
+						long long *result)
+{
+	L8Argument argument;
+
+	assert(strchr("cCsSiIlLqQ", type.type) != NULL && "Not an integer type");
+
+	// Integers do not need the context
+	if(!objCConvertArgument(isolate, nil, type, value, &argument))
+		return false;
+
+	// Unsigned values are stored in the same bits
+	*result = argument.value.s;
+
+	return true;
+}
+
+#ifdef L8_ENABLE_TYPED_ARRAYS
+static char objCInvocationBuffersKey;
+
+/**
+ * Keeps the buffer of a pointer argument alive as long as the invocation.
+ *
+ * The invocation only retains object arguments, and the argument holding
+ * the buffer is gone before the invocation is invoked.
+ */
+static void objCInvocationKeepBuffer(NSInvocation *invocation, id buffer)
+{
+	NSMutableArray *buffers;
+
+	buffers = objc_getAssociatedObject(invocation, &objCInvocationBuffersKey);
+	if(buffers == nil) {
+		buffers = [NSMutableArray arrayWithCapacity:1];
+		objc_setAssociatedObject(invocation, &objCInvocationBuffersKey, buffers, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	}
+
+	[buffers addObject:buffer];
+}
+#endif
+
+bool objCSetInvocationArgument(Isolate *isolate,
+							   L8Context *context,
+							   NSInvocation *invocation,
+							   int index,
+							   const L8TypeDescriptor& type,
+							   Local<Value> value)
+{
+	L8Argument argument;
+
+	// Structs are converted in place: they do not fit an L8Argument
+	if(type.type == '{' && type.structLayout != NULL) {
+		void *buffer = alloca(type.structLayout->size);
+
+		if(!l8_struct_from_value(isolate, context, type.structLayout, value, buffer))
+			return false;
+		[invocation setArgument:buffer atIndex:index];
+		return true;
+	}
+
+	if(!objCConvertArgument(isolate, context, type, value, &argument))
+		return false;
+
+#ifdef L8_ENABLE_TYPED_ARRAYS
+	if(type.type == '^' && argument.object != nil)
+		objCInvocationKeepBuffer(invocation, argument.object);
+#endif
+
+	if(type.type != 'v')
+		[invocation setArgument:&argument.value atIndex:index];
+
+	return true;
 }
 
 Local<Value> handleInvocationException(Isolate *isolate, L8Context *context, id exception)
@@ -357,247 +501,581 @@ Local<Value> handleInvocationException(Isolate *isolate, L8Context *context, id
 	return isolate->ThrowException(valueToThrow);
 }
 
-Local<Value> objCInvocation(Isolate *isolate,
-							L8Context *context,
-							NSInvocation *invocation,
-							const char *neededReturnType = NULL)
+/**
+ * Converts a native return value to a JavaScript value.
+ *
+ * @param returnType The type of the return value.
+ * @param buffer The buffer holding the return value.
+ * @param retLength The size of the return value.
+ * @return The JavaScript value.
+ */
+Local<Value> objCConvertReturnValue(Isolate *isolate,
+									L8Context *context,
+									const L8TypeDescriptor& returnType,
+									const void *buffer,
+									unsigned long retLength)
 {
-	unsigned long retLength;
-	const char *returnType;
-	L8Value *result;
-
-	@autoreleasepool {
-		@try {
-			[invocation invoke];
-		} @catch(id exception) {
-			return handleInvocationException(isolate,context,exception);
-		}
-	}
-
-	retLength = invocation.methodSignature.methodReturnLength;
-	returnType = invocation.methodSignature.methodReturnType;
-
 	_Static_assert(sizeof(uint8_t) == sizeof(unsigned char), "Sizeof uint32_t and unsigned char");
 	_Static_assert(sizeof(uint16_t) == sizeof(unsigned short), "Sizeof uint32_t and unsigned short");
 	_Static_assert(sizeof(uint32_t) == sizeof(unsigned int), "Sizeof uint32_t and unsigned int");
 	_Static_assert(sizeof(uint64_t) == sizeof(unsigned long), "Sizeof uint64_t and unsigned long");
 	_Static_assert(sizeof(uint64_t) == sizeof(unsigned long long), "Sizeof uint64_t and unsigned long long");
 
-	switch(*returnType) {
+	switch(returnType.type) {
 		case 'c': { // char (8)
 			int8_t value;
 			assert(retLength == sizeof(int8_t));
 
-			[invocation getReturnValue:&value];
-			result = [L8Value valueWithInt32:value inContext:context];
+			memcpy(&value, buffer, sizeof(value));
+			return Int32::New(isolate, value);
 		}
-			break;
 		case 's': { // short (16)
 			int16_t value;
 			assert(retLength == sizeof(int16_t));
 
-			[invocation getReturnValue:&value];
-			result = [L8Value valueWithInt32:value inContext:context];
+			memcpy(&value, buffer, sizeof(value));
+			return Int32::New(isolate, value);
 		}
-			break;
 		case 'i': { // int (32)
 			int32_t value;
 			assert(retLength == sizeof(int32_t));
 
-			[invocation getReturnValue:&value];
-			result = [L8Value valueWithInt32:value inContext:context];
+			memcpy(&value, buffer, sizeof(value));
+			return Int32::New(isolate, value);
 		}
-			break;
 		case 'l': // long (64)
 		case 'q': { // long long (64)
 			int64_t value;
 			assert(retLength == sizeof(int64_t));
 
-			[invocation getReturnValue:&value];
+			memcpy(&value, buffer, sizeof(value));
 			if(value <= INT32_MAX)
-				result = [L8Value valueWithInt32:(int32_t)value inContext:context];
+				return Int32::New(isolate, (int32_t)value);
 			else
-				result = [L8Value valueWithDouble:value inContext:context];
+				return Number::New(isolate, value);
 		}
-			break;
 		case 'C': { // unsigned char (8)
 			uint8_t value;
 			assert(retLength == sizeof(uint8_t));
 
-			[invocation getReturnValue:&value];
-			result = [L8Value valueWithUInt32:value inContext:context];
+			memcpy(&value, buffer, sizeof(value));
+			return Uint32::New(isolate, value);
 		}
-			break;
 		case 'S': { // unsigned short (16)
 			uint16_t value;
 			assert(retLength == sizeof(uint16_t));
 
-			[invocation getReturnValue:&value];
-			result = [L8Value valueWithUInt32:value inContext:context];
+			memcpy(&value, buffer, sizeof(value));
+			return Uint32::New(isolate, value);
 		}
-			break;
 		case 'I': { // unsigned int (32)
 			uint32_t value;
 			assert(retLength == sizeof(uint32_t));
 
-			[invocation getReturnValue:&value];
-			result = [L8Value valueWithUInt32:value inContext:context];
+			memcpy(&value, buffer, sizeof(value));
+			return Uint32::New(isolate, value);
 		}
-			break;
 		case 'L': // unsigned long (64)
 		case 'Q': { // unsigned long long (64)
 			uint64_t value;
 			assert(retLength == sizeof(uint64_t));
 
-			[invocation getReturnValue:&value];
+			memcpy(&value, buffer, sizeof(value));
 			if(value <= UINT32_MAX)
-				result = [L8Value valueWithUInt32:(uint32_t)value inContext:context];
+				return Uint32::New(isolate, (uint32_t)value);
 			else
-				result = [L8Value valueWithDouble:value inContext:context];
+				return Number::New(isolate, value);
 		}
-			break;
 		case 'f': { // float
 			float value;
 			assert(retLength == sizeof(float));
-			[invocation getReturnValue:&value];
-			result = [L8Value valueWithDouble:value inContext:context];
+			memcpy(&value, buffer, sizeof(value));
+			return Number::New(isolate, value);
 		}
-			break;
 		case 'd': { // double
 			double value;
 			assert(retLength == sizeof(double));
-			[invocation getReturnValue:&value];
-			result = [L8Value valueWithDouble:value inContext:context];
+			memcpy(&value, buffer, sizeof(value));
+			return Number::New(isolate, value);
 		}
-			break;
 
 		case 'B': { // bool or _Bool
 			bool value;
 			assert(retLength <= sizeof(bool));
 
-			[invocation getReturnValue:&value];
-			result = [L8Value valueWithBool:value inContext:context];
+			memcpy(&value, buffer, sizeof(value));
+			return v8::Boolean::New(isolate, value);
 		}
-			break;
 		case 'v': // void
 			return Undefined(isolate);
 		case '*': { // char *
 			char *string;
 			assert(retLength == sizeof(char *));
 
-			[invocation getReturnValue:&string];
+			memcpy(&string, buffer, sizeof(string));
 			return objectToValue(isolate, context,@(string));
 		}
 		case '@': { // object
 			id __unsafe_unretained object;
 			assert(retLength == sizeof(id));
 
-			[invocation getReturnValue:&object];
+			memcpy(&object, buffer, sizeof(object));
+
+			// A thrown value is an exception without unwinding
+			if(returnType.objectClass == [L8Value class] && [(L8Value *)object isThrown])
+				return isolate->ThrowException([(L8Value *)object V8Value]);
+
 			return objectToValue(isolate, context, object);
 		}
 		case '#': { // Class
 			Class __unsafe_unretained classObject;
 
-			[invocation getReturnValue:&classObject];
+			memcpy(&classObject, buffer, sizeof(classObject));
 
 			// TODO find name of class if available
 
 			return objectToValue(isolate, context, classObject);
 		}
-			break;
 		case ':': // SEL
 			return Undefined(isolate);
 		case '{': // struct, {name=type}
-			// TODO implement
+			if(returnType.structLayout != NULL) {
+				assert(retLength == returnType.structLayout->size);
+				return l8_struct_to_value(isolate, context, returnType.structLayout, buffer);
+			}
+
+			// No layout: a field type is not supported
+			NSLog(@"Returntype: '%c' without struct layout, len %lu",returnType.type,retLength);
+			assert(0 && "A struct return type is not implemented");
+			break;
 		case '[': // array, [type]
 		case '(': // union, (name=type)
 		case '^': // pointer, ^type
 		case '?': // Unknown
 		case 'b': // bitfield, bnum
 		default:
-			NSLog(@"Returntype: '%s', len %lu",returnType,retLength);
+			NSLog(@"Returntype: '%c', len %lu",returnType.type,retLength);
 			assert(0 && "A return type is not implemented");
 	}
 
-	return result.V8Value;
+	return Undefined(isolate);
+}
+
+/**
+ * Throws an error returned through a NSError ** argument.
+ */
+static Local<Value> objCThrowError(Isolate *isolate, L8Context *context, NSError *error)
+{
+	return isolate->ThrowException(errorToValue(isolate, context, error));
+}
+
+/**
+ * Checks whether a return value signals failure.
+ *
+ * As in Cocoa, the error of a NSError ** argument is only valid when the
+ * method returns NO, nil, NULL or 0, or returns nothing. A method may set
+ * the error and still succeed.
+ *
+ * @param buffer The return value.
+ * @param retLength The length of the return value.
+ */
+static bool objCReturnValueSignalsFailure(const L8TypeDescriptor& returnType,
+										  const void *buffer,
+										  unsigned long retLength)
+{
+	const uint8_t *bytes = (const uint8_t *)buffer;
+
+	// Structs and unions have no failure value
+	if(returnType.type == '{' || returnType.type == '(')
+		return false;
+
+	for(unsigned long i = 0; i < retLength; ++i) {
+		if(bytes[i] != 0)
+			return false;
+	}
+
+	return true;
+}
+
+Local<Value> objCInvocation(Isolate *isolate,
+							L8Context *context,
+							NSInvocation *invocation,
+							const L8MethodDescriptor& descriptor)
+{
+	const L8TypeDescriptor& returnType = descriptor.returnType;
+	unsigned long retLength;
+	void *buffer;
+	NSError * __autoreleasing error = nil;
+	NSError * __autoreleasing *errorPointer = &error;
+
+	if(descriptor.errorArgumentIndex)
+		[invocation setArgument:&errorPointer atIndex:descriptor.errorArgumentIndex];
+
+	{
+		L8AutoreleaseScope autoreleaseScope(isolate);
+
+		@try {
+			[invocation invoke];
+		} @catch(id exception) {
+			return handleInvocationException(isolate,context,exception);
+		}
+
+		retLength = invocation.methodSignature.methodReturnLength;
+		buffer = alloca(MAX(retLength, sizeof(L8ArgumentValue)));
+
+		if(retLength > 0)
+			[invocation getReturnValue:buffer];
+
+		// The error is autoreleased: convert before draining
+		if(error != nil && objCReturnValueSignalsFailure(returnType, buffer, retLength))
+			return objCThrowError(isolate, context, error);
+	}
+
+	return objCConvertReturnValue(isolate, context, returnType, buffer, retLength);
 }
 
-inline void objCSetInvocationArguments(Isolate *isolate,
+inline bool objCSetInvocationArguments(Isolate *isolate,
 									   L8Context *context,
 									   NSInvocation *invocation,
+									   const L8MethodDescriptor& descriptor,
 									   const FunctionCallbackInfo<Value>& info,
 									   int offset)
 {
-	for(unsigned int i = offset; i < invocation.methodSignature.numberOfArguments; ++i) {
-		L8Value *argument;
+	// Retain first, so objects and strings set below outlive their conversion
+	[invocation retainArguments];
+
+	// Arguments that are requested but not supplied are Undefined
+	for(unsigned int i = offset; i < descriptor.argumentsEnd(); ++i) {
+		if(!objCSetInvocationArgument(isolate, context, invocation, i, descriptor.arguments[i], info[i-offset]))
+			return false;
+	}
+
+	return true;
+}
+
+#ifdef L8_USE_LIBFFI
+/**
+ * Calls a native method or block using libffi.
+ *
+ * The JavaScript arguments are converted straight into a stack buffer
+ * and the implementation is called directly. Objective-C exceptions
+ * are not caught.
+ *
+ * @param descriptor The prepared descriptor. When it has no selector,
+ * the target is a block.
+ * @param target The receiver or block.
+ * @param argv The JavaScript arguments.
+ * @param argc The number of JavaScript arguments.
+ * @param returnValue Buffer receiving the return value.
+ * @param error Storage for the error of a trailing NSError ** argument.
+ * @return Whether the call was made. When not, an argument could not be
+ * converted and an exception is thrown.
+ */
+bool objCFFICall(Isolate *isolate,
+				 L8Context *context,
+				 const L8MethodDescriptor& descriptor,
+				 id target,
+				 const Local<Value> *argv,
+				 int argc,
+				 L8ArgumentValue *returnValue,
+				 NSError * __autoreleasing *error)
+{
+	L8Argument arguments[L8_FFI_MAX_ARGUMENTS];
+	void *argumentValues[L8_FFI_MAX_ARGUMENTS];
+	void *function, *rawTarget;
+	SEL selector;
+	size_t offset;
+
+	// Messaging nil results in zero
+	if(target == nil) {
+		memset(returnValue, 0, sizeof(L8ArgumentValue));
+		return true;
+	}
+
+	rawTarget = (__bridge void *)target;
+	argumentValues[0] = &rawTarget;
+
+	if(descriptor.selector) {
+		selector = descriptor.selector;
+		argumentValues[1] = &selector;
+		function = (void *)class_getMethodImplementation(object_getClass(target), selector);
+		offset = 2;
+	} else {
+		function = l8_block_invoke_function(target);
+		offset = 1;
+	}
+
+	for(size_t i = offset; i < descriptor.argumentsEnd(); ++i) {
+		Local<Value> argument;
 
 		// Arguments that are requested but not supplied: give Undefined
-		if(i - offset < (unsigned int)info.Length())
-			argument = [L8Value valueWithV8Value:info[i-offset] inContext:context];
+		if(i - offset < (size_t)argc)
+			argument = argv[i-offset];
 		else
-			argument = [L8Value valueWithUndefinedInContext:context];
+			argument = Undefined(isolate);
 
-		objCSetInvocationArgument(isolate, context, invocation, i, argument);
+		if(!objCConvertArgument(isolate, context, descriptor.arguments[i], argument, &arguments[i]))
+			return false;
+		argumentValues[i] = &arguments[i].value;
 	}
+
+	if(descriptor.errorArgumentIndex)
+		argumentValues[descriptor.errorArgumentIndex] = &error;
+
+	l8_ffi_call(&descriptor, function, argumentValues, returnValue);
+
+	return true;
 }
 
-inline void objCSetContextEmbedderData(const FunctionCallbackInfo<Value>& info)
+/**
+ * Calls a native method or block using libffi, and converts the result.
+ *
+ * Exceptions are translated like objCInvocation does.
+ */
+Local<Value> objCFFIInvocation(Isolate *isolate,
+							   L8Context *context,
+							   const L8MethodDescriptor& descriptor,
+							   id target,
+							   const Local<Value> *argv,
+							   int argc)
 {
-	Local<Context> context;
+	L8ArgumentValue returnValue;
+	NSError * __autoreleasing error = nil;
+
+	{
+		L8AutoreleaseScope autoreleaseScope(isolate);
+
+		@try {
+			if(!objCFFICall(isolate, context, descriptor, target, argv, argc, &returnValue, &error))
+				return Undefined(isolate);
+		} @catch(id exception) {
+			return handleInvocationException(isolate,context,exception);
+		}
 
-	context = info.GetIsolate()->GetCurrentContext();
+		if(error != nil && objCReturnValueSignalsFailure(descriptor.returnType, &returnValue,
+														 descriptor.signature.methodReturnLength))
+			return objCThrowError(isolate, context, error);
 
-	context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_CB_THIS, info.This());
-	context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_CB_CALLEE, info.Callee());
-	Local<Array> argList = Array::New(info.GetIsolate(), info.Length());
-	for(int i = 0; i < info.Length(); ++i)
-		argList->Set(i, info[i]);
-	context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_CB_ARGS, argList);
+		// Nothing retains the returned object: convert before draining
+		return objCConvertReturnValue(isolate, context, descriptor.returnType,
+									  &returnValue, descriptor.signature.methodReturnLength);
+	}
 }
 
-inline void objCClearContextEmbedderData(Isolate *isolate)
+/**
+ * Collects the arguments of a callback for a libffi call.
+ *
+ * Only L8_FFI_MAX_ARGUMENTS can be passed to a libffi call, so
+ * the remainder is ignored.
+ *
+ * @return The number of collected arguments.
+ */
+inline int objCFFICollectArguments(const FunctionCallbackInfo<Value>& info, Local<Value> *argv)
+{
+	int argc;
+
+	argc = MIN(info.Length(), L8_FFI_MAX_ARGUMENTS);
+	for(int i = 0; i < argc; ++i)
+		argv[i] = info[i];
+
+	return argc;
+}
+#endif
+
+/**
+ * Gets the method descriptor for the signature of a block.
+ *
+ * Block signatures are static strings, so descriptors are shared by
+ * all blocks with the same signature pointer.
+ *
+ * The map is never modified once published: a miss copies it under the lock
+ * and publishes the copy, so hits do not lock. Replaced maps are kept alive
+ * because other threads may still be reading them; there is only one per
+ * distinct block signature.
+ *
+ * @param block The block.
+ * @return The method descriptor.
+ */
+L8MethodDescriptor *objCBlockDescriptor(id block)
 {
-	Local<Context> context;
+	typedef std::map<const char *, L8MethodDescriptor *> DescriptorMap;
+	static DescriptorMap *volatile descriptors = new DescriptorMap();
+	static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	DescriptorMap::const_iterator it;
+	DescriptorMap *current, *copy;
+	L8MethodDescriptor *descriptor;
+	const char *signature;
+
+	signature = _Block_signature((__bridge void *)block);
+
+	current = descriptors;
+	it = current->find(signature);
+	if(L8_LIKELY(it != current->end()))
+		return it->second;
+
+	pthread_mutex_lock(&lock);
 
-	context = isolate->GetCurrentContext();
+	// Another thread might have added it since
+	current = descriptors;
+	it = current->find(signature);
+	if(it != current->end())
+		descriptor = it->second;
+	else {
+		descriptor = new L8MethodDescriptor(NULL, [NSMethodSignature signatureWithObjCTypes:signature]);
 
-	context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_CB_THIS, Null(isolate));
-	context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_CB_CALLEE, Null(isolate));
-	context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_CB_ARGS, Null(isolate));
+		copy = new DescriptorMap(*current);
+		(*copy)[signature] = descriptor;
+
+		// The copy and the descriptor must be complete before they are visible
+		__sync_synchronize();
+		descriptors = copy;
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	return descriptor;
+}
+
+id objCMethodReceiver(const FunctionCallbackInfo<Value>& info, const L8MethodDescriptor *descriptor)
+{
+	// Class methods are bound to their class when installed
+	if(descriptor->isClassMethod)
+		return descriptor->boundClass;
+
+	return l8_object_from_wrapper(info.This());
+}
+
+/**
+ * The arguments of one object in a bulk construction: a JavaScript array.
+ */
+struct L8ArrayArguments {
+	Local<Array> array;
+
+	inline int Length() const
+	{
+		return array->Length();
+	}
+
+	inline Local<Value> operator[](int i) const
+	{
+		return array->Get(i);
+	}
+};
+
+/**
+ * Calls the initializer of a newly allocated object.
+ *
+ * Like NSInvocation, the call does not alter retain counts: the caller
+ * balances the object consumed and the object returned by the initializer.
+ * Objective-C exceptions are not caught.
+ *
+ * @param arguments The FunctionCallbackInfo or L8ArrayArguments holding the arguments.
+ * @param error Storage for the error of a trailing NSError ** argument.
+ * @param called Set to false when an argument could not be converted and
+ * the initializer was not called. An exception is then thrown.
+ * @return The initialized object, or NULL.
+ */
+template<typename Arguments>
+static void *objCCallInitializer(Isolate *isolate,
+								 L8Context *context,
+								 L8MethodDescriptor *descriptor,
+								 id object,
+								 const Arguments& arguments,
+								 NSError * __autoreleasing *error,
+								 bool *called)
+{
+	typedef void *(*l8_initializer_t)(void *, SEL);
+	NSInvocation *invocation;
+	void *result;
+
+	*called = true;
+
+	// Initializers without arguments are called directly
+	if(descriptor->arguments.size() == 2) {
+		l8_initializer_t initializer = (l8_initializer_t)descriptor->implementationForReceiver(object);
+		return initializer((__bridge void *)object, descriptor->selector);
+	}
+
+#ifdef L8_USE_LIBFFI
+	if(l8_ffi_prepare(descriptor)) {
+		Local<Value> argv[L8_FFI_MAX_ARGUMENTS];
+		L8ArgumentValue returnValue;
+		int argc;
+
+		argc = MIN(arguments.Length(), L8_FFI_MAX_ARGUMENTS);
+		for(int i = 0; i < argc; ++i)
+			argv[i] = arguments[i];
+
+		*called = objCFFICall(isolate, context, *descriptor, object, argv, argc, &returnValue, error);
+		return *called ? returnValue.pointer : NULL;
+	}
+#endif
+
+	invocation = [NSInvocation invocationWithMethodSignature:descriptor->signature];
+	invocation.selector = descriptor->selector;
+	invocation.target = object;
+	[invocation retainArguments];
+
+	for(unsigned int i = 2; i < descriptor->argumentsEnd(); ++i) {
+		Local<Value> argument;
+
+		// Arguments that are requested but not supplied: give Undefined
+		if(i - 2 < (unsigned int)arguments.Length())
+			argument = arguments[i - 2];
+		else
+			argument = Undefined(isolate);
+
+		if(!objCSetInvocationArgument(isolate, context, invocation, i, descriptor->arguments[i], argument)) {
+			*called = false;
+			return NULL;
+		}
+	}
+
+	if(descriptor->errorArgumentIndex)
+		[invocation setArgument:&error atIndex:descriptor->errorArgumentIndex];
+
+	[invocation invoke];
+	[invocation getReturnValue:&result];
+
+	return result;
+}
+
+/**
+ * Throws the error for an initializer that returned nil.
+ *
+ * @param error The error set by the initializer, or nil.
+ */
+static Local<Value> objCThrowInitializerReturnedNil(Isolate *isolate, L8Context *context, NSError *error)
+{
+	Local<String> message;
+
+	if(error != nil)
+		return objCThrowError(isolate, context, error);
+
+	message = String::NewFromUtf8(isolate, "Failed to create native object: initializer returned <nil>.");
+
+	return isolate->ThrowException(Exception::ReferenceError(message));
 }
 
 void ObjCConstructor(const FunctionCallbackInfo<Value>& info)
 {
-	const char *className, *selName;
-	Class cls;
-	SEL selector = nil;
+	L8MethodDescriptor *descriptor;
 	id object;
 	id __unsafe_unretained resultObject;
 	Isolate *isolate = info.GetIsolate();
 	HandleScope localScope(isolate);
 	L8Context *context;
 
-	NSMethodSignature *methodSignature;
-	NSInvocation *invocation;
-
 	// In one situation we should no nothing:
 	// When just created the class for an existing object
 	Local<Value> skipConstruct = isolate->GetCurrentContext()->GetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_SKIP_CONSTRUCTING);
 	if(!skipConstruct.IsEmpty() && skipConstruct->IsTrue())
 		return;
 
-	Local<Array> extraClassData;
-	extraClassData = info.Data().As<Array>();
-
-	className = createStringFromV8Value(extraClassData->Get(0));
-	cls = objc_getClass(className);
-	free((void *)className); className = NULL;
-
-	selName = createStringFromV8Value(extraClassData->Get(1));
-	selector = sel_registerName(selName);
-	free((void *)selName); selName = NULL;
+	descriptor = (L8MethodDescriptor *)info.Data().As<External>()->Value();
+	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
 
-	object = [cls alloc];
+	object = [descriptor->boundClass alloc];
 
 	// The allocated object is now already released by
 	// the context because the init returned nil. We can't
@@ -606,60 +1084,134 @@ void ObjCConstructor(const FunctionCallbackInfo<Value>& info)
 	// to circumvent the ARC problem.
 	CFRetain((void *)object);
 
-	methodSignature = [object methodSignatureForSelector:selector];
-	invocation = [NSInvocation invocationWithMethodSignature:methodSignature];
-	invocation.selector = selector;
-
-	// Set target
-	invocation.target = object;
-
-	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
-
-	objCSetInvocationArguments(isolate, context, invocation, info, 2);
-	objCSetContextEmbedderData(info);
+	L8CallbackScope callbackScope(info);
 
 	// and initialize
-	@autoreleasepool {
+	{
+		L8AutoreleaseScope autoreleaseScope(isolate);
+		NSError * __autoreleasing error = nil;
+		bool called;
+
 		@try {
-			[invocation invoke];
-			[invocation getReturnValue:&resultObject];
+			resultObject = (__bridge id)objCCallInitializer(isolate, context, descriptor, object, info, &error, &called);
+
+			// The initializer was not called: the object is still ours
+			if(!called) {
+				CFRelease((void *)object);
+				return;
+			}
 
 			// init returned nil.
 			if(resultObject == nil) {
-				Local<String> error;
-				Local<Value> exception;
-
-				error = String::NewFromUtf8(isolate, "Failed to create native object: initializer returned <nil>.");
-				exception = Exception::ReferenceError(error);
-				info.GetReturnValue().Set(isolate->ThrowException(exception));
-
+				info.GetReturnValue().Set(objCThrowInitializerReturnedNil(isolate, context, error));
 				return;
 			} else
 				CFRelease((void *)object);
 
 			// Set our self to, ourself
-			info.This()->SetInternalField(0, l8_make_wrapper(context.V8Context, resultObject));
+			[context.wrapperMap bindObject:resultObject toJSWrapper:info.This()];
 
 		} @catch (id exception) {
 			info.GetReturnValue().Set(handleInvocationException(isolate,context,exception));
 			return;
-		} @finally {
-			objCClearContextEmbedderData(isolate);
 		}
 	}
 
 	info.GetReturnValue().Set(info.This());
 }
 
+void ObjCBulkConstructor(const FunctionCallbackInfo<Value>& info)
+{
+	L8MethodDescriptor *descriptor;
+	Isolate *isolate = info.GetIsolate();
+	HandleScope localScope(isolate);
+	Local<Context> v8context;
+	Local<FunctionTemplate> classTemplate;
+	Local<Function> function;
+	Local<Array> tuples, instances;
+	L8Context *context;
+	uint32_t count;
+
+	descriptor = (L8MethodDescriptor *)info.Data().As<External>()->Value();
+	v8context = isolate->GetCurrentContext();
+	context = [L8Context contextWithV8Context:v8context];
+
+	// Only the class itself: the instances are bound to the template of This
+	classTemplate = [context.wrapperMap getCachedFunctionTemplateForClass:descriptor->boundClass];
+	if(classTemplate.IsEmpty() || !info.This()->StrictEquals(classTemplate->GetFunction()) || !info[0]->IsArray()) {
+		info.GetReturnValue().Set(isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate,
+			"constructMany must be called on its class with an array of argument arrays"))));
+		return;
+	}
+
+	function = info.This().As<Function>();
+	tuples = info[0].As<Array>();
+	count = tuples->Length();
+	instances = Array::New(isolate, count);
+
+	L8CallbackScope callbackScope(info);
+
+	for(uint32_t i = 0; i < count; ++i) {
+		HandleScope iterationScope(isolate);
+		L8ArrayArguments arguments;
+		Local<Value> tuple;
+		Local<Object> instance;
+		id object;
+		id __unsafe_unretained resultObject;
+
+		tuple = tuples->Get(i);
+		if(!tuple->IsArray()) {
+			info.GetReturnValue().Set(isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate,
+				"constructMany requires an array of arguments for each object"))));
+			return;
+		}
+		arguments.array = tuple.As<Array>();
+
+		// See ObjCConstructor for the retain balancing
+		object = [descriptor->boundClass alloc];
+		CFRetain((void *)object);
+
+		{
+			L8AutoreleaseScope autoreleaseScope(isolate);
+			NSError * __autoreleasing error = nil;
+			bool called;
+
+			@try {
+				resultObject = (__bridge id)objCCallInitializer(isolate, context, descriptor, object, arguments, &error, &called);
+			} @catch (id exception) {
+				info.GetReturnValue().Set(handleInvocationException(isolate,context,exception));
+				return;
+			}
+
+			if(!called) {
+				CFRelease((void *)object);
+				return;
+			}
+
+			if(resultObject == nil) {
+				info.GetReturnValue().Set(objCThrowInitializerReturnedNil(isolate, context, error));
+				return;
+			}
+		}
+		CFRelease((void *)object);
+
+		// Create the wrapper without calling the constructor again
+		v8context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_SKIP_CONSTRUCTING, True(isolate));
+		instance = function->NewInstance();
+		v8context->SetEmbedderData(L8_CONTEXT_EMBEDDER_DATA_SKIP_CONSTRUCTING, False(isolate));
+
+		[context.wrapperMap bindObject:resultObject toJSWrapper:instance];
+		instances->Set(i, instance);
+	}
+
+	info.GetReturnValue().Set(instances);
+}
+
 void ObjCMethodCall(const FunctionCallbackInfo<Value>& info)
 {
-	SEL selector;
 	id object;
-	const char *types;
-	bool isClassMethod = false;
-	NSMethodSignature *methodSignature;
+	L8MethodDescriptor *descriptor;
 	NSInvocation *invocation;
-	Local<Array> extraData;
 	Local<Value> retVal;
 	Isolate *isolate;
 	L8Context *context;
@@ -669,48 +1221,41 @@ void ObjCMethodCall(const FunctionCallbackInfo<Value>& info)
 
 	isolate = info.GetIsolate();
 
-	extraData = info.Data().As<Array>();
-	selector = selectorFromV8Value(extraData->Get(0));
-	types = createStringFromV8Value(extraData->Get(1));
-	isClassMethod = extraData->Get(2)->ToBoolean()->Value();
-
-	methodSignature = [NSMethodSignature signatureWithObjCTypes:types];
-	invocation = [NSInvocation invocationWithMethodSignature:methodSignature];
-	free((void *)types);
-
-	// Class methods must use the function (This) name to find the class meta object
-	if(isClassMethod) {
-		Local<Function> function = info.This().As<Function>();
-		const char *classStr = createStringFromV8Value(function->GetName());
-		object = objc_getClass(classStr);
-		free((void *)classStr);
-	} else
-		object = l8_object_from_wrapper(info.This()->GetInternalField(0));
-
-	invocation.selector = selector;
-	invocation.target = object;
+	descriptor = (L8MethodDescriptor *)info.Data().As<External>()->Value();
+	object = objCMethodReceiver(info, descriptor);
 
 	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
 
-	// Set the arguments
-	objCSetInvocationArguments(isolate, context, invocation, info, 2);
-	objCSetContextEmbedderData(info);
+	L8CallbackScope callbackScope(info);
 
-	// Retain those
-	[invocation retainArguments];
+#ifdef L8_USE_LIBFFI
+	if(l8_ffi_prepare(descriptor)) {
+		Local<Value> argv[L8_FFI_MAX_ARGUMENTS];
+		int argc;
 
-	retVal = objCInvocation(isolate, context, invocation);
+		argc = objCFFICollectArguments(info, argv);
+		retVal = objCFFIInvocation(isolate, context, *descriptor, object, argv, argc);
+	} else
+#endif
+	{
+		invocation = [NSInvocation invocationWithMethodSignature:descriptor->signature];
+		invocation.selector = descriptor->selector;
+		invocation.target = object;
+
+		// Set the arguments
+		if(!objCSetInvocationArguments(isolate, context, invocation, *descriptor, info, 2))
+			return;
 
-	objCClearContextEmbedderData(isolate);
+		retVal = objCInvocation(isolate, context, invocation, *descriptor);
+	}
 
 	info.GetReturnValue().Set(retVal);
 }
 
 void ObjCBlockCall(const FunctionCallbackInfo<Value>& info)
 {
-	NSMethodSignature *methodSignature;
+	L8MethodDescriptor *descriptor;
 	NSInvocation *invocation;
-	const char *signature;
 	Isolate *isolate;
 	id block;
 	L8Context *context;
@@ -718,27 +1263,36 @@ void ObjCBlockCall(const FunctionCallbackInfo<Value>& info)
 	isolate = info.GetIsolate();
 
 	block = (__bridge id)info.Data().As<External>()->Value();
-	signature = _Block_signature((__bridge void *)block);
-	methodSignature = [NSMethodSignature signatureWithObjCTypes:signature];
-	invocation = [NSInvocation invocationWithMethodSignature:methodSignature];
-	invocation.target = block;
+	descriptor = objCBlockDescriptor(block);
 
 	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
 
-	// Set arguments (+1)
-	objCSetInvocationArguments(isolate, context, invocation, info, 1);
+#ifdef L8_USE_LIBFFI
+	if(l8_ffi_prepare(descriptor)) {
+		Local<Value> argv[L8_FFI_MAX_ARGUMENTS];
+		int argc;
 
-	[invocation retainArguments];
+		argc = objCFFICollectArguments(info, argv);
+		info.GetReturnValue().Set(objCFFIInvocation(isolate, context, *descriptor, block, argv, argc));
+		return;
+	}
+#endif
 
-	@autoreleasepool {
-		@try {
-			Local<Value> retVal;
+	invocation = [NSInvocation invocationWithMethodSignature:descriptor->signature];
+	invocation.target = block;
 
-			retVal = objCInvocation(isolate, context, invocation);
-			info.GetReturnValue().Set(retVal);
-		} @catch (id exception) {
-			info.GetReturnValue().Set(handleInvocationException(isolate, context, exception));
-		}
+	// Set arguments (+1)
+	if(!objCSetInvocationArguments(isolate, context, invocation, *descriptor, info, 1))
+		return;
+
+	// objCInvocation scopes the autorelease pool
+	@try {
+		Local<Value> retVal;
+
+		retVal = objCInvocation(isolate, context, invocation, *descriptor);
+		info.GetReturnValue().Set(retVal);
+	} @catch (id exception) {
+		info.GetReturnValue().Set(handleInvocationException(isolate, context, exception));
 	}
 }
 
@@ -747,8 +1301,9 @@ void ObjCNamedPropertySetter(Local<String> property, Local<Value> value, const P
 	id object;
 	L8Value *setValue;
 	L8Context *context;
+	L8AutoreleaseScope autoreleaseScope(info.GetIsolate());
 
-	object = l8_object_from_wrapper(info.This()->GetInternalField(0));
+	object = l8_object_from_wrapper(info.This());
 	context = [L8Context contextWithV8Context:info.GetIsolate()->GetCurrentContext()];
 
 	setValue = [L8Value valueWithV8Value:value inContext:context];
@@ -763,8 +1318,9 @@ void ObjCNamedPropertyGetter(Local<String> property, const PropertyCallbackInfo<
 	id object, value;
 	L8Context *context;
 	Isolate *isolate = info.GetIsolate();
+	L8AutoreleaseScope autoreleaseScope(isolate);
 
-	object = l8_object_from_wrapper(info.This()->GetInternalField(0));
+	object = l8_object_from_wrapper(info.This());
 	value = [object objectForKeyedSubscript:[NSString stringWithV8String:property]];
 
 	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
@@ -778,8 +1334,9 @@ void ObjCIndexedPropertySetter(uint32_t index, Local<Value> value, const Propert
 	id object;
 	L8Value *setValue;
 	L8Context *context;
+	L8AutoreleaseScope autoreleaseScope(info.GetIsolate());
 
-	object = l8_object_from_wrapper(info.This()->GetInternalField(0));
+	object = l8_object_from_wrapper(info.This());
 
 	context = [L8Context contextWithV8Context:info.GetIsolate()->GetCurrentContext()];
 
@@ -794,8 +1351,9 @@ void ObjCIndexedPropertyGetter(uint32_t index, const PropertyCallbackInfo<Value>
 	Isolate *isolate = info.GetIsolate();
 	id object, value;
 	L8Context *context;
+	L8AutoreleaseScope autoreleaseScope(isolate);
 
-	object = l8_object_from_wrapper(info.This()->GetInternalField(0));
+	object = l8_object_from_wrapper(info.This());
 	value = [object objectAtIndexedSubscript:index];
 
 	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
@@ -804,89 +1362,163 @@ void ObjCIndexedPropertyGetter(uint32_t index, const PropertyCallbackInfo<Value>
 		info.GetReturnValue().Set(objectToValue(isolate, context, value));
 }
 
+#ifdef L8_DIRECT_IVAR_ACCESS
+/**
+ * Reads the instance variable backing a synthesized property.
+ *
+ * Objects are read with objc_getProperty(), which is what the
+ * synthesized getter does, to keep the atomic semantics.
+ */
+static Local<Value> objCReadInstanceVariable(Isolate *isolate,
+											 L8Context *context,
+											 const L8PropertyDescriptor& descriptor,
+											 id object)
+{
+	const char *ivar;
+
+	if(descriptor.type.type == '@') {
+		id value = objc_getProperty(object, descriptor.getter->selector,
+									descriptor.ivarOffset, descriptor.atomic);
+		return objectToValue(isolate, context, value);
+	}
+
+	ivar = (const char *)(__bridge void *)object + descriptor.ivarOffset;
+
+	return objCConvertReturnValue(isolate, context, descriptor.type, ivar, descriptor.ivarSize);
+}
+
+/**
+ * Writes the instance variable backing a synthesized property.
+ *
+ * Objects are written with objc_setProperty(), which retains or
+ * copies the new value and releases the old one. Nothing is written
+ * when the value can not be converted: the setter is not there to
+ * reject it.
+ */
+static void objCWriteInstanceVariable(Isolate *isolate,
+									  L8Context *context,
+									  const L8PropertyDescriptor& descriptor,
+									  id object,
+									  Local<Value> value)
+{
+	L8Argument argument;
+	char *ivar;
+
+	{
+		TryCatch tryCatch;
+
+		// Converting objects can run JavaScript, which may throw as well
+		if(!objCConvertArgument(isolate, context, descriptor.type, value, &argument) || tryCatch.HasCaught()) {
+			tryCatch.ReThrow();
+			return;
+		}
+	}
+
+	if(descriptor.type.type == '@') {
+		objc_setProperty(object, descriptor.setter->selector, descriptor.ivarOffset,
+						 argument.object, descriptor.atomic, descriptor.copy);
+		return;
+	}
+
+	// Same layout as the value NSInvocation copies from the argument
+	ivar = (char *)(__bridge void *)object + descriptor.ivarOffset;
+	memcpy(ivar, &argument.value, descriptor.ivarSize);
+}
+#endif
+
 void ObjCAccessorSetter(Local<String> property, Local<Value> value, const PropertyCallbackInfo<void> &info)
 {
-	SEL selector;
 	id object;
-	NSMethodSignature *methodSignature;
+	L8PropertyDescriptor *descriptor;
 	NSInvocation *invocation;
-	const char *types;//, *valueType;
-	Local<Array> extraData;
 	Local<Value> retVal;
-	L8Value *newValue;
 	Isolate *isolate;
 	L8Context *context;
 
 	isolate = info.GetIsolate();
-	object = l8_object_from_wrapper(info.This()->GetInternalField(0));
-	extraData = info.Data().As<Array>();
+	object = l8_object_from_wrapper(info.Holder());
+	descriptor = (L8PropertyDescriptor *)info.Data().As<External>()->Value();
 	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
 
-	// 0 = name, 1 = value type, 2 = getter SEL, 3 = getter types, 4 = setter SEL, 5 = setter types
-	selector = selectorFromV8Value(extraData->Get(4));
-	types = createStringFromV8Value(extraData->Get(5));
+	assert(descriptor->setter != NULL && "Setter called on a readonly property");
 
-	methodSignature = [NSMethodSignature signatureWithObjCTypes:types];
-	free((void *)types);
+#ifdef L8_DIRECT_IVAR_ACCESS
+	if(descriptor->directAccess && object != nil
+	   && descriptor->setter->implementationForReceiver(object) == descriptor->setterImplementation) {
+		objCWriteInstanceVariable(isolate, context, *descriptor, object, value);
+		return;
+	}
+#endif
 
-	invocation = [NSInvocation invocationWithMethodSignature:methodSignature];
-	invocation.selector = selector;
+#ifdef L8_USE_LIBFFI
+	if(l8_ffi_prepare(descriptor->setter)) {
+		info.GetReturnValue().Set(objCFFIInvocation(isolate, context, *descriptor->setter, object, &value, 1));
+		return;
+	}
+#endif
+
+	invocation = [NSInvocation invocationWithMethodSignature:descriptor->setter->signature];
+	invocation.selector = descriptor->setter->selector;
 	invocation.target = object;
+	[invocation retainArguments];
 
-	assert(invocation.methodSignature.numberOfArguments == 3
+	assert(descriptor->setter->arguments.size() == 3
 		   && "More parameters than arguments: not a setter called?");
 
-	newValue = [L8Value valueWithV8Value:value inContext:context];
-	objCSetInvocationArgument(isolate, context, invocation, 2, newValue);
+	if(!objCSetInvocationArgument(isolate, context, invocation, 2, descriptor->setter->arguments[2], value))
+		return;
 
-	retVal = objCInvocation(isolate, context, invocation);
+	retVal = objCInvocation(isolate, context, invocation, *descriptor->setter);
 
 	info.GetReturnValue().Set(retVal);
 }
 
 void ObjCAccessorGetter(Local<String> property, const PropertyCallbackInfo<Value> &info)
 {
-	SEL selector;
 	id object;
-	NSMethodSignature *methodSignature;
+	L8PropertyDescriptor *descriptor;
 	NSInvocation *invocation;
-	const char *types, *returnType;
-	Local<Array> extraData;
 	Local<Value> retVal;
 	Isolate *isolate;
 	L8Context *context;
 
 	isolate = info.GetIsolate();
-	object = l8_object_from_wrapper(info.This()->GetInternalField(0));
-	extraData = info.Data().As<Array>();
+	object = l8_object_from_wrapper(info.Holder());
+	descriptor = (L8PropertyDescriptor *)info.Data().As<External>()->Value();
 	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
 
-	// 0 = name, 1 = value type, 2 = getter SEL, 3 = getter types, 4 = setter SEL, 5 = setter types
-	returnType = createStringFromV8Value(extraData->Get(1));
-	selector = selectorFromV8Value(extraData->Get(2));
-	types = createStringFromV8Value(extraData->Get(3));
+#ifdef L8_DIRECT_IVAR_ACCESS
+	if(descriptor->directAccess && object != nil
+	   && descriptor->getter->implementationForReceiver(object) == descriptor->getterImplementation) {
+		info.GetReturnValue().Set(objCReadInstanceVariable(isolate, context, *descriptor, object));
+		return;
+	}
+#endif
 
-	methodSignature = [NSMethodSignature signatureWithObjCTypes:types];
-	free((void *)types);
+#ifdef L8_USE_LIBFFI
+	if(l8_ffi_prepare(descriptor->getter)) {
+		info.GetReturnValue().Set(objCFFIInvocation(isolate, context, *descriptor->getter, object, NULL, 0));
+		return;
+	}
+#endif
 
-	invocation = [NSInvocation invocationWithMethodSignature:methodSignature];
-	invocation.selector = selector;
+	invocation = [NSInvocation invocationWithMethodSignature:descriptor->getter->signature];
+	invocation.selector = descriptor->getter->selector;
 	invocation.target = object;
 
-	assert(invocation.methodSignature.numberOfArguments == 2
+	assert(descriptor->getter->arguments.size() == 2
 		   && "More parameters than arguments: not a getter called?");
 
-	retVal = objCInvocation(isolate, context, invocation, returnType);
-	free((void *)returnType);
+	retVal = objCInvocation(isolate, context, invocation, *descriptor->getter);
 
 	info.GetReturnValue().Set(retVal);
 }
 
 /**
  * Called when an ObjC object stored in v8 will be released by v8.
- * This function causes an ObjC release on the object.
+ * This function queues an ObjC release on the object, done outside of the collection.
  */
 void ObjCWeakReferenceCallback(const WeakCallbackData<External, void>& data)
 {
-	CFRelease(data.GetValue()->Value());
+	L8ReleaseQueue::fromIsolate(data.GetIsolate())->push(data.GetValue()->Value());
 }
\ No newline at end of file
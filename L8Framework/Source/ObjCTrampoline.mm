@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "ObjCTrampoline.h"
+#import "ObjCCallback.h"
+#import "L8MethodDescriptor.h"
+#import "L8Context_Private.h"
+#import "L8Value_Private.h"
+#import "L8AutoreleasePool.h"
+
+#include <limits.h>
+
+using namespace v8;
+
+/// Maximum number of arguments (excluding self and _cmd) of a trampoline.
+#define L8_TRAMPOLINE_MAX_ARGUMENTS 2
+
+#pragma mark Conversion
+
+/**
+ * Converts a JavaScript value to a native argument of type T.
+ */
+template<typename T> struct L8ArgumentConverter;
+
+template<> struct L8ArgumentConverter<id> {
+	static inline id convert(Isolate *isolate, L8Context *context,
+							 const L8TypeDescriptor& type, Local<Value> value)
+	{
+		return objCConvertObjectArgument(isolate, context, type.objectClass, value);
+	}
+};
+
+template<> struct L8ArgumentConverter<double> {
+	static inline double convert(Isolate *isolate, L8Context *context,
+								 const L8TypeDescriptor& type, Local<Value> value)
+	{
+		if(!value->IsNumber())
+			isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+
+		return value->NumberValue();
+	}
+};
+
+template<> struct L8ArgumentConverter<int> {
+	static inline int convert(Isolate *isolate, L8Context *context,
+							  const L8TypeDescriptor& type, Local<Value> value)
+	{
+		int64_t result;
+
+		if(L8_LIKELY(value->IsInt32()))
+			return value->Int32Value();
+
+		if(!value->IsNumber())
+			isolate->ThrowException(Exception::TypeError(String::NewFromUtf8(isolate, "The implementation requests a number")));
+
+		result = value->IntegerValue();
+		if(result > INT_MAX)
+			isolate->ThrowException(Exception::RangeError(String::NewFromUtf8(isolate, "Value exceeds native argument size (int)")));
+
+		return (int)result;
+	}
+};
+
+template<> struct L8ArgumentConverter<bool> {
+	static inline bool convert(Isolate *isolate, L8Context *context,
+							   const L8TypeDescriptor& type, Local<Value> value)
+	{
+		return value->BooleanValue();
+	}
+};
+
+/**
+ * Converts a native return value of type T to a JavaScript value.
+ */
+template<typename T> struct L8ReturnConverter;
+
+template<> struct L8ReturnConverter<id> {
+	static inline Local<Value> convert(Isolate *isolate, L8Context *context, id value)
+	{
+		return objectToValue(isolate, context, value);
+	}
+};
+
+template<> struct L8ReturnConverter<double> {
+	static inline Local<Value> convert(Isolate *isolate, L8Context *context, double value)
+	{
+		return Number::New(isolate, value);
+	}
+};
+
+template<> struct L8ReturnConverter<int> {
+	static inline Local<Value> convert(Isolate *isolate, L8Context *context, int value)
+	{
+		return Integer::New(isolate, value);
+	}
+};
+
+template<> struct L8ReturnConverter<bool> {
+	static inline Local<Value> convert(Isolate *isolate, L8Context *context, bool value)
+	{
+		return v8::Boolean::New(isolate, value);
+	}
+};
+
+#pragma mark Invocation
+
+/**
+ * Calls an implementation and sets the converted result as return value.
+ */
+template<typename R> struct L8Invoker {
+	template<typename... A>
+	static inline void call(const FunctionCallbackInfo<Value>& info,
+							Isolate *isolate, L8Context *context,
+							IMP implementation, id target, SEL selector, A... arguments)
+	{
+		R result;
+
+		result = ((R (*)(id, SEL, A...))implementation)(target, selector, arguments...);
+		info.GetReturnValue().Set(L8ReturnConverter<R>::convert(isolate, context, result));
+	}
+};
+
+template<> struct L8Invoker<void> {
+	template<typename... A>
+	static inline void call(const FunctionCallbackInfo<Value>& info,
+							Isolate *isolate, L8Context *context,
+							IMP implementation, id target, SEL selector, A... arguments)
+	{
+		((void (*)(id, SEL, A...))implementation)(target, selector, arguments...);
+		info.GetReturnValue().SetUndefined();
+	}
+};
+
+/// A list of argument indices.
+template<int... I> struct L8Indices {};
+
+/// Creates L8Indices<0, ..., N-1>.
+template<int N, int... I> struct L8MakeIndices : L8MakeIndices<N - 1, N - 1, I...> {};
+template<int... I> struct L8MakeIndices<0, I...> {
+	typedef L8Indices<I...> type;
+};
+
+/**
+ * A converted native argument of type T.
+ *
+ * Native argument I+2 (after self and _cmd) is taken from JavaScript
+ * argument I. Missing arguments are Undefined.
+ */
+template<int I, typename T> struct L8ConvertedArgument {
+	T value;
+
+	L8ConvertedArgument(const FunctionCallbackInfo<Value>& info,
+						Isolate *isolate, L8Context *context,
+						const L8MethodDescriptor *descriptor)
+	: value(L8ArgumentConverter<T>::convert(isolate, context, descriptor->arguments[I + 2], info[I]))
+	{}
+};
+
+template<typename Indices, typename... A> struct L8ConvertedArguments;
+
+/**
+ * The converted arguments of a call.
+ *
+ * Bases are initialized in declaration order, so the arguments are
+ * converted from first to last like the generic path does. Conversion
+ * can run JavaScript (valueOf) and throw.
+ */
+template<int... I, typename... A> struct L8ConvertedArguments<L8Indices<I...>, A...> : L8ConvertedArgument<I, A>... {
+	L8ConvertedArguments(const FunctionCallbackInfo<Value>& info,
+						 Isolate *isolate, L8Context *context,
+						 const L8MethodDescriptor *descriptor)
+	: L8ConvertedArgument<I, A>(info, isolate, context, descriptor)...
+	{}
+};
+
+/**
+ * Converts the arguments and calls the implementation.
+ */
+template<typename R, typename... A, int... I>
+static inline void l8_trampoline_call(const FunctionCallbackInfo<Value>& info,
+									  Isolate *isolate, L8Context *context,
+									  const L8MethodDescriptor *descriptor,
+									  IMP implementation, id target, L8Indices<I...>)
+{
+	L8ConvertedArguments<L8Indices<I...>, A...> arguments(info, isolate, context, descriptor);
+
+	L8Invoker<R>::call(info, isolate, context, implementation, target, descriptor->selector,
+					   static_cast<L8ConvertedArgument<I, A>&>(arguments).value...);
+}
+
+/**
+ * Callback for methods with signature R (id, SEL, A...).
+ */
+template<typename R, typename... A>
+static void ObjCTrampoline(const FunctionCallbackInfo<Value>& info)
+{
+	L8MethodDescriptor *descriptor;
+	Isolate *isolate;
+	L8Context *context;
+	IMP implementation;
+	id target;
+
+	// A constructor call should be with ObjCConstructor
+	assert(info.IsConstructCall() == false);
+
+	descriptor = (L8MethodDescriptor *)info.Data().As<External>()->Value();
+	target = objCMethodReceiver(info, descriptor);
+
+	// Messaging nil: let the generic path produce the zero value
+	if(L8_UNLIKELY(target == nil)) {
+		ObjCMethodCall(info);
+		return;
+	}
+
+	isolate = info.GetIsolate();
+	context = [L8Context contextWithV8Context:isolate->GetCurrentContext()];
+	implementation = descriptor->implementationForReceiver(target);
+
+	L8CallbackScope callbackScope(info);
+
+	{
+		L8AutoreleaseScope autoreleaseScope(isolate);
+
+		@try {
+			l8_trampoline_call<R, A...>(info, isolate, context, descriptor, implementation, target,
+										typename L8MakeIndices<sizeof...(A)>::type());
+		} @catch(id exception) {
+			info.GetReturnValue().Set(handleInvocationException(isolate, context, exception));
+		}
+	}
+}
+
+#pragma mark Selection
+
+template<bool Enabled, typename R, typename... A> struct L8TrampolineArgument;
+
+/**
+ * Selects the trampoline for the remaining arguments, starting at index.
+ */
+template<typename R, typename... A> struct L8TrampolineSelector {
+	static FunctionCallback select(const L8MethodDescriptor *descriptor, size_t index)
+	{
+		if(index == descriptor->arguments.size())
+			return ObjCTrampoline<R, A...>;
+
+		return L8TrampolineArgument<(sizeof...(A) < L8_TRAMPOLINE_MAX_ARGUMENTS), R, A...>::select(descriptor, index);
+	}
+};
+
+/**
+ * Adds the type of the argument at index to the signature. Disabled
+ * when the maximum number of arguments is reached.
+ */
+template<bool Enabled, typename R, typename... A> struct L8TrampolineArgument {
+	static FunctionCallback select(const L8MethodDescriptor *descriptor, size_t index)
+	{
+		return NULL;
+	}
+};
+
+template<typename R, typename... A> struct L8TrampolineArgument<true, R, A...> {
+	static FunctionCallback select(const L8MethodDescriptor *descriptor, size_t index)
+	{
+		switch(descriptor->arguments[index].type) {
+			case '@':
+				return L8TrampolineSelector<R, A..., id>::select(descriptor, index + 1);
+			case 'd':
+				return L8TrampolineSelector<R, A..., double>::select(descriptor, index + 1);
+			case 'i':
+				return L8TrampolineSelector<R, A..., int>::select(descriptor, index + 1);
+			case 'B':
+				return L8TrampolineSelector<R, A..., bool>::select(descriptor, index + 1);
+			default:
+				return NULL;
+		}
+	}
+};
+
+FunctionCallback l8_trampoline_for_descriptor(const L8MethodDescriptor *descriptor)
+{
+	// Methods only: blocks have no _cmd
+	if(descriptor->selector == NULL || descriptor->arguments.size() < 2)
+		return NULL;
+
+	// A returned L8Value may have to be thrown, see objCConvertReturnValue
+	if(descriptor->returnType.objectClass == [L8Value class])
+		return NULL;
+
+	switch(descriptor->returnType.type) {
+		case 'v':
+			return L8TrampolineSelector<void>::select(descriptor, 2);
+		case '@':
+			return L8TrampolineSelector<id>::select(descriptor, 2);
+		case 'd':
+			return L8TrampolineSelector<double>::select(descriptor, 2);
+		case 'i':
+			return L8TrampolineSelector<int>::select(descriptor, 2);
+		case 'B':
+			return L8TrampolineSelector<bool>::select(descriptor, 2);
+		default:
+			return NULL;
+	}
+}
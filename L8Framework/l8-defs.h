@@ -44,6 +44,26 @@
  */
 #define L8_ENABLE_SYMBOLS
 
+/**
+ * Calls native methods and blocks using libffi instead of
+ * NSInvocation.
+ *
+ * The call interface is prepared once per method signature.
+ * Signatures libffi can not handle keep using NSInvocation.
+ *
+ * Requires linking with libffi (-lffi).
+ */
+//#define L8_USE_LIBFFI
+
+/**
+ * Reads and writes the instance variable of exported properties
+ * directly, instead of calling the accessors, for classes adopting
+ * L8DirectIvarAccess. Other classes always call the accessors.
+ *
+ * Disable to call the accessors of every class.
+ */
+#define L8_DIRECT_IVAR_ACCESS
+
 //#define L8_OBJC_OBJFW
 
 #pragma mark Definitions dependent on configuration
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <Foundation/Foundation.h>
+#import "L8Export.h"
+
+@class L8Value;
+
+/*
+ * A class bound by l8gen. BindingTestObjectBinding.mm is generated with
+ * l8gen -o BindingTestObjectBinding.mm BindingTestObject.h
+ * and must be regenerated when this header changes.
+ */
+
+@protocol BindingTestObject <L8Export>
+@property double value;
+@property (readonly) NSString *name;
+
+- (double)addValue:(double)amount;
+
+L8_EXPORT_AS(scale,
+- (double)multiplyValueBy:(double)factor
+);
+
+- (L8Value *)checkPositive:(double)number;
+- (int)halve:(int)number;
+
+- (void)autoreleaseObject;
+- (BOOL)autoreleasedObjectIsAlive;
+
++ (NSString *)kind;
+@end
+
+@interface BindingTestObject : NSObject <BindingTestObject>
+@end
@@ -0,0 +1,188 @@
+/*
+ * Generated by l8gen. Do not edit.
+ */
+
+#import "BindingTestObject.h"
+#import <L8Framework/L8Binding.h>
+#import <objc/runtime.h>
+
+#pragma mark - BindingTestObject
+
+static void l8gen_BindingTestObject_method_addValue_(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingCallScope scope(info);
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		BindingTestObject *receiver = L8BindingUnwrap(info.This());
+		double result = [receiver addValue:(double)L8BindingToNumber(isolate, info[0])];
+		info.GetReturnValue().Set(v8::Number::New(isolate, (double)result));
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_method_multiplyValueBy_(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingCallScope scope(info);
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		BindingTestObject *receiver = L8BindingUnwrap(info.This());
+		double result = [receiver multiplyValueBy:(double)L8BindingToNumber(isolate, info[0])];
+		info.GetReturnValue().Set(v8::Number::New(isolate, (double)result));
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_method_checkPositive_(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingCallScope scope(info);
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		BindingTestObject *receiver = L8BindingUnwrap(info.This());
+		L8Value * result = [receiver checkPositive:(double)L8BindingToNumber(isolate, info[0])];
+		info.GetReturnValue().Set(L8BindingFromObject(isolate, result));
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_method_halve_(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingCallScope scope(info);
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		BindingTestObject *receiver = L8BindingUnwrap(info.This());
+		int result = [receiver halve:(int)L8BindingToInteger(isolate, info[0], @encode(int))];
+		info.GetReturnValue().Set(v8::Number::New(isolate, (double)result));
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_method_autoreleaseObject(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingCallScope scope(info);
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		BindingTestObject *receiver = L8BindingUnwrap(info.This());
+		[receiver autoreleaseObject];
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_method_autoreleasedObjectIsAlive(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingCallScope scope(info);
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		BindingTestObject *receiver = L8BindingUnwrap(info.This());
+		BOOL result = [receiver autoreleasedObjectIsAlive];
+		info.GetReturnValue().Set(v8::Boolean::New(isolate, result));
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_class_kind(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingCallScope scope(info);
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		NSString * result = [BindingTestObject kind];
+		info.GetReturnValue().Set(L8BindingFromObject(isolate, result));
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_get_value(v8::Local<v8::String> property, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		BindingTestObject *receiver = L8BindingUnwrap(info.Holder());
+		double result = [receiver value];
+		info.GetReturnValue().Set(v8::Number::New(isolate, (double)result));
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_set_value(v8::Local<v8::String> property, v8::Local<v8::Value> value, const v8::PropertyCallbackInfo<void>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		BindingTestObject *receiver = L8BindingUnwrap(info.Holder());
+		[receiver setValue:(double)L8BindingToNumber(isolate, value)];
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_get_name(v8::Local<v8::String> property, const v8::PropertyCallbackInfo<v8::Value>& info)
+{
+	v8::Isolate *isolate = info.GetIsolate();
+	L8BindingAutoreleaseScope autoreleaseScope(isolate);
+
+	@try {
+		BindingTestObject *receiver = L8BindingUnwrap(info.Holder());
+		NSString * result = [receiver name];
+		info.GetReturnValue().Set(L8BindingFromObject(isolate, result));
+	} @catch(id exception) {
+		L8BindingThrow(isolate, exception);
+	}
+}
+
+static void l8gen_BindingTestObject_install(v8::Isolate *isolate, v8::Local<v8::FunctionTemplate> classTemplate)
+{
+	v8::Local<v8::ObjectTemplate> prototypeTemplate = classTemplate->PrototypeTemplate();
+	v8::Local<v8::AccessorSignature> signature = v8::AccessorSignature::New(isolate, classTemplate);
+
+	prototypeTemplate->Set(v8::String::NewFromUtf8(isolate, "addValue"),
+		v8::FunctionTemplate::New(isolate, l8gen_BindingTestObject_method_addValue_));
+	prototypeTemplate->Set(v8::String::NewFromUtf8(isolate, "scale"),
+		v8::FunctionTemplate::New(isolate, l8gen_BindingTestObject_method_multiplyValueBy_));
+	prototypeTemplate->Set(v8::String::NewFromUtf8(isolate, "checkPositive"),
+		v8::FunctionTemplate::New(isolate, l8gen_BindingTestObject_method_checkPositive_));
+	prototypeTemplate->Set(v8::String::NewFromUtf8(isolate, "halve"),
+		v8::FunctionTemplate::New(isolate, l8gen_BindingTestObject_method_halve_));
+	prototypeTemplate->Set(v8::String::NewFromUtf8(isolate, "autoreleaseObject"),
+		v8::FunctionTemplate::New(isolate, l8gen_BindingTestObject_method_autoreleaseObject));
+	prototypeTemplate->Set(v8::String::NewFromUtf8(isolate, "autoreleasedObjectIsAlive"),
+		v8::FunctionTemplate::New(isolate, l8gen_BindingTestObject_method_autoreleasedObjectIsAlive));
+	classTemplate->Set(v8::String::NewFromUtf8(isolate, "kind"),
+		v8::FunctionTemplate::New(isolate, l8gen_BindingTestObject_class_kind));
+	prototypeTemplate->SetAccessor(v8::String::NewFromUtf8(isolate, "value"),
+		l8gen_BindingTestObject_get_value, l8gen_BindingTestObject_set_value,
+		v8::Handle<v8::Value>(), v8::AccessControl::DEFAULT, v8::PropertyAttribute::None, signature);
+	prototypeTemplate->SetAccessor(v8::String::NewFromUtf8(isolate, "name"),
+		l8gen_BindingTestObject_get_name, 0,
+		v8::Handle<v8::Value>(), v8::AccessControl::DEFAULT, v8::PropertyAttribute::ReadOnly, signature);
+}
+
+static const char *const l8gen_BindingTestObject_protocols[] = { "BindingTestObject", NULL };
+
+__attribute__((constructor))
+static void l8gen_register_bindings(void)
+{
+	L8RegisterBinding(objc_getClass("BindingTestObject"), l8gen_BindingTestObject_install, l8gen_BindingTestObject_protocols);
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+#import <L8Framework/L8Binding.h>
+#import "L8Context.h"
+#import "L8Value.h"
+#import "L8VirtualMachine.h"
+#import "BindingTestObject.h"
+
+@interface L8BindingTests : XCTestCase @end
+
+@protocol UncoveredBindingExtra <L8Export>
+- (double)extra;
+@end
+@interface UncoveredBindingTestObject : NSObject <BindingTestObject, UncoveredBindingExtra> @end
+
+@interface LazyBindingTestObject : NSObject <BindingTestObject, L8LazyExport> @end
+
+static const char *const l8_test_binding_protocols[] = { "BindingTestObject", NULL };
+
+static L8Value *l8_test_check_positive(double number)
+{
+	L8Context *context = [L8Context currentContext];
+
+	if(number < 0)
+		return [L8Value valueWithThrownValue:[L8Value valueWithNewErrorFromMessage:@"Not positive" inContext:context]
+								   inContext:context];
+
+	return [L8Value valueWithDouble:number inContext:context];
+}
+
+static void l8_test_empty_installer(v8::Isolate *isolate, v8::Local<v8::FunctionTemplate> classTemplate)
+{
+}
+
+@implementation L8BindingTests
+
+- (void)testGeneratedBindingIsRegistered
+{
+	XCTAssertTrue(L8BindingInstallerForClass([BindingTestObject class]) != NULL,
+				  "The checked-in binding registers itself on load");
+	XCTAssertTrue(L8BindingInstallerForClass([NSObject class]) == NULL,
+				  "Classes without a binding have no installer");
+}
+
+- (void)testGeneratedBinding
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			BindingTestObject *object = [[BindingTestObject alloc] init];
+
+			context[@"object"] = object;
+			context[@"BindingTestObject"] = [BindingTestObject class];
+
+			XCTAssertEqual([[context evaluateScript:@"object.value = 2; object.value"] toDouble], 2.0,
+						   "Generated property accessors");
+			XCTAssertEqual(object.value, 2.0, "Generated setter sets the native property");
+			XCTAssertEqualObjects([[context evaluateScript:@"object.name"] toString], @"bound",
+								  "Generated readonly property");
+
+			XCTAssertEqual([[context evaluateScript:@"object.addValue(3)"] toDouble], 5.0,
+						   "Generated method");
+			XCTAssertEqual([[context evaluateScript:@"object.scale(2)"] toDouble], 4.0,
+						   "Generated method renamed with L8_EXPORT_AS");
+			XCTAssertTrue([[context evaluateScript:@"object.multiplyValueBy === undefined"] toBool],
+						  "Renamed method is not installed under its selector name");
+			XCTAssertEqualObjects([[context evaluateScript:@"BindingTestObject.kind()"] toString], @"BindingTestObject",
+								  "Generated class method");
+		}];
+	}
+}
+
+- (void)testGeneratedBindingThrownValue
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			L8Value *result;
+
+			context[@"object"] = [[BindingTestObject alloc] init];
+
+			XCTAssertEqual([[context evaluateScript:@"object.checkPositive(1)"] toDouble], 1.0,
+						   "Generated method returns an L8Value");
+
+			result = [context evaluateScript:@"try { object.checkPositive(-1); 'none' } catch(e) { e.message }"];
+			XCTAssertEqualObjects([result toString], @"Not positive",
+								  "Generated method throws a thrown value, like a reflected method");
+		}];
+	}
+}
+
+- (void)testGeneratedBindingIntegerArgument
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			L8Value *result;
+
+			context[@"object"] = [[BindingTestObject alloc] init];
+
+			XCTAssertEqual([[context evaluateScript:@"object.halve(-9)"] toInt32], -4, "Integer argument converted");
+
+			result = [context evaluateScript:@"try { object.halve(1e12); false } catch(e) { e instanceof RangeError }"];
+			XCTAssertTrue([result toBool], "Integer out of range throws a RangeError, like a reflected method");
+
+			result = [context evaluateScript:@"try { object.halve('text'); false } catch(e) { e instanceof TypeError }"];
+			XCTAssertTrue([result toBool], "A value that is not a number throws a TypeError, like a reflected method");
+		}];
+	}
+}
+
+- (void)testGeneratedBindingAutoreleasePolicy
+{
+	@autoreleasepool {
+		L8Context *context = [[L8Context alloc] init];
+
+		context.virtualMachine.autoreleasePolicy = L8AutoreleasePolicyPerEvaluation;
+
+		[context executeBlockInContext:^(L8Context *context) {
+			BindingTestObject *object = [[BindingTestObject alloc] init];
+			L8Value *result;
+
+			context[@"object"] = object;
+
+			result = [context evaluateScript:@"object.autoreleaseObject(); object.autoreleasedObjectIsAlive()"];
+			XCTAssertTrue([result toBool], "Generated methods share the pool of the evaluation");
+			XCTAssertFalse([object autoreleasedObjectIsAlive], "The pool is drained when the evaluation ends");
+		}];
+	}
+}
+
+- (void)testBindingNotCoveringAllProtocols
+{
+	L8RegisterBinding([UncoveredBindingTestObject class], l8_test_empty_installer, l8_test_binding_protocols);
+
+	XCTAssertTrue(L8BindingInstallerForClass([UncoveredBindingTestObject class]) == NULL,
+				  "A binding missing an export protocol of the class is not used");
+
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			context[@"object"] = [[UncoveredBindingTestObject alloc] init];
+
+			XCTAssertEqual([[context evaluateScript:@"object.extra() + object.addValue(1)"] toDouble], 2.0,
+						   "All members are found using reflection");
+		}];
+	}
+}
+
+- (void)testBindingOfLazyClass
+{
+	L8RegisterBinding([LazyBindingTestObject class], l8_test_empty_installer, l8_test_binding_protocols);
+
+	XCTAssertTrue(L8BindingInstallerForClass([LazyBindingTestObject class]) == NULL,
+				  "Lazy classes are bound using reflection");
+}
+
+@end
+
+@implementation BindingTestObject {
+	__weak id _autoreleasedObject;
+}
+@synthesize value;
+
+- (NSString *)name
+{
+	return @"bound";
+}
+
+- (double)addValue:(double)amount
+{
+	value += amount;
+	return value;
+}
+
+- (double)multiplyValueBy:(double)factor
+{
+	value *= factor;
+	return value;
+}
+
+- (L8Value *)checkPositive:(double)number
+{
+	return l8_test_check_positive(number);
+}
+
+- (int)halve:(int)number
+{
+	return number / 2;
+}
+
+- (void)autoreleaseObject
+{
+	__autoreleasing id object = [[NSObject alloc] init];
+
+	_autoreleasedObject = object;
+}
+
+- (BOOL)autoreleasedObjectIsAlive
+{
+	return _autoreleasedObject != nil;
+}
+
++ (NSString *)kind
+{
+	return NSStringFromClass(self);
+}
+
+@end
+
+@implementation UncoveredBindingTestObject
+@synthesize value;
+
+- (NSString *)name
+{
+	return @"uncovered";
+}
+
+- (double)addValue:(double)amount
+{
+	return value + amount;
+}
+
+- (double)multiplyValueBy:(double)factor
+{
+	return value * factor;
+}
+
+- (L8Value *)checkPositive:(double)number
+{
+	return l8_test_check_positive(number);
+}
+
+- (int)halve:(int)number
+{
+	return number / 2;
+}
+
+- (void)autoreleaseObject
+{
+}
+
+- (BOOL)autoreleasedObjectIsAlive
+{
+	return NO;
+}
+
++ (NSString *)kind
+{
+	return NSStringFromClass(self);
+}
+
+- (double)extra
+{
+	return 1;
+}
+
+@end
+
+@implementation LazyBindingTestObject
+@synthesize value;
+
+- (NSString *)name
+{
+	return @"lazy";
+}
+
+- (double)addValue:(double)amount
+{
+	return value + amount;
+}
+
+- (double)multiplyValueBy:(double)factor
+{
+	return value * factor;
+}
+
+- (L8Value *)checkPositive:(double)number
+{
+	return l8_test_check_positive(number);
+}
+
+- (int)halve:(int)number
+{
+	return number / 2;
+}
+
+- (void)autoreleaseObject
+{
+}
+
+- (BOOL)autoreleasedObjectIsAlive
+{
+	return NO;
+}
+
++ (NSString *)kind
+{
+	return NSStringFromClass(self);
+}
+
+@end
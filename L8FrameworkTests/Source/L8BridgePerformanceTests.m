@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+#import <mach/mach.h>
+#import "L8Context.h"
+#import "L8Value.h"
+#import "L8Export.h"
+#import "l8-defs.h"
+
+/*
+ * Measures the cost of crossing the bridge from JavaScript to
+ * Objective-C. Methods with up to two id, double, int or BOOL arguments
+ * use the typed trampolines. The Engine tests use signatures that never
+ * do, and run them once with each call engine. Build with L8_USE_LIBFFI
+ * (l8-defs.h) to include libffi.
+ */
+
+#ifdef L8_USE_LIBFFI
+extern bool l8_ffi_enabled;
+#endif
+
+#define L8_BENCHMARK_ITERATIONS 100000
+#define L8_BENCHMARK_WRAPPERS 1000000
+
+@interface L8BridgePerformanceTests : XCTestCase @end
+
+@protocol BridgeBenchmark <L8Export>
+- (double)zero;
+- (double)one:(double)a;
+- (double)two:(double)a :(double)b;
+- (double)three:(double)a :(double)b :(double)c;
+- (double)four:(double)a :(double)b :(double)c :(double)d;
+- (double)five:(double)a :(double)b :(double)c :(double)d :(double)e;
+- (double)six:(double)a :(double)b :(double)c :(double)d :(double)e :(double)f;
+- (double)mixed:(float)a :(long long)b;
+@end
+@interface BridgeBenchmark : NSObject <BridgeBenchmark> @end
+
+@protocol WideObject <L8Export>
+@property double p0;
+@property double p1;
+@property double p2;
+@property double p3;
+@property double p4;
+@property double p5;
+@property double p6;
+@property double p7;
+@property double p8;
+@property double p9;
+@property double p10;
+@property double p11;
+@property double p12;
+@property double p13;
+@property double p14;
+@property double p15;
+@property double p16;
+@property double p17;
+@property double p18;
+@property double p19;
+@end
+@interface WideObject : NSObject <WideObject> @end
+@interface DirectWideObject : NSObject <WideObject, L8DirectIvarAccess> @end
+
+@protocol WideObjectFactory <L8Export>
+- (WideObject *)make;
+@end
+@interface WideObjectFactory : NSObject <WideObjectFactory> @end
+
+/**
+ * Get the resident memory size of the process.
+ */
+static size_t l8_resident_size(void)
+{
+	struct mach_task_basic_info info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+	if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+		return 0;
+
+	return info.resident_size;
+}
+
+@implementation L8BridgePerformanceTests
+
+- (void)measureScript:(NSString *)call expectedResult:(double)expected
+{
+	[self measureScript:call expectedResult:expected autoreleasePolicy:L8AutoreleasePolicyPerCall];
+}
+
+/**
+ * Measure a call with libffi, or with NSInvocation when useFFI is NO.
+ *
+ * Without L8_USE_LIBFFI both measure NSInvocation.
+ */
+- (void)measureScript:(NSString *)call expectedResult:(double)expected useFFI:(BOOL)useFFI
+{
+#ifdef L8_USE_LIBFFI
+	l8_ffi_enabled = useFFI;
+	NSLog(@"Call engine for %@: %@", call, useFFI ? @"libffi" : @"NSInvocation");
+#else
+	NSLog(@"Call engine for %@: NSInvocation (built without L8_USE_LIBFFI)", call);
+#endif
+
+	[self measureScript:call expectedResult:expected];
+
+#ifdef L8_USE_LIBFFI
+	l8_ffi_enabled = true;
+#endif
+}
+
+- (void)measureScript:(NSString *)call expectedResult:(double)expected autoreleasePolicy:(L8AutoreleasePolicy)policy
+{
+	@autoreleasepool {
+		L8Context *benchContext = [[L8Context alloc] init];
+
+		benchContext.virtualMachine.autoreleasePolicy = policy;
+
+		[benchContext executeBlockInContext:^(L8Context *context) {
+			NSString *script;
+			L8Value *result;
+
+			context[@"bench"] = [[BridgeBenchmark alloc] init];
+			context[@"wide"] = [[WideObject alloc] init];
+			context[@"directWide"] = [[DirectWideObject alloc] init];
+			context[@"sum"] = ^double(double a, double b, double c) {
+				return a + b + c;
+			};
+
+			script = [NSString stringWithFormat:@"(function() {"
+					  "var r = 0;"
+					  "for(var i = 0; i < %d; ++i) r = %@;"
+					  "return r; })()", L8_BENCHMARK_ITERATIONS, call];
+
+			result = [context evaluateScript:call];
+			XCTAssertEqual([result toDouble], expected, "Benchmark method returns correct value");
+
+			[self measureBlock:^{
+				[context evaluateScript:script];
+			}];
+		}];
+	}
+}
+
+- (void)testPerformanceZeroArguments
+{
+	[self measureScript:@"bench.zero()" expectedResult:0];
+}
+
+- (void)testPerformanceZeroArgumentsIntervalPool
+{
+	[self measureScript:@"bench.zero()" expectedResult:0 autoreleasePolicy:L8AutoreleasePolicyInterval];
+}
+
+- (void)testPerformanceZeroArgumentsEvaluationPool
+{
+	[self measureScript:@"bench.zero()" expectedResult:0 autoreleasePolicy:L8AutoreleasePolicyPerEvaluation];
+}
+
+- (void)testPerformanceOneArgument
+{
+	[self measureScript:@"bench.one(1)" expectedResult:1];
+}
+
+- (void)testPerformanceTwoArguments
+{
+	[self measureScript:@"bench.two(1,2)" expectedResult:3];
+}
+
+- (void)testPerformanceThreeArguments
+{
+	[self measureScript:@"bench.three(1,2,3)" expectedResult:6];
+}
+
+- (void)testPerformanceFourArguments
+{
+	[self measureScript:@"bench.four(1,2,3,4)" expectedResult:10];
+}
+
+- (void)testPerformanceFiveArguments
+{
+	[self measureScript:@"bench.five(1,2,3,4,5)" expectedResult:15];
+}
+
+- (void)testPerformanceSixArguments
+{
+	[self measureScript:@"bench.six(1,2,3,4,5,6)" expectedResult:21];
+}
+
+- (void)testPerformanceEngineFFIMixedArguments
+{
+	[self measureScript:@"bench.mixed(1,2)" expectedResult:3 useFFI:YES];
+}
+
+- (void)testPerformanceEngineInvocationMixedArguments
+{
+	[self measureScript:@"bench.mixed(1,2)" expectedResult:3 useFFI:NO];
+}
+
+- (void)testPerformanceEngineFFISixArguments
+{
+	[self measureScript:@"bench.six(1,2,3,4,5,6)" expectedResult:21 useFFI:YES];
+}
+
+- (void)testPerformanceEngineInvocationSixArguments
+{
+	[self measureScript:@"bench.six(1,2,3,4,5,6)" expectedResult:21 useFFI:NO];
+}
+
+- (void)testPerformanceEngineFFIBlock
+{
+	[self measureScript:@"sum(1,2,3)" expectedResult:6 useFFI:YES];
+}
+
+- (void)testPerformanceEngineInvocationBlock
+{
+	[self measureScript:@"sum(1,2,3)" expectedResult:6 useFFI:NO];
+}
+
+- (void)testPerformancePropertyGetter
+{
+	[self measureScript:@"wide.p19" expectedResult:19];
+}
+
+- (void)testPerformancePropertyGetterDirectIvar
+{
+	[self measureScript:@"directWide.p19" expectedResult:19];
+}
+
+- (void)testPerformancePropertySetter
+{
+	[self measureScript:@"wide.p0 = 1" expectedResult:1];
+}
+
+- (void)testPerformancePropertySetterDirectIvar
+{
+	[self measureScript:@"directWide.p0 = 1" expectedResult:1];
+}
+
+/*
+ * Wrapping objects with many properties. The time and resident memory
+ * grow with the size of each wrapper object.
+ */
+- (NSString *)wrapScript
+{
+	return [NSString stringWithFormat:@"(function() {"
+			"var a = new Array(%d);"
+			"for(var i = 0; i < a.length; ++i) a[i] = factory.make();"
+			"return a; })()", L8_BENCHMARK_WRAPPERS];
+}
+
+- (void)testPerformanceWrapping
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			NSString *script = [self wrapScript];
+
+			context[@"factory"] = [[WideObjectFactory alloc] init];
+
+			XCTAssertEqual([[context evaluateScript:@"factory.make().p19"] toDouble], 19.0,
+						   "Wrapped object has working accessors");
+
+			[self measureBlock:^{
+				@autoreleasepool {
+					[context evaluateScript:script];
+				}
+			}];
+		}];
+	}
+}
+
+- (void)testMemoryWrapping
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			size_t before, after;
+
+			context[@"factory"] = [[WideObjectFactory alloc] init];
+
+			before = l8_resident_size();
+			context[@"wrappers"] = [context evaluateScript:[self wrapScript]];
+			after = l8_resident_size();
+
+			XCTAssertEqual([[context evaluateScript:@"wrappers.length"] toDouble],
+						   (double)L8_BENCHMARK_WRAPPERS, "All objects are wrapped");
+
+			NSLog(@"Wrapping %d objects with 20 properties: %.1f MB resident",
+				  L8_BENCHMARK_WRAPPERS, (after - before) / (1024.0 * 1024.0));
+		}];
+	}
+}
+
+@end
+
+@implementation BridgeBenchmark
+
+- (double)zero
+{
+	return 0;
+}
+
+- (double)one:(double)a
+{
+	return a;
+}
+
+- (double)two:(double)a :(double)b
+{
+	return a + b;
+}
+
+- (double)three:(double)a :(double)b :(double)c
+{
+	return a + b + c;
+}
+
+- (double)four:(double)a :(double)b :(double)c :(double)d
+{
+	return a + b + c + d;
+}
+
+- (double)five:(double)a :(double)b :(double)c :(double)d :(double)e
+{
+	return a + b + c + d + e;
+}
+
+- (double)six:(double)a :(double)b :(double)c :(double)d :(double)e :(double)f
+{
+	return a + b + c + d + e + f;
+}
+
+- (double)mixed:(float)a :(long long)b
+{
+	return a + b;
+}
+
+@end
+
+@implementation WideObject
+@synthesize p0, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15, p16, p17, p18, p19;
+
+- (instancetype)init
+{
+	self = [super init];
+	if(self)
+		p19 = 19;
+	return self;
+}
+
+@end
+
+@implementation DirectWideObject
+@synthesize p0, p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13, p14, p15, p16, p17, p18, p19;
+
+- (instancetype)init
+{
+	self = [super init];
+	if(self)
+		p19 = 19;
+	return self;
+}
+
+@end
+
+@implementation WideObjectFactory
+
+- (WideObject *)make
+{
+	return [[WideObject alloc] init];
+}
+
+@end
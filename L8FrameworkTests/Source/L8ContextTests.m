@@ -25,12 +25,38 @@
 
 #import <XCTest/XCTest.h>
 #import "L8Context.h"
+#import "L8VirtualMachine.h"
 #import "L8Value.h"
+#import "L8Export.h"
 
 @interface L8ContextTests : XCTestCase
 
 @end
 
+@protocol CallbackInfoClass <L8Export>
+- (double)argumentCount;
+- (L8Value *)currentThis;
+- (id)sameObject;
+@end
+@interface CallbackInfoClass : NSObject <CallbackInfoClass> @end
+
+@protocol LazyClass <L8Export>
+@property double value;
+- (double)one;
+- (double)addOne:(double)value;
+@end
+@interface LazyClass : NSObject <LazyClass, L8LazyExport> @end
+
+@protocol ImageClass <L8Export>
+@end
+@interface ImageClass : NSObject <ImageClass, L8ExternalMemory> @end
+
+@protocol AllocatingClass <L8Export>
+- (void)allocate;
+- (BOOL)firstAllocationIsAlive;
+@end
+@interface AllocatingClass : NSObject <AllocatingClass> @end
+
 @implementation L8ContextTests
 
 - (void)testCurrentContext
@@ -42,4 +68,244 @@
 	}];
 }
 
+- (void)testCurrentCallbackInformation
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			context[@"object"] = [[CallbackInfoClass alloc] init];
+
+			XCTAssertEqual([[context evaluateScript:@"object.argumentCount(1, 2, 3)"] toDouble], 3.0,
+						   "+[currentArguments] in a callback");
+			XCTAssertTrue([[context evaluateScript:@"object.currentThis() === object"] toBool],
+						  "+[currentThis] in a callback");
+			XCTAssertTrue([[context evaluateScript:@"object.argumentCount(object.argumentCount(1), 2) == 2"] toBool],
+						  "+[currentArguments] after another callback");
+
+			XCTAssertNil([L8Context currentThis], "+[currentThis] outside a callback");
+			XCTAssertNil([L8Context currentArguments], "+[currentArguments] outside a callback");
+		}];
+	}
+}
+
+- (void)testContextsShareVirtualMachine
+{
+	@autoreleasepool {
+		L8VirtualMachine *virtualMachine = [[L8VirtualMachine alloc] init];
+
+		for(int i = 0; i < 2; ++i) {
+			[[[L8Context alloc] initWithVirtualMachine:virtualMachine] executeBlockInContext:^(L8Context *context) {
+				context[@"CallbackInfoClass"] = [CallbackInfoClass class];
+
+				XCTAssertEqual([[context evaluateScript:@"new CallbackInfoClass().argumentCount(1, 2)"] toDouble], 2.0,
+							   "Classes work in every context of a virtual machine");
+				XCTAssertTrue([[context evaluateScript:@"new CallbackInfoClass() instanceof CallbackInfoClass"] toBool],
+							  "Instances belong to the class of their context");
+				XCTAssertEqualObjects([context[@"CallbackInfoClass"] toObject], [CallbackInfoClass class],
+									  "Classes are unwrapped in every context");
+			}];
+		}
+	}
+}
+
+- (void)testLazyMembers
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			NSUInteger installed;
+
+			context[@"object"] = [[LazyClass alloc] init];
+			installed = context.virtualMachine.lazyMembersInstalled;
+
+			XCTAssertEqual([[context evaluateScript:@"object.one() + object.addOne(1)"] toDouble], 3.0,
+						   "Lazy methods are callable");
+			XCTAssertEqual(context.virtualMachine.lazyMembersInstalled, installed + 2, "Accessed methods are installed");
+
+			XCTAssertTrue([[context evaluateScript:@"Object.getPrototypeOf(object).hasOwnProperty('one')"] toBool],
+						  "Methods are installed on the prototype");
+			[context evaluateScript:@"object.one()"];
+			XCTAssertEqual(context.virtualMachine.lazyMembersInstalled, installed + 2, "Methods are installed once");
+
+			XCTAssertEqual([[context evaluateScript:@"object.value = 4; object.value"] toDouble], 4.0,
+						   "Properties of lazy classes work");
+		}];
+	}
+}
+
+- (void)testWrapperIdentity
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			NSUInteger hits, misses;
+
+			context[@"object"] = [[CallbackInfoClass alloc] init];
+			context[@"CallbackInfoClass"] = [CallbackInfoClass class];
+			hits = context.wrapperCacheHits;
+			misses = context.wrapperCacheMisses;
+
+			XCTAssertTrue([[context evaluateScript:@"object.sameObject() === object"] toBool],
+						  "An object has one wrapper");
+			XCTAssertTrue([[context evaluateScript:@"var o = new CallbackInfoClass(); o.sameObject() === o"] toBool],
+						  "Constructed objects keep their wrapper");
+			XCTAssertEqual(context.wrapperCacheHits, hits + 2, "Wrappers are reused");
+			XCTAssertEqual(context.wrapperCacheMisses, misses, "No new wrappers are created");
+		}];
+	}
+}
+
+- (void)testReleaseQueue
+{
+	@autoreleasepool {
+		L8Context *context = [[L8Context alloc] init];
+
+		[context executeBlockInContext:^(L8Context *context) {
+			context[@"CallbackInfoClass"] = [CallbackInfoClass class];
+			[context evaluateScript:@"for(var i = 0; i < 1000; i++) new CallbackInfoClass();"];
+		}];
+
+		[context.virtualMachine runGarbageCollector];
+
+		{
+			dispatch_semaphore_t done = dispatch_semaphore_create(0);
+			__block NSUInteger released = 1;
+
+			dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+				released = [context.virtualMachine drainReleaseQueue:0];
+				dispatch_semaphore_signal(done);
+			});
+			dispatch_semaphore_wait(done, DISPATCH_TIME_FOREVER);
+
+			XCTAssertEqual(released, 0u, "Other threads can not drain the queue");
+		}
+
+		[context.virtualMachine drainReleaseQueue:0];
+
+		XCTAssertEqual(context.virtualMachine.releaseQueueDepth, 0u, "Draining releases all queued objects");
+		XCTAssertEqual([context.virtualMachine drainReleaseQueue:0], 0u, "Nothing is left to release");
+	}
+}
+
+- (void)testLiveHandles
+{
+	L8Context *context = [[L8Context alloc] init];
+	NSUInteger handles = context.virtualMachine.liveHandles;
+
+	[context executeBlockInContext:^(L8Context *context) {
+		@autoreleasepool {
+			for(int i = 0; i < 100; ++i)
+				[context evaluateScript:@"({})"];
+		}
+	}];
+
+	XCTAssertEqual(context.virtualMachine.liveHandles, handles, "Handles of deallocated values are disposed");
+}
+
+- (void)testAutoreleaseMemoryLimit
+{
+	@autoreleasepool {
+		L8Context *context = [[L8Context alloc] init];
+
+		XCTAssertTrue(context.virtualMachine.autoreleaseMemoryLimit > 0, "The memory limit is enabled by default");
+
+		context.virtualMachine.autoreleasePolicy = L8AutoreleasePolicyPerEvaluation;
+		context.virtualMachine.autoreleaseMemoryLimit = 8 * 1024 * 1024;
+
+		[context executeBlockInContext:^(L8Context *context) {
+			L8Value *result;
+
+			context[@"allocator"] = [[AllocatingClass alloc] init];
+
+			// 128 MB is allocated, the limit is checked every 16 MB
+			result = [context evaluateScript:@"for(var i = 0; i < 2048; i++) allocator.allocate();"
+					  "allocator.firstAllocationIsAlive()"];
+			XCTAssertFalse([result toBool], "Growing memory drains the pool before the evaluation ends");
+		}];
+	}
+}
+
+- (void)testExternalMemory
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			L8VirtualMachine *virtualMachine = context.virtualMachine;
+			int64_t reported = virtualMachine.externalMemoryReported;
+			NSUInteger objects = virtualMachine.externalMemoryObjects;
+			ImageClass *image = [[ImageClass alloc] init];
+
+			context[@"image"] = image;
+
+			XCTAssertEqual(virtualMachine.externalMemoryReported, reported + 1024 * 1024,
+						   "The cost of a wrapped object is reported");
+			XCTAssertEqual(virtualMachine.externalMemoryObjects, objects + 1, "The wrapper is counted");
+
+			context[@"again"] = image;
+			XCTAssertEqual(virtualMachine.externalMemoryObjects, objects + 1, "A reused wrapper is reported once");
+		}];
+	}
+}
+
+@end
+
+@implementation AllocatingClass {
+	__weak NSData *_firstAllocation;
+}
+
+- (void)allocate
+{
+	__autoreleasing NSMutableData *data = [NSMutableData dataWithLength:64 * 1024];
+
+	// Touch the memory, so it is resident
+	memset(data.mutableBytes, 1, data.length);
+
+	if(_firstAllocation == nil)
+		_firstAllocation = data;
+}
+
+- (BOOL)firstAllocationIsAlive
+{
+	return _firstAllocation != nil;
+}
+
+@end
+
+@implementation ImageClass
+
+- (size_t)externalMemoryCost
+{
+	return 1024 * 1024;
+}
+
+@end
+
+@implementation LazyClass
+@synthesize value;
+
+- (double)one
+{
+	return 1.0;
+}
+
+- (double)addOne:(double)number
+{
+	return number + 1.0;
+}
+
+@end
+
+@implementation CallbackInfoClass
+
+- (double)argumentCount
+{
+	return [L8Context currentArguments].count;
+}
+
+- (L8Value *)currentThis
+{
+	return [L8Context currentThis];
+}
+
+- (id)sameObject
+{
+	return self;
+}
+
 @end
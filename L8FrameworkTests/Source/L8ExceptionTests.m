@@ -30,6 +30,14 @@
 
 @end
 
+@protocol ValidatingClass <L8Export>
+- (NSString *)validate:(NSString *)string error:(NSError **)error;
+- (BOOL)normalize:(NSString *)string error:(NSError **)error;
+- (BOOL)isNullPointer:(id *)pointer;
+- (L8Value *)checkPositive:(double)number;
+@end
+@interface ValidatingClass : NSObject <ValidatingClass> @end
+
 @implementation L8ExceptionTests
 
 - (void)testJSToObjC
@@ -43,6 +51,96 @@
 	}
 }
 
+- (void)testErrorArgument
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			L8Value *result;
+
+			context[@"validator"] = [[ValidatingClass alloc] init];
+
+			result = [context evaluateScript:@"validator.validateError('abc')"];
+			XCTAssertEqualObjects([result toString], @"abc", "No error returns the result");
+
+			result = [context evaluateScript:@"try { validator.validateError(''); 'none' }"
+					  "catch(e) { e.domain + ':' + e.code + ':' + e.message }"];
+			XCTAssertEqualObjects([result toString], @"Validation:3:Empty string", "Error is thrown as JS error");
+		}];
+	}
+}
+
+- (void)testErrorOfSuccessfulCall
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			L8Value *result;
+
+			context[@"validator"] = [[ValidatingClass alloc] init];
+
+			result = [context evaluateScript:@"validator.normalizeError(' abc')"];
+			XCTAssertTrue([result toBool], "Error of a call that returned YES is not thrown");
+
+			result = [context evaluateScript:@"try { validator.normalizeError(''); 'none' }"
+					  "catch(e) { e.message }"];
+			XCTAssertEqualObjects([result toString], @"Empty string", "Error of a call that returned NO is thrown");
+		}];
+	}
+}
+
+- (void)testPointerArgumentIsNotError
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			context[@"validator"] = [[ValidatingClass alloc] init];
+
+			XCTAssertTrue([[context evaluateScript:@"validator.isNullPointer(null)"] toBool],
+						  "A trailing id * is passed by the script");
+		}];
+	}
+}
+
+- (void)testThrownValue
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			L8Value *result;
+
+			context[@"validator"] = [[ValidatingClass alloc] init];
+
+			result = [context evaluateScript:@"validator.checkPositive(1)"];
+			XCTAssertEqual([result toDouble], 1.0, "Normal values are returned");
+
+			result = [context evaluateScript:@"try { validator.checkPositive(-1); 'none' }"
+					  "catch(e) { e.message }"];
+			XCTAssertEqualObjects([result toString], @"Not positive", "Thrown value is thrown");
+		}];
+	}
+}
+
+- (void)testEvaluateScriptError
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			NSError *error;
+			L8Value *result;
+
+			result = [context evaluateScript:@"1 + 1" error:&error];
+			XCTAssertEqual([result toInt32], 2, "Script evaluates");
+			XCTAssertNil(error, "No error on success");
+
+			XCTAssertNoThrow(result = [context evaluateScript:@"new Foo();" error:&error],
+							 "Exception is returned, not thrown");
+			XCTAssertNil(result, "No result on failure");
+			XCTAssertEqualObjects(error.domain, L8ErrorDomain, "Error domain");
+			XCTAssertEqual(error.code, (NSInteger)L8ErrorExceptionThrown, "Exception error code");
+			XCTAssertNotNil(error.userInfo[L8ExceptionErrorKey], "Error holds the exception");
+
+			[context evaluateScript:@"(" error:&error];
+			XCTAssertEqual(error.code, (NSInteger)L8ErrorCompilationFailed, "Compilation error code");
+		}];
+	}
+}
+
 - (void)testObjCToJS
 {
 	@autoreleasepool {
@@ -61,3 +159,55 @@
 }
 
 @end
+
+@implementation ValidatingClass
+
+- (NSString *)validate:(NSString *)string error:(NSError **)error
+{
+	if(string.length == 0) {
+		if(error)
+			*error = [NSError errorWithDomain:@"Validation"
+										 code:3
+									 userInfo:@{ NSLocalizedDescriptionKey: @"Empty string" }];
+		return nil;
+	}
+
+	return string;
+}
+
+- (BOOL)normalize:(NSString *)string error:(NSError **)error
+{
+	if(string.length == 0) {
+		if(error)
+			*error = [NSError errorWithDomain:@"Validation"
+										 code:3
+									 userInfo:@{ NSLocalizedDescriptionKey: @"Empty string" }];
+		return NO;
+	}
+
+	// Succeeds, but reports what was changed, like some Cocoa methods do
+	if(error && ![string isEqualToString:[string stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]]])
+		*error = [NSError errorWithDomain:@"Validation"
+									 code:4
+								 userInfo:@{ NSLocalizedDescriptionKey: @"Whitespace trimmed" }];
+
+	return YES;
+}
+
+- (BOOL)isNullPointer:(id *)pointer
+{
+	return pointer == NULL;
+}
+
+- (L8Value *)checkPositive:(double)number
+{
+	L8Context *context = [L8Context currentContext];
+
+	if(number < 0)
+		return [L8Value valueWithThrownValue:[L8Value valueWithNewErrorFromMessage:@"Not positive" inContext:context]
+								   inContext:context];
+
+	return [L8Value valueWithDouble:number inContext:context];
+}
+
+@end
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import <XCTest/XCTest.h>
+#import <L8Framework/L8Scope.h>
+#import "L8.h"
+
+@interface L8ScopeTests : XCTestCase @end
+
+@implementation L8ScopeTests
+
+- (void)testEvaluateAndGet
+{
+	@autoreleasepool {
+		L8Context *context = [[L8Context alloc] init];
+		L8Scope scope(context);
+		L8Local points;
+		double sum = 0;
+
+		points = scope.evaluate(@"[{x: 1}, {x: 2}, {x: 3}]");
+		XCTAssertTrue(points.isArray(), "Evaluating returns the result");
+		XCTAssertEqual(points.length(), 3u, "Length of an array");
+
+		for(uint32_t i = 0; i < points.length(); ++i)
+			sum += points.get(i).get("x").toDouble();
+		XCTAssertEqual(sum, 6.0, "Indexed and named properties are read");
+
+		XCTAssertTrue(points.get(3).isUndefined(), "Missing elements are undefined");
+		XCTAssertTrue(scope.number(1).get("x").isEmpty(), "Properties of non-objects are empty");
+		XCTAssertTrue(scope.evaluate(nil).isEmpty(), "Evaluating nil is empty");
+	}
+}
+
+- (void)testSet
+{
+	@autoreleasepool {
+		L8Context *context = [[L8Context alloc] init];
+		L8Scope scope(context);
+		L8Local object, array;
+
+		object = scope.newObject();
+		XCTAssertTrue(object.set("a", scope.number(2)), "Setting a named property");
+		XCTAssertTrue(object.set(0u, scope.string("zero")), "Setting an indexed property");
+		XCTAssertFalse(object.set("b", L8Local()), "Empty values are not set");
+
+		array = scope.newArray(2);
+		XCTAssertTrue(array.set(1u, scope.boolean(true)), "Setting an element");
+		XCTAssertTrue(array.get(1).toBool(), "Reading the element back");
+
+		scope.global().set("object", object);
+		XCTAssertEqualObjects(scope.evaluate(@"object.a + object[0] + object.b").toString(), @"2zeroundefined",
+							  "Properties are visible to scripts");
+	}
+}
+
+- (void)testCall
+{
+	@autoreleasepool {
+		L8Context *context = [[L8Context alloc] init];
+		L8Scope scope(context);
+		L8Local add, receiver, result;
+		L8Local arguments[2];
+
+		add = scope.evaluate(@"(function(a, b) { return this.base + a + b; })");
+		XCTAssertTrue(add.isFunction(), "Functions are functions");
+		XCTAssertFalse(add.isObject(), "Functions are not objects");
+
+		receiver = scope.newObject();
+		receiver.set("base", scope.number(1));
+		arguments[0] = scope.number(2);
+		arguments[1] = scope.number(3);
+
+		result = add.call(receiver, 2, arguments);
+		XCTAssertEqual(result.toDouble(), 6.0, "Calling a function with a receiver");
+
+		receiver.set("add", add);
+		XCTAssertEqual(receiver.invoke("add", 2, arguments).toInt32(), 6, "Invoking a method");
+
+		XCTAssertTrue(scope.number(1).call(scope.undefined(), 0, NULL).isEmpty(), "Calling a non-function is empty");
+	}
+}
+
+- (void)testCallException
+{
+	@autoreleasepool {
+		L8Context *context = [[L8Context alloc] init];
+		L8Scope scope(context);
+		L8Local thrower, result;
+		NSString *message = nil;
+
+		thrower = scope.evaluate(@"(function() { throw new Error('boom'); })");
+
+		@try {
+			result = thrower.call(scope.undefined(), 0, NULL);
+		} @catch(L8Exception *exception) {
+			message = exception.message;
+		}
+
+		XCTAssertTrue(result.isEmpty(), "A call that threw has no result");
+		XCTAssertTrue(message != nil && [message rangeOfString:@"boom"].location != NSNotFound,
+					  "The exception thrown by the function is reported");
+		XCTAssertEqual(scope.evaluate(@"1 + 1").toDouble(), 2.0, "The scope is usable after an exception");
+	}
+}
+
+- (void)testValueRoundTrip
+{
+	@autoreleasepool {
+		L8Context *context = [[L8Context alloc] init];
+		L8Value *value;
+
+		{
+			L8Scope scope(context);
+			L8Local array;
+
+			array = scope.evaluate(@"[1, 2, 3]");
+			value = scope.value(array);
+
+			XCTAssertNotNil(value, "An L8Value is created");
+			XCTAssertTrue(scope.local(value).V8Value()->StrictEquals(array.V8Value()), "local() returns the same value");
+			XCTAssertNil(scope.value(L8Local()), "Empty values have no L8Value");
+			XCTAssertTrue(scope.local(nil).isEmpty(), "nil has no local value");
+
+			XCTAssertEqualObjects(scope.fromObject(@"text").toString(), @"text", "Objects are converted");
+		}
+
+		XCTAssertEqual([value[2] toDouble], 3.0, "The L8Value outlives the scope");
+
+		{
+			L8Scope scope(context);
+
+			XCTAssertEqual(scope.local(value).length(), 3u, "The L8Value is used in a new scope");
+		}
+	}
+}
+
+@end
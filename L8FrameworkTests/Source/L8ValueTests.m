@@ -25,6 +25,7 @@
 
 #import <XCTest/XCTest.h>
 #import "L8Context.h"
+#import "L8VirtualMachine.h"
 #import "L8Value.h"
 #import "L8Export.h"
 
@@ -38,6 +39,9 @@
 - (void)methodWithStringArgument:(NSString *)argument;
 - (void)methodWithL8Argument:(L8Value *)argument;
 - (void)methodWithBlockArgument:(int (^)(NSString *data))argument;
+- (double)methodAddingDouble:(double)a toDouble:(double)b;
+- (NSString *)methodJoiningString:(NSString *)a withString:(NSString *)b;
++ (double)classMethodMultiplyingDouble:(double)a byDouble:(double)b;
 @end
 @interface CustomMethodClass : NSObject <CustomMethodClass> @end
 
@@ -47,6 +51,40 @@
 @end
 @interface CustomPropertiesClass : NSObject <CustomPropertiesClass> @end
 
+@protocol CountingAccessorsClass <L8Export>
+@property (nonatomic) double counted;
+@end
+@interface CountingAccessorsClass : NSObject <CountingAccessorsClass>
+@property (nonatomic,readonly) unsigned int getterCalls;
+@end
+@interface DirectCountingAccessorsClass : NSObject <CountingAccessorsClass, L8DirectIvarAccess>
+@property (nonatomic,readonly) unsigned int getterCalls;
+@end
+
+@interface CopyableObject : NSObject <NSCopying>
+@property (nonatomic,readonly) BOOL isCopy;
+@end
+
+@protocol DirectIvarClass <L8Export>
+@property (nonatomic) double scalar;
+@property (nonatomic) int integer;
+@property (nonatomic) BOOL flag;
+@property (nonatomic,strong) NSString *retained;
+@property (nonatomic,copy) CopyableObject *copied;
+@property (atomic) double atomicScalar;
+@property (atomic,strong) NSString *atomicObject;
+@end
+@interface DirectIvarClass : NSObject <DirectIvarClass, L8DirectIvarAccess> @end
+
+@interface KeyValueObserver : NSObject
+@property (nonatomic) unsigned int changes;
+@end
+
+@protocol ConstructManyClass <L8Export>
++ (double)constructMany;
+@end
+@interface ConstructManyClass : NSObject <ConstructManyClass> @end
+
 @protocol CustomPropertiesClassWithAttributes <L8Export>
 @property (strong,readonly) NSString *stringVal;
 @property (assign,getter=isHidden) BOOL hidden;
@@ -89,6 +127,22 @@ L8_EXPORT_AS_NO_ARGS(list,
 @interface RenameClass : NSObject <RenameClass>
 @end
 
+@protocol GeometryClass <L8Export>
+@property NSRect frame;
+- (NSPoint)pointByAddingPoint:(NSPoint)a toPoint:(NSPoint)b;
+- (NSRange)rangeOfLength:(NSUInteger)length;
+@end
+@interface GeometryClass : NSObject <GeometryClass>
+@end
+
+@protocol VectorClass <L8Export>
+- (double)sum:(const double *)values count:(NSUInteger)count;
+- (void)scale:(float *)values count:(NSUInteger)count by:(float)factor;
+- (NSUInteger)lengthOfRange:(NSRange *)range;
+@end
+@interface VectorClass : NSObject <VectorClass>
+@end
+
 @implementation L8ValueTests
 
 - (void)testStringValue
@@ -235,6 +289,30 @@ L8_EXPORT_AS_NO_ARGS(list,
 	}
 }
 
+- (void)testInlinePrimitives
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			NSUInteger handles = context.virtualMachine.liveHandles;
+			L8Value *number = [L8Value valueWithInt32:-1 inContext:context];
+			L8Value *fraction = [L8Value valueWithDouble:2.5 inContext:context];
+			L8Value *undefined = [L8Value valueWithUndefinedInContext:context];
+
+			XCTAssertEqual(context.virtualMachine.liveHandles, handles, "Primitives need no handle");
+
+			XCTAssertEqual([number toUInt32], 4294967295u, "-[toUInt32] wraps like JavaScript");
+			XCTAssertEqual([fraction toInt32], 2, "-[toInt32] truncates");
+			XCTAssertTrue(isnan([undefined toDouble]), "undefined is NaN");
+			XCTAssertFalse([undefined toBool], "undefined is false");
+
+			context[@"number"] = number;
+			XCTAssertTrue([[context evaluateScript:@"number === -1"] toBool], "Primitives convert to V8");
+			XCTAssertTrue([[context evaluateScript:@"typeof 1.5"] isString], "Type of a string");
+			XCTAssertTrue([[context evaluateScript:@"(function() {})"] isFunction], "Type of a function");
+		}];
+	}
+}
+
 - (void)testArrayValue
 {
 	@autoreleasepool {
@@ -379,6 +457,19 @@ L8_EXPORT_AS_NO_ARGS(list,
 
 			XCTAssertEqualObjects([retVal toNumber], @42, "-[invokeMethod:(int returning) withArguments:@[]]");
 			XCTAssertTrue([retVal isNumber], "-[retVal isNumber]");
+
+			retVal = [value invokeMethod:@"methodAddingDoubleToDouble" withArguments:@[@1.5, @2.25]];
+			XCTAssertEqual([retVal toDouble], 3.75, "-[invokeMethod:(double returning) withArguments:@[double, double]]");
+
+			retVal = [value invokeMethod:@"methodJoiningStringWithString" withArguments:@[@"Hello ", @"World"]];
+			XCTAssertEqualObjects([retVal toString], @"Hello World", "-[invokeMethod:(object returning) withArguments:@[object, object]]");
+
+			context[@"CustomMethodClass"] = [CustomMethodClass class];
+			retVal = [context evaluateScript:@"CustomMethodClass.classMethodMultiplyingDoubleByDouble(2, 3)"];
+			XCTAssertEqual([retVal toDouble], 6.0, "Class method call");
+
+			retVal = [context evaluateScript:@"var multiply = CustomMethodClass.classMethodMultiplyingDoubleByDouble; multiply(3, 4)"];
+			XCTAssertEqual([retVal toDouble], 12.0, "Class method call on a detached function");
 		}];
 	}
 }
@@ -402,12 +493,129 @@ L8_EXPORT_AS_NO_ARGS(list,
 			[context evaluateScript:@"object.stringVal = 'John';" withName:@""];
 			XCTAssertEqualObjects(object.stringVal, @"John", "Property setting in JavaScript");
 
+			object.doubleVal = 1.5;
+			retVal = [context evaluateScript:@"object.doubleVal = object.doubleVal * 2; object.doubleVal" withName:@""];
+			XCTAssertEqual([retVal toDouble], 3.0, "Scalar property getting in JavaScript");
+			XCTAssertEqual(object.doubleVal, 3.0, "Scalar property setting in JavaScript");
+
+			retVal = [context evaluateScript:@"try { object.doubleVal = 'text'; false } catch(e) { e instanceof TypeError }" withName:@""];
+			XCTAssertTrue([retVal toBool], "Setting a value that can not be converted throws");
+			XCTAssertEqual(object.doubleVal, 3.0, "A value that can not be converted is not set");
+
 			retVal = [context evaluateScript:@"object.notThere" withName:@""];
 			XCTAssertTrue([retVal isUndefined], "Invalid property getting in JavaScript");
 		}];
 	}
 }
 
+- (void)testDirectIvarAccessIsOptIn
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			CountingAccessorsClass *object = [[CountingAccessorsClass alloc] init];
+			DirectCountingAccessorsClass *direct = [[DirectCountingAccessorsClass alloc] init];
+
+			context[@"object"] = object;
+			context[@"direct"] = direct;
+
+			XCTAssertEqual([[context evaluateScript:@"object.counted = 2; object.counted"] toDouble], 2.0,
+						   "Property of a class without the marker");
+			XCTAssertEqual(object.getterCalls, 1u, "Without L8DirectIvarAccess, the hand-written getter is called");
+
+			XCTAssertEqual([[context evaluateScript:@"direct.counted = 3; direct.counted"] toDouble], 3.0,
+						   "Property of a class adopting L8DirectIvarAccess");
+			XCTAssertEqual(direct.getterCalls, 0u, "With L8DirectIvarAccess, the instance variable is read");
+			XCTAssertEqual(direct.counted, 3.0, "The instance variable is written");
+		}];
+	}
+}
+
+- (void)testDirectIvarAccess
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			DirectIvarClass *object = [[DirectIvarClass alloc] init];
+			CopyableObject *original = [[CopyableObject alloc] init];
+			L8Value *retVal;
+
+			context[@"object"] = object;
+			context[@"original"] = original;
+
+			// Scalars
+			object.scalar = 1.5;
+			XCTAssertEqual([[context evaluateScript:@"object.scalar = object.scalar * 2; object.scalar"] toDouble], 3.0,
+						   "Scalar read and written");
+			XCTAssertEqual(object.scalar, 3.0, "Scalar written to the instance variable");
+
+			XCTAssertEqual([[context evaluateScript:@"object.integer = -7; object.integer"] toInt32], -7,
+						   "Integer read and written");
+			XCTAssertEqual(object.integer, -7, "Integer written to the instance variable");
+
+			XCTAssertTrue([[context evaluateScript:@"object.flag = true; object.flag"] toBool], "BOOL read and written");
+			XCTAssertTrue(object.flag, "BOOL written to the instance variable");
+
+			retVal = [context evaluateScript:@"try { object.integer = 'text'; false } catch(e) { e instanceof TypeError }"];
+			XCTAssertTrue([retVal toBool], "A value that can not be converted throws");
+			XCTAssertEqual(object.integer, -7, "A value that can not be converted is not written");
+
+			retVal = [context evaluateScript:@"try { object.integer = 1e12; false } catch(e) { e instanceof RangeError }"];
+			XCTAssertTrue([retVal toBool], "A value out of range throws");
+			XCTAssertEqual(object.integer, -7, "A value out of range is not written");
+
+			// Retained objects
+			[context evaluateScript:@"object.retained = 'retained'"];
+			XCTAssertEqualObjects(object.retained, @"retained", "Retained object written");
+			XCTAssertEqualObjects([[context evaluateScript:@"object.retained"] toString], @"retained", "Retained object read");
+
+			[context evaluateScript:@"object.retained = undefined"];
+			XCTAssertNil(object.retained, "Retained object cleared");
+
+			// Copied objects
+			[context evaluateScript:@"object.copied = original"];
+			XCTAssertTrue(object.copied != original, "Copied property stores a copy");
+			XCTAssertTrue(object.copied.isCopy, "The copy is made with copyWithZone:");
+			XCTAssertTrue([[context evaluateScript:@"object.copied !== original"] toBool], "The copy is read back");
+
+			// Atomic properties
+			XCTAssertEqual([[context evaluateScript:@"object.atomicScalar = 4.25; object.atomicScalar"] toDouble], 4.25,
+						   "Atomic scalar read and written");
+			XCTAssertEqual(object.atomicScalar, 4.25, "Atomic scalar written to the instance variable");
+
+			[context evaluateScript:@"object.atomicObject = 'atomic'"];
+			XCTAssertEqualObjects(object.atomicObject, @"atomic", "Atomic object written");
+			XCTAssertEqualObjects([[context evaluateScript:@"object.atomicObject"] toString], @"atomic", "Atomic object read");
+		}];
+	}
+}
+
+- (void)testDirectIvarAccessObservedReceiver
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			DirectIvarClass *object = [[DirectIvarClass alloc] init];
+			KeyValueObserver *observer = [[KeyValueObserver alloc] init];
+
+			context[@"object"] = object;
+
+			// Bind the class before the object is observed
+			XCTAssertEqual([[context evaluateScript:@"object.scalar"] toDouble], 0.0, "Unobserved read");
+
+			[object addObserver:observer forKeyPath:@"scalar" options:0 context:NULL];
+
+			XCTAssertEqual([[context evaluateScript:@"object.scalar = 5; object.scalar"] toDouble], 5.0,
+						   "Observed property read and written");
+			XCTAssertEqual(object.scalar, 5.0, "Observed property written");
+			XCTAssertEqual(observer.changes, 1u, "Observers are notified: the setter is called");
+
+			[object removeObserver:observer forKeyPath:@"scalar"];
+
+			[context evaluateScript:@"object.scalar = 6"];
+			XCTAssertEqual(object.scalar, 6.0, "Property written after observing ends");
+			XCTAssertEqual(observer.changes, 1u, "Removed observers are not notified");
+		}];
+	}
+}
+
 - (void)testCustomObjectWithAttributedProperties
 {
 	@autoreleasepool {
@@ -434,6 +642,93 @@ L8_EXPORT_AS_NO_ARGS(list,
 	}
 }
 
+- (void)testBulkConstruction
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			L8Value *objects;
+
+			context[@"CustomPropertiesClass"] = [CustomPropertiesClass class];
+
+			objects = [context evaluateScript:@"CustomPropertiesClass.constructMany([[], [], []])"];
+			XCTAssertEqual([[objects toArray] count], (NSUInteger)3, "constructMany constructs an object per argument array");
+
+			[context evaluateScript:@"var objects = CustomPropertiesClass.constructMany([[], []]); objects[1].doubleVal = 2;"];
+			XCTAssertTrue([[objects[0] toObject] isKindOfClass:[CustomPropertiesClass class]], "Constructed objects are native objects");
+			XCTAssertEqual([[context evaluateScript:@"objects[1].doubleVal + objects[0].doubleVal"] toDouble], 2.0,
+						   "Constructed objects are distinct wrappers");
+			XCTAssertTrue([[context evaluateScript:@"new CustomPropertiesClass() instanceof CustomPropertiesClass"] toBool],
+						  "Constructing one object");
+
+			context[@"CustomMethodClass"] = [CustomMethodClass class];
+			XCTAssertTrue([[context evaluateScript:@"try { CustomPropertiesClass.constructMany.call(CustomMethodClass, [[]]); false }"
+							"catch(e) { e instanceof TypeError }"] toBool],
+						  "constructMany can not construct objects for another class");
+			XCTAssertTrue([[context evaluateScript:@"try { CustomPropertiesClass.constructMany.call({}, [[]]); false }"
+							"catch(e) { e instanceof TypeError }"] toBool],
+						  "constructMany must be called on a class");
+
+			context[@"ConstructManyClass"] = [ConstructManyClass class];
+			XCTAssertEqual([[context evaluateScript:@"ConstructManyClass.constructMany()"] toDouble], 7.0,
+						   "An exported class method named constructMany is kept");
+		}];
+	}
+}
+
+- (void)testStructValues
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			GeometryClass *geometry = [[GeometryClass alloc] init];
+
+			context[@"geometry"] = geometry;
+
+			XCTAssertEqual([[context evaluateScript:@"var p = geometry.pointByAddingPointToPoint({x: 1, y: 2}, {x: 3, y: 4}); p.x * 10 + p.y"] toDouble],
+						   46.0, "Struct arguments and returns are objects");
+			XCTAssertEqual([[context evaluateScript:@"geometry.pointByAddingPointToPoint([1, 2], [3, 4]).y"] toDouble],
+						   6.0, "Struct arguments can be arrays");
+			XCTAssertEqual([[context evaluateScript:@"var r = geometry.rangeOfLength(5); r.location + r.length"] toDouble],
+						   5.0, "NSRange has named fields");
+
+			[context evaluateScript:@"geometry.frame = {origin: {x: 1, y: 2}, size: {width: 3, height: 4}}"];
+			XCTAssertEqual(geometry.frame.size.height, 4.0, "Nested struct properties are set");
+			XCTAssertEqual([[context evaluateScript:@"geometry.frame.origin.y"] toDouble], 2.0, "Nested struct properties are read");
+
+			XCTAssertTrue([[context evaluateScript:@"try { geometry.pointByAddingPointToPoint(1, [3, 4]); false }"
+							"catch(e) { e instanceof TypeError }"] toBool],
+						  "Struct arguments that are not objects throw");
+			XCTAssertEqualObjects([[context evaluateScript:@"try { geometry.pointByAddingPointToPoint({get x() { throw new Error('x') }}, [3, 4]); 'none' }"
+									"catch(e) { e.message }"] toString], @"x",
+								  "Exceptions thrown reading struct fields are thrown");
+		}];
+	}
+}
+
+- (void)testPointerArguments
+{
+	@autoreleasepool {
+		[[[L8Context alloc] init] executeBlockInContext:^(L8Context *context) {
+			context[@"vector"] = [[VectorClass alloc] init];
+
+			XCTAssertEqual([[context evaluateScript:@"vector.sumCount(new Float64Array([1, 2, 3, 4]), 4)"] toDouble],
+						   10.0, "Typed arrays are passed to pointer arguments");
+			XCTAssertEqual([[context evaluateScript:@"vector.sumCount(new Float64Array([1, 2, 3, 4]).subarray(2), 2)"] toDouble],
+						   7.0, "The offset of a view is applied");
+			XCTAssertEqual([[context evaluateScript:@"var f = new Float32Array([1, 2]); vector.scaleCountBy(f, 2, 3); f[1]"] toDouble],
+						   6.0, "Native code writes to the buffer of the script");
+			XCTAssertEqual([[context evaluateScript:@"vector.sumCount(null, 0)"] toDouble],
+						   0.0, "null is passed as NULL");
+
+			XCTAssertTrue([[context evaluateScript:@"try { vector.sumCount(new Float32Array(2), 2); false } catch(e) { e instanceof TypeError }"] toBool],
+						  "Mismatching array types throw");
+			XCTAssertTrue([[context evaluateScript:@"try { vector.sumCount(new ArrayBuffer(12), 1); false } catch(e) { e instanceof RangeError }"] toBool],
+						  "Partial elements throw");
+			XCTAssertTrue([[context evaluateScript:@"try { vector.lengthOfRange(new Float64Array(2)); false } catch(e) { e instanceof TypeError }"] toBool],
+						  "Pointers to unsupported types throw");
+		}];
+	}
+}
+
 - (void)testCustomJSFunction
 {
 	@autoreleasepool {
@@ -547,6 +842,21 @@ L8_EXPORT_AS_NO_ARGS(list,
 	NSLog(@"The argument: %@",argument);
 }
 
+- (double)methodAddingDouble:(double)a toDouble:(double)b
+{
+	return a + b;
+}
+
+- (NSString *)methodJoiningString:(NSString *)a withString:(NSString *)b
+{
+	return [a stringByAppendingString:b];
+}
+
++ (double)classMethodMultiplyingDouble:(double)a byDouble:(double)b
+{
+	return a * b;
+}
+
 @end
 
 @implementation CustomPropertiesClass
@@ -611,4 +921,108 @@ L8_EXPORT_AS_NO_ARGS(list,
 	return [NSString stringWithFormat:@"<%@>",name];
 }
 
-@end
\ No newline at end of file
+@end
+
+@implementation GeometryClass
+@synthesize frame;
+
+- (NSPoint)pointByAddingPoint:(NSPoint)a toPoint:(NSPoint)b
+{
+	return NSMakePoint(a.x + b.x, a.y + b.y);
+}
+
+- (NSRange)rangeOfLength:(NSUInteger)length
+{
+	return NSMakeRange(0, length);
+}
+
+@end
+
+@implementation VectorClass
+
+- (double)sum:(const double *)values count:(NSUInteger)count
+{
+	double sum = 0.0;
+
+	for(NSUInteger i = 0; i < count; ++i)
+		sum += values[i];
+	return sum;
+}
+
+- (void)scale:(float *)values count:(NSUInteger)count by:(float)factor
+{
+	for(NSUInteger i = 0; i < count; ++i)
+		values[i] *= factor;
+}
+
+- (NSUInteger)lengthOfRange:(NSRange *)range
+{
+	return range->length;
+}
+
+@end
+
+@implementation ConstructManyClass
+
++ (double)constructMany
+{
+	return 7;
+}
+
+@end
+
+@implementation CountingAccessorsClass
+@synthesize counted = _counted;
+@synthesize getterCalls = _getterCalls;
+
+- (double)counted
+{
+	++_getterCalls;
+	return _counted;
+}
+
+@end
+
+@implementation DirectCountingAccessorsClass
+@synthesize counted = _counted;
+@synthesize getterCalls = _getterCalls;
+
+// Hand-written: skipped because the class adopts L8DirectIvarAccess
+- (double)counted
+{
+	++_getterCalls;
+	return _counted;
+}
+
+@end
+
+@implementation CopyableObject
+@synthesize isCopy = _isCopy;
+
+- (id)copyWithZone:(NSZone *)zone
+{
+	CopyableObject *copy = [[CopyableObject allocWithZone:zone] init];
+
+	copy->_isCopy = YES;
+
+	return copy;
+}
+
+@end
+
+@implementation DirectIvarClass
+@synthesize scalar, integer, flag, retained, copied, atomicScalar, atomicObject;
+@end
+
+@implementation KeyValueObserver
+@synthesize changes;
+
+- (void)observeValueForKeyPath:(NSString *)keyPath
+					  ofObject:(id)object
+						change:(NSDictionary *)change
+					   context:(void *)context
+{
+	++changes;
+}
+
+@end
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+@class LGNHeaderParser;
+
+/**
+ * @brief Writer of the generated bindings.
+ *
+ * For every class adopting an exported protocol, the writer emits a
+ * callback per exported method and property that calls the
+ * implementation directly, and an installer that is registered with
+ * L8RegisterBinding() when the image is loaded.
+ */
+@interface LGNBindingWriter : NSObject
+
+/**
+ * Create a writer.
+ *
+ * @param parser A parser containing the parsed headers.
+ * @param headers Paths of the headers to import in the output.
+ */
+- (instancetype)initWithParser:(LGNHeaderParser *)parser headers:(NSArray *)headers;
+
+/**
+ * Generate the Objective-C++ source for the bindings.
+ *
+ * Classes with members that can not be bound are skipped with a warning
+ * and keep using the reflection-based binding.
+ *
+ * @return The source text.
+ */
+- (NSString *)generate;
+
+@end
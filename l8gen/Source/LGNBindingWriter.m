@@ -0,0 +1,315 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "LGNBindingWriter.h"
+#import "LGNHeaderParser.h"
+
+@implementation LGNBindingWriter {
+	LGNHeaderParser *_parser;
+	NSArray *_headers;
+}
+
+- (instancetype)initWithParser:(LGNHeaderParser *)parser headers:(NSArray *)headers
+{
+	self = [super init];
+	if(self) {
+		_parser = parser;
+		_headers = headers;
+	}
+	return self;
+}
+
+#pragma mark - Naming
+
+static NSString *lgn_identifier(NSString *string)
+{
+	return [string stringByReplacingOccurrencesOfString:@":" withString:@"_"];
+}
+
+static NSString *lgn_callback_name(NSString *className, NSString *kind, NSString *name)
+{
+	return [NSString stringWithFormat:@"l8gen_%@_%@_%@",className,kind,lgn_identifier(name)];
+}
+
+#pragma mark - Conversion
+
+/**
+ * Expression converting argument i of the callback info.
+ */
+static NSString *lgn_argument_expression(LGNType *type, NSString *value)
+{
+	switch(type.kind) {
+		case LGNTypeKindObject:
+			if(type.className)
+				return [NSString stringWithFormat:@"L8BindingToObject(isolate, [%@ class], %@)",type.className,value];
+			return [NSString stringWithFormat:@"L8BindingToObject(isolate, Nil, %@)",value];
+		case LGNTypeKindNumber:
+			// Range checked like reflected arguments: casting NaN or large doubles is undefined
+			if(type.isInteger)
+				return [NSString stringWithFormat:@"(%@)L8BindingToInteger(isolate, %@, @encode(%@))",
+						type.declaration,value,type.declaration];
+			return [NSString stringWithFormat:@"(%@)L8BindingToNumber(isolate, %@)",type.declaration,value];
+		case LGNTypeKindBool:
+			return [NSString stringWithFormat:@"(%@)%@->BooleanValue()",type.declaration,value];
+		default:
+			return nil;
+	}
+}
+
+/**
+ * Expression converting a native result to a JavaScript value.
+ */
+static NSString *lgn_return_expression(LGNType *type, NSString *value)
+{
+	switch(type.kind) {
+		case LGNTypeKindObject:
+			return [NSString stringWithFormat:@"L8BindingFromObject(isolate, %@)",value];
+		case LGNTypeKindNumber:
+			return [NSString stringWithFormat:@"v8::Number::New(isolate, (double)%@)",value];
+		case LGNTypeKindBool:
+			return [NSString stringWithFormat:@"v8::Boolean::New(isolate, %@)",value];
+		default:
+			return nil;
+	}
+}
+
+/**
+ * A message expression with the converted arguments.
+ */
+static NSString *lgn_message_expression(NSString *receiver, LGNMethod *method)
+{
+	NSArray *parts = [method.selector componentsSeparatedByString:@":"];
+
+	if(method.argumentTypes.count == 0)
+		return [NSString stringWithFormat:@"[%@ %@]",receiver,method.selector];
+
+	NSMutableString *message = [NSMutableString stringWithFormat:@"[%@",receiver];
+	for(NSUInteger i = 0; i < method.argumentTypes.count; ++i) {
+		NSString *value = [NSString stringWithFormat:@"info[%lu]",(unsigned long)i];
+		[message appendFormat:@" %@:%@",parts[i],lgn_argument_expression(method.argumentTypes[i], value)];
+	}
+	[message appendString:@"]"];
+
+	return message;
+}
+
+#pragma mark - Output
+
+- (void)writeMethod:(LGNMethod *)method ofClass:(LGNClass *)cls toString:(NSMutableString *)output
+{
+	NSString *receiver = method.isClassMethod ? cls.name : @"receiver";
+	NSString *message = lgn_message_expression(receiver, method);
+
+	[output appendFormat:@"static void %@(const v8::FunctionCallbackInfo<v8::Value>& info)\n{\n",
+	 lgn_callback_name(cls.name, method.isClassMethod ? @"class" : @"method", method.selector)];
+	[output appendString:@"\tv8::Isolate *isolate = info.GetIsolate();\n"];
+	[output appendString:@"\tL8BindingCallScope scope(info);\n"];
+	[output appendString:@"\tL8BindingAutoreleaseScope autoreleaseScope(isolate);\n\n"];
+	[output appendString:@"\t@try {\n"];
+
+	if(!method.isClassMethod)
+		[output appendFormat:@"\t\t%@ *receiver = L8BindingUnwrap(info.This());\n",cls.name];
+
+	if(method.returnType.kind == LGNTypeKindVoid)
+		[output appendFormat:@"\t\t%@;\n",message];
+	else {
+		[output appendFormat:@"\t\t%@ result = %@;\n",method.returnType.declaration,message];
+		[output appendFormat:@"\t\tinfo.GetReturnValue().Set(%@);\n",
+		 lgn_return_expression(method.returnType, @"result")];
+	}
+
+	[output appendString:@"\t} @catch(id exception) {\n"];
+	[output appendString:@"\t\tL8BindingThrow(isolate, exception);\n"];
+	[output appendString:@"\t}\n}\n\n"];
+}
+
+- (void)writeProperty:(LGNProperty *)property ofClass:(LGNClass *)cls toString:(NSMutableString *)output
+{
+	[output appendFormat:@"static void %@(v8::Local<v8::String> property, const v8::PropertyCallbackInfo<v8::Value>& info)\n{\n",
+	 lgn_callback_name(cls.name, @"get", property.name)];
+	[output appendString:@"\tv8::Isolate *isolate = info.GetIsolate();\n"];
+	[output appendString:@"\tL8BindingAutoreleaseScope autoreleaseScope(isolate);\n\n"];
+	[output appendString:@"\t@try {\n"];
+	[output appendFormat:@"\t\t%@ *receiver = L8BindingUnwrap(info.Holder());\n",cls.name];
+	[output appendFormat:@"\t\t%@ result = [receiver %@];\n",property.type.declaration,property.getter];
+	[output appendFormat:@"\t\tinfo.GetReturnValue().Set(%@);\n",lgn_return_expression(property.type, @"result")];
+	[output appendString:@"\t} @catch(id exception) {\n"];
+	[output appendString:@"\t\tL8BindingThrow(isolate, exception);\n"];
+	[output appendString:@"\t}\n}\n\n"];
+
+	if(property.isReadonly)
+		return;
+
+	[output appendFormat:@"static void %@(v8::Local<v8::String> property, v8::Local<v8::Value> value, const v8::PropertyCallbackInfo<void>& info)\n{\n",
+	 lgn_callback_name(cls.name, @"set", property.name)];
+	[output appendString:@"\tv8::Isolate *isolate = info.GetIsolate();\n"];
+	[output appendString:@"\tL8BindingAutoreleaseScope autoreleaseScope(isolate);\n\n"];
+	[output appendString:@"\t@try {\n"];
+	[output appendFormat:@"\t\t%@ *receiver = L8BindingUnwrap(info.Holder());\n",cls.name];
+	[output appendFormat:@"\t\t[receiver %@%@];\n",property.setter,lgn_argument_expression(property.type, @"value")];
+	[output appendString:@"\t} @catch(id exception) {\n"];
+	[output appendString:@"\t\tL8BindingThrow(isolate, exception);\n"];
+	[output appendString:@"\t}\n}\n\n"];
+}
+
+- (void)writeInstallerForClass:(LGNClass *)cls
+					   methods:(NSArray *)methods
+					properties:(NSArray *)properties
+					  toString:(NSMutableString *)output
+{
+	[output appendFormat:@"static void l8gen_%@_install(v8::Isolate *isolate, v8::Local<v8::FunctionTemplate> classTemplate)\n{\n",cls.name];
+	[output appendString:@"\tv8::Local<v8::ObjectTemplate> prototypeTemplate = classTemplate->PrototypeTemplate();\n"];
+	[output appendString:@"\tv8::Local<v8::AccessorSignature> signature = v8::AccessorSignature::New(isolate, classTemplate);\n\n"];
+
+	for(LGNMethod *method in methods) {
+		NSString *callback = lgn_callback_name(cls.name, method.isClassMethod ? @"class" : @"method", method.selector);
+		[output appendFormat:@"\t%@->Set(v8::String::NewFromUtf8(isolate, \"%@\"),\n\t\tv8::FunctionTemplate::New(isolate, %@));\n",
+		 method.isClassMethod ? @"classTemplate" : @"prototypeTemplate",method.javaScriptName,callback];
+	}
+
+	for(LGNProperty *property in properties) {
+		[output appendFormat:@"\tprototypeTemplate->SetAccessor(v8::String::NewFromUtf8(isolate, \"%@\"),\n",property.name];
+		[output appendFormat:@"\t\t%@, %@,\n",lgn_callback_name(cls.name, @"get", property.name),
+		 property.isReadonly ? @"0" : lgn_callback_name(cls.name, @"set", property.name)];
+		[output appendFormat:@"\t\tv8::Handle<v8::Value>(), v8::AccessControl::DEFAULT, %@, signature);\n",
+		 property.isReadonly ? @"v8::PropertyAttribute::ReadOnly" : @"v8::PropertyAttribute::None"];
+	}
+
+	[output appendString:@"}\n\n"];
+}
+
+/**
+ * The names of the export protocols covered by the installer of a class,
+ * passed to L8RegisterBinding().
+ */
+- (void)writeProtocolListForClass:(LGNClass *)cls protocols:(NSArray *)protocols toString:(NSMutableString *)output
+{
+	[output appendFormat:@"static const char *const l8gen_%@_protocols[] = {",cls.name];
+	for(LGNProtocol *protocol in protocols)
+		[output appendFormat:@" \"%@\",",protocol.name];
+	[output appendString:@" NULL };\n\n"];
+}
+
+/**
+ * Collect the members of the exported protocols of a class.
+ *
+ * @return NO if a member can not be bound, or the class can not be bound
+ * without runtime reflection.
+ */
+- (BOOL)collectMembersOfClass:(LGNClass *)cls
+					  methods:(NSMutableArray *)methods
+				   properties:(NSMutableArray *)properties
+					protocols:(NSArray **)protocols
+{
+	NSMutableSet *accessors = [NSMutableSet set];
+	NSMutableSet *selectors = [NSMutableSet set];
+	NSString *unresolved = nil;
+
+	// Members of a protocol that was not parsed would silently disappear
+	*protocols = [_parser exportedProtocolsOfClass:cls unresolvedProtocol:&unresolved];
+	if(*protocols == nil) {
+		fprintf(stderr, "l8gen: warning: %s: protocol %s is not declared in the given headers, skipping\n",
+				cls.name.UTF8String, unresolved.UTF8String);
+		return NO;
+	}
+
+	if([_parser isLazyClass:cls]) {
+		fprintf(stderr, "l8gen: warning: %s: lazy classes are bound using reflection, skipping\n",
+				cls.name.UTF8String);
+		return NO;
+	}
+
+	for(LGNProtocol *protocol in *protocols) {
+		if(protocol.hasUnsupportedMembers) {
+			fprintf(stderr, "l8gen: warning: %s: protocol %s has members that can not be bound, skipping\n",
+					cls.name.UTF8String, protocol.name.UTF8String);
+			return NO;
+		}
+
+		for(LGNProperty *property in protocol.properties) {
+			[properties addObject:property];
+			[accessors addObject:property.getter];
+			[accessors addObject:property.setter];
+		}
+	}
+
+	for(LGNProtocol *protocol in *protocols) {
+		for(LGNMethod *method in protocol.methods) {
+			// Initializers are handled by the constructor, accessors by the properties
+			if([method.selector hasPrefix:@"init"] || [accessors containsObject:method.selector])
+				continue;
+			if([selectors containsObject:method.selector])
+				continue;
+
+			[selectors addObject:method.selector];
+			[methods addObject:method];
+		}
+	}
+
+	return YES;
+}
+
+- (NSString *)generate
+{
+	NSMutableString *output = [NSMutableString string];
+	NSMutableArray *registered = [NSMutableArray array];
+
+	[output appendString:@"/*\n * Generated by l8gen. Do not edit.\n */\n\n"];
+	for(NSString *header in _headers)
+		[output appendFormat:@"#import \"%@\"\n",header];
+	[output appendString:@"#import <L8Framework/L8Binding.h>\n#import <objc/runtime.h>\n\n"];
+
+	for(LGNClass *cls in _parser.classes) {
+		NSMutableArray *methods = [NSMutableArray array];
+		NSMutableArray *properties = [NSMutableArray array];
+		NSArray *protocols = nil;
+
+		if(![self collectMembersOfClass:cls methods:methods properties:properties protocols:&protocols])
+			continue;
+		if(methods.count == 0 && properties.count == 0)
+			continue;
+
+		[output appendFormat:@"#pragma mark - %@\n\n",cls.name];
+
+		for(LGNMethod *method in methods)
+			[self writeMethod:method ofClass:cls toString:output];
+		for(LGNProperty *property in properties)
+			[self writeProperty:property ofClass:cls toString:output];
+
+		[self writeInstallerForClass:cls methods:methods properties:properties toString:output];
+		[self writeProtocolListForClass:cls protocols:protocols toString:output];
+		[registered addObject:cls.name];
+	}
+
+	[output appendString:@"__attribute__((constructor))\nstatic void l8gen_register_bindings(void)\n{\n"];
+	for(NSString *className in registered)
+		[output appendFormat:@"\tL8RegisterBinding(objc_getClass(\"%@\"), l8gen_%@_install, l8gen_%@_protocols);\n",
+		 className,className,className];
+	[output appendString:@"}\n"];
+
+	return output;
+}
+
+@end
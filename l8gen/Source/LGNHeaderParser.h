@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * Kind of a type in an exported declaration.
+ */
+typedef NS_ENUM(NSInteger, LGNTypeKind) {
+	/// A type that can not be bound: the class is left to runtime reflection.
+	LGNTypeKindUnsupported,
+	LGNTypeKindVoid,
+	LGNTypeKindObject,
+	LGNTypeKindNumber,
+	LGNTypeKindBool
+};
+
+/**
+ * @brief A type used in an exported method or property.
+ */
+@interface LGNType : NSObject
+
+/// The type as declared, without qualifiers.
+@property (nonatomic,readonly) NSString *declaration;
+
+/// The kind of the type.
+@property (nonatomic,readonly) LGNTypeKind kind;
+
+/// Whether a number type is an integer type.
+@property (nonatomic,readonly,getter=isInteger) BOOL integer;
+
+/// Name of the class for object pointers, or nil for id.
+@property (nonatomic,readonly) NSString *className;
+
++ (instancetype)typeWithDeclaration:(NSString *)declaration;
+
+@end
+
+/**
+ * @brief An exported method.
+ */
+@interface LGNMethod : NSObject
+
+/// The selector, such as doFoo:withBar:
+@property (nonatomic,copy) NSString *selector;
+
+/// Name of the method in JavaScript.
+@property (nonatomic,copy) NSString *javaScriptName;
+
+@property (nonatomic,strong) LGNType *returnType;
+
+/// LGNType for each argument.
+@property (nonatomic,strong) NSArray *argumentTypes;
+
+@property (nonatomic,assign,getter=isClassMethod) BOOL classMethod;
+
+@end
+
+/**
+ * @brief An exported property.
+ */
+@interface LGNProperty : NSObject
+
+@property (nonatomic,copy) NSString *name;
+@property (nonatomic,strong) LGNType *type;
+@property (nonatomic,copy) NSString *getter;
+@property (nonatomic,copy) NSString *setter;
+@property (nonatomic,assign,getter=isReadonly) BOOL readonly;
+
+@end
+
+/**
+ * @brief A protocol declaration.
+ */
+@interface LGNProtocol : NSObject
+
+@property (nonatomic,copy) NSString *name;
+
+/// Names of the protocols this protocol adopts.
+@property (nonatomic,strong) NSArray *parentNames;
+
+/// The required methods declared in the protocol itself.
+@property (nonatomic,strong) NSArray *methods;
+
+/// The properties declared in the protocol itself.
+@property (nonatomic,strong) NSArray *properties;
+
+/// Whether a member could not be parsed or bound.
+@property (nonatomic,assign) BOOL hasUnsupportedMembers;
+
+@end
+
+/**
+ * @brief A class interface declaration.
+ */
+@interface LGNClass : NSObject
+
+@property (nonatomic,copy) NSString *name;
+
+/// Names of the protocols adopted by the class.
+@property (nonatomic,strong) NSArray *protocolNames;
+
+@end
+
+/**
+ * @brief Parser for the exported declarations in headers.
+ *
+ * The parser understands protocol and class interface declarations,
+ * method and property declarations, and the L8_EXPORT_AS renaming macros.
+ * It does not run the preprocessor.
+ */
+@interface LGNHeaderParser : NSObject
+
+/// All parsed protocols, by name.
+@property (nonatomic,readonly) NSDictionary *protocols;
+
+/// All parsed classes (LGNClass).
+@property (nonatomic,readonly) NSArray *classes;
+
+/**
+ * Parse a header file.
+ *
+ * @param path Path of the header.
+ * @param error Set when the file could not be read.
+ * @return YES on success, NO otherwise.
+ */
+- (BOOL)parseFileAtPath:(NSString *)path error:(NSError **)error;
+
+/**
+ * Parse the contents of a header.
+ *
+ * @param contents The source text.
+ */
+- (void)parseContents:(NSString *)contents;
+
+/**
+ * Get whether a protocol is exported: it adopts L8Export,
+ * directly or through one of its parents.
+ */
+- (BOOL)isExportedProtocol:(NSString *)name;
+
+/**
+ * Get the exported protocols adopted by a class.
+ *
+ * A protocol that was not parsed might be exported, so its members can
+ * not be known. NSObject is never exported and need not be parsed.
+ *
+ * @param unresolved Set to the name of the first adopted protocol that
+ * was not parsed.
+ * @return An array of LGNProtocol, or nil when a protocol is unresolved.
+ */
+- (NSArray *)exportedProtocolsOfClass:(LGNClass *)cls unresolvedProtocol:(NSString **)unresolved;
+
+/**
+ * Get whether a class adopts L8LazyExport, directly or through
+ * one of its exported protocols.
+ */
+- (BOOL)isLazyClass:(LGNClass *)cls;
+
+@end
@@ -0,0 +1,649 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "LGNHeaderParser.h"
+
+@implementation LGNType
+
++ (instancetype)typeWithDeclaration:(NSString *)declaration
+{
+	LGNType *type = [[LGNType alloc] init];
+	[type parseDeclaration:declaration];
+	return type;
+}
+
+- (void)parseDeclaration:(NSString *)declaration
+{
+	static NSSet *floatTypes = nil, *integerTypes = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		floatTypes = [NSSet setWithObjects:@"double",@"float",@"CGFloat",@"NSTimeInterval",nil];
+		integerTypes = [NSSet setWithObjects:@"int",@"unsigned",@"unsigned int",@"short",@"unsigned short",
+						@"long",@"unsigned long",@"long long",@"unsigned long long",
+						@"NSInteger",@"NSUInteger",@"int8_t",@"uint8_t",@"int16_t",@"uint16_t",
+						@"int32_t",@"uint32_t",@"int64_t",@"uint64_t",nil];
+	});
+
+	NSMutableArray *words = [NSMutableArray array];
+	for(NSString *word in [declaration componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceCharacterSet]]) {
+		if(word.length == 0)
+			continue;
+		if([@[@"const",@"in",@"out",@"inout",@"bycopy",@"byref",@"oneway",
+			  @"__strong",@"__weak",@"__unsafe_unretained",@"__autoreleasing",
+			  @"nonnull",@"nullable",@"_Nonnull",@"_Nullable"] containsObject:word])
+			continue;
+		[words addObject:word];
+	}
+
+	NSString *type = [words componentsJoinedByString:@" "];
+	type = [type stringByReplacingOccurrencesOfString:@" *" withString:@"*"];
+	_declaration = [type stringByReplacingOccurrencesOfString:@"*" withString:@" *"];
+	_kind = LGNTypeKindUnsupported;
+
+	if([type isEqualToString:@"void"])
+		_kind = LGNTypeKindVoid;
+	else if([type isEqualToString:@"BOOL"] || [type isEqualToString:@"bool"])
+		_kind = LGNTypeKindBool;
+	else if([floatTypes containsObject:type])
+		_kind = LGNTypeKindNumber;
+	else if([integerTypes containsObject:type]) {
+		_kind = LGNTypeKindNumber;
+		_integer = YES;
+	}
+	else if([type isEqualToString:@"id"] || [type hasPrefix:@"id<"] || [type hasPrefix:@"id <"]) {
+		_kind = LGNTypeKindObject;
+		_declaration = @"id";
+	} else if([type hasSuffix:@"*"] && ![type hasSuffix:@"**"]) {
+		NSString *name = [type substringToIndex:type.length - 1];
+		NSRange generic = [name rangeOfString:@"<"];
+		if(generic.location != NSNotFound)
+			name = [name substringToIndex:generic.location];
+
+		unichar first = name.length ? [name characterAtIndex:0] : 0;
+		if(first >= 'A' && first <= 'Z'
+		   && [name rangeOfCharacterFromSet:[[NSCharacterSet alphanumericCharacterSet] invertedSet]].location == NSNotFound) {
+			_kind = LGNTypeKindObject;
+			_className = name;
+			_declaration = [name stringByAppendingString:@" *"];
+		}
+	}
+}
+
+@end
+
+@implementation LGNMethod
+@end
+
+@implementation LGNProperty
+@end
+
+@implementation LGNProtocol
+@end
+
+@implementation LGNClass
+@end
+
+#pragma mark - Scanning helpers
+
+/**
+ * Remove comments and preprocessor lines.
+ */
+static NSString *lgn_strip_source(NSString *contents)
+{
+	NSMutableString *result = [NSMutableString stringWithCapacity:contents.length];
+	NSUInteger length = contents.length;
+	BOOL lineStart = YES;
+
+	for(NSUInteger i = 0; i < length; ++i) {
+		unichar c = [contents characterAtIndex:i];
+		unichar next = i + 1 < length ? [contents characterAtIndex:i + 1] : 0;
+
+		if(c == '/' && next == '/') {
+			while(i < length && [contents characterAtIndex:i] != '\n')
+				++i;
+			[result appendString:@"\n"];
+			lineStart = YES;
+			continue;
+		}
+
+		if(c == '/' && next == '*') {
+			i += 2;
+			while(i + 1 < length && !([contents characterAtIndex:i] == '*' && [contents characterAtIndex:i + 1] == '/'))
+				++i;
+			++i;
+			[result appendString:@" "];
+			continue;
+		}
+
+		if(c == '#' && lineStart) {
+			// Skip the directive, including continued lines
+			while(i < length) {
+				unichar d = [contents characterAtIndex:i];
+				if(d == '\n' && [contents characterAtIndex:i - 1] != '\\')
+					break;
+				++i;
+			}
+			[result appendString:@"\n"];
+			continue;
+		}
+
+		if(c == '\n')
+			lineStart = YES;
+		else if(c != ' ' && c != '\t')
+			lineStart = NO;
+
+		[result appendFormat:@"%C",c];
+	}
+
+	return result;
+}
+
+/**
+ * Find the index just after the parenthesis matching the one at index.
+ */
+static NSUInteger lgn_skip_parens(NSString *string, NSUInteger index)
+{
+	NSInteger depth = 0;
+	NSUInteger length = string.length;
+
+	for(; index < length; ++index) {
+		unichar c = [string characterAtIndex:index];
+		if(c == '(')
+			++depth;
+		else if(c == ')' && --depth == 0)
+			return index + 1;
+	}
+
+	return NSNotFound;
+}
+
+static NSString *lgn_trim(NSString *string)
+{
+	return [string stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+}
+
+static NSString *lgn_javascript_name(NSString *selector)
+{
+	NSArray *parts = [selector componentsSeparatedByString:@":"];
+	NSMutableString *name = [NSMutableString stringWithString:parts[0]];
+
+	for(NSUInteger i = 1; i < parts.count; ++i) {
+		NSString *part = parts[i];
+		if(part.length == 0)
+			continue;
+		[name appendString:[[part substringToIndex:1] uppercaseString]];
+		[name appendString:[part substringFromIndex:1]];
+	}
+
+	return name;
+}
+
+#pragma mark - Parser
+
+@implementation LGNHeaderParser {
+	NSMutableDictionary *_protocols;
+	NSMutableArray *_classes;
+}
+
+- (instancetype)init
+{
+	self = [super init];
+	if(self) {
+		_protocols = [NSMutableDictionary dictionary];
+		_classes = [NSMutableArray array];
+	}
+	return self;
+}
+
+- (NSDictionary *)protocols
+{
+	return _protocols;
+}
+
+- (NSArray *)classes
+{
+	return _classes;
+}
+
+- (BOOL)parseFileAtPath:(NSString *)path error:(NSError **)error
+{
+	NSString *contents = [NSString stringWithContentsOfFile:path
+												   encoding:NSUTF8StringEncoding
+													  error:error];
+	if(!contents)
+		return NO;
+
+	[self parseContents:contents];
+	return YES;
+}
+
+- (void)parseContents:(NSString *)contents
+{
+	NSScanner *scanner = [NSScanner scannerWithString:lgn_strip_source(contents)];
+	scanner.charactersToBeSkipped = nil;
+
+	while(!scanner.isAtEnd) {
+		[scanner scanUpToString:@"@" intoString:NULL];
+		if(scanner.isAtEnd)
+			break;
+
+		if([scanner scanString:@"@protocol" intoString:NULL])
+			[self parseProtocolWithScanner:scanner];
+		else if([scanner scanString:@"@interface" intoString:NULL])
+			[self parseInterfaceWithScanner:scanner];
+		else
+			scanner.scanLocation++;
+	}
+}
+
+- (NSArray *)namesInAngleBracketsWithScanner:(NSScanner *)scanner
+{
+	NSString *list = nil;
+
+	[scanner scanCharactersFromSet:[NSCharacterSet whitespaceAndNewlineCharacterSet] intoString:NULL];
+	if(![scanner scanString:@"<" intoString:NULL])
+		return @[];
+	[scanner scanUpToString:@">" intoString:&list];
+	[scanner scanString:@">" intoString:NULL];
+
+	NSMutableArray *names = [NSMutableArray array];
+	for(NSString *name in [list componentsSeparatedByString:@","]) {
+		NSString *trimmed = lgn_trim(name);
+		if(trimmed.length)
+			[names addObject:trimmed];
+	}
+	return names;
+}
+
+- (void)parseProtocolWithScanner:(NSScanner *)scanner
+{
+	NSCharacterSet *whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+	NSString *name = nil;
+
+	[scanner scanCharactersFromSet:whitespace intoString:NULL];
+	if(![scanner scanCharactersFromSet:[NSCharacterSet alphanumericCharacterSet] intoString:&name])
+		return;
+
+	NSUInteger location = scanner.scanLocation;
+	[scanner scanCharactersFromSet:whitespace intoString:NULL];
+
+	// Forward declaration (@protocol A;) or protocol expression (@protocol(A))
+	if([scanner scanString:@";" intoString:NULL] || [scanner scanString:@"," intoString:NULL])
+		return;
+	scanner.scanLocation = location;
+
+	LGNProtocol *protocol = [[LGNProtocol alloc] init];
+	protocol.name = name;
+	protocol.parentNames = [self namesInAngleBracketsWithScanner:scanner];
+
+	NSString *body = nil;
+	[scanner scanUpToString:@"@end" intoString:&body];
+	[scanner scanString:@"@end" intoString:NULL];
+
+	[self parseProtocolBody:body ?: @"" intoProtocol:protocol];
+	_protocols[name] = protocol;
+}
+
+- (void)parseInterfaceWithScanner:(NSScanner *)scanner
+{
+	NSCharacterSet *whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+	NSCharacterSet *identifier = [NSCharacterSet alphanumericCharacterSet];
+	NSString *name = nil;
+
+	[scanner scanCharactersFromSet:whitespace intoString:NULL];
+	if(![scanner scanCharactersFromSet:identifier intoString:&name])
+		return;
+	[scanner scanCharactersFromSet:whitespace intoString:NULL];
+
+	// Categories and class extensions are not bound
+	if([scanner scanString:@"(" intoString:NULL]) {
+		[scanner scanUpToString:@"@end" intoString:NULL];
+		return;
+	}
+
+	if([scanner scanString:@":" intoString:NULL]) {
+		[scanner scanCharactersFromSet:whitespace intoString:NULL];
+		[scanner scanCharactersFromSet:identifier intoString:NULL];
+	}
+
+	LGNClass *cls = [[LGNClass alloc] init];
+	cls.name = name;
+	cls.protocolNames = [self namesInAngleBracketsWithScanner:scanner];
+	[_classes addObject:cls];
+
+	[scanner scanUpToString:@"@end" intoString:NULL];
+}
+
+/**
+ * Split a protocol body into declarations, expanding the export macros.
+ */
+- (void)parseProtocolBody:(NSString *)body intoProtocol:(LGNProtocol *)protocol
+{
+	NSMutableArray *methods = [NSMutableArray array];
+	NSMutableArray *properties = [NSMutableArray array];
+	NSMutableDictionary *renames = [NSMutableDictionary dictionary];
+	BOOL required = YES;
+	NSUInteger length = body.length;
+	NSUInteger start = 0;
+
+	for(NSUInteger i = 0; i <= length; ++i) {
+		unichar c = i < length ? [body characterAtIndex:i] : ';';
+
+		if(c == '(') {
+			NSUInteger end = lgn_skip_parens(body, i);
+			if(end == NSNotFound)
+				break;
+			i = end - 1;
+			continue;
+		}
+
+		if(c != ';' && c != '@')
+			continue;
+
+		NSString *declaration = lgn_trim([body substringWithRange:NSMakeRange(start, i - start)]);
+
+		if(c == '@') {
+			if([body rangeOfString:@"@optional" options:NSAnchoredSearch range:NSMakeRange(i, length - i)].location != NSNotFound) {
+				required = NO;
+				start = i + 9;
+				i = start - 1;
+				continue;
+			}
+			if([body rangeOfString:@"@required" options:NSAnchoredSearch range:NSMakeRange(i, length - i)].location != NSNotFound) {
+				required = YES;
+				start = i + 9;
+				i = start - 1;
+				continue;
+			}
+			if([body rangeOfString:@"@property" options:NSAnchoredSearch range:NSMakeRange(i, length - i)].location == NSNotFound)
+				continue;
+
+			// A property starts a new declaration; there is nothing before it
+			start = i;
+			continue;
+		}
+
+		start = i + 1;
+
+		if(declaration.length == 0 || !required)
+			continue;
+
+		if([declaration hasPrefix:@"L8_EXPORT_AS"]) {
+			[self parseExportMacro:declaration intoRenames:renames methods:methods protocol:protocol];
+			continue;
+		}
+
+		if([declaration hasPrefix:@"-"] || [declaration hasPrefix:@"+"]) {
+			LGNMethod *method = [self parseMethod:declaration];
+			if(method)
+				[methods addObject:method];
+			else
+				protocol.hasUnsupportedMembers = YES;
+		} else if([declaration hasPrefix:@"@property"]) {
+			LGNProperty *property = [self parseProperty:declaration];
+			if(property)
+				[properties addObject:property];
+			else
+				protocol.hasUnsupportedMembers = YES;
+		}
+	}
+
+	for(LGNMethod *method in methods) {
+		NSString *rename = renames[method.selector];
+		if(rename)
+			method.javaScriptName = rename;
+	}
+
+	protocol.methods = methods;
+	protocol.properties = properties;
+}
+
+/**
+ * L8_EXPORT_AS(PropertyName, Selector) and L8_EXPORT_AS_NO_ARGS(PropertyName, Selector),
+ * where Selector is a full method declaration.
+ */
+- (void)parseExportMacro:(NSString *)declaration
+			 intoRenames:(NSMutableDictionary *)renames
+				 methods:(NSMutableArray *)methods
+				protocol:(LGNProtocol *)protocol
+{
+	NSRange open = [declaration rangeOfString:@"("];
+	if(open.location == NSNotFound)
+		return;
+
+	NSUInteger end = lgn_skip_parens(declaration, open.location);
+	if(end == NSNotFound)
+		return;
+
+	NSString *arguments = [declaration substringWithRange:NSMakeRange(open.location + 1, end - open.location - 2)];
+	NSRange comma = [arguments rangeOfString:@","];
+	if(comma.location == NSNotFound)
+		return;
+
+	NSString *jsName = lgn_trim([arguments substringToIndex:comma.location]);
+	NSString *methodDeclaration = lgn_trim([arguments substringFromIndex:comma.location + 1]);
+
+	LGNMethod *method = [self parseMethod:methodDeclaration];
+	if(!method) {
+		protocol.hasUnsupportedMembers = YES;
+		return;
+	}
+
+	renames[method.selector] = jsName;
+	[methods addObject:method];
+}
+
+- (LGNMethod *)parseMethod:(NSString *)declaration
+{
+	LGNMethod *method = [[LGNMethod alloc] init];
+	NSMutableString *selector = [NSMutableString string];
+	NSMutableArray *argumentTypes = [NSMutableArray array];
+	NSCharacterSet *whitespace = [NSCharacterSet whitespaceAndNewlineCharacterSet];
+	NSCharacterSet *identifier = [NSCharacterSet characterSetWithCharactersInString:
+								  @"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_"];
+
+	method.classMethod = [declaration hasPrefix:@"+"];
+
+	NSScanner *scanner = [NSScanner scannerWithString:[declaration substringFromIndex:1]];
+	scanner.charactersToBeSkipped = whitespace;
+
+	method.returnType = [self scanTypeWithScanner:scanner];
+
+	while(!scanner.isAtEnd) {
+		NSString *part = nil;
+
+		[scanner scanCharactersFromSet:identifier intoString:&part];
+
+		if(![scanner scanString:@":" intoString:NULL]) {
+			// Only a selector without arguments has a part not followed by a colon
+			if(selector.length == 0 && part)
+				[selector appendString:part];
+			break;
+		}
+
+		[selector appendFormat:@"%@:",part ?: @""];
+
+		LGNType *type = [self scanTypeWithScanner:scanner];
+		if(!type)
+			return nil;
+		[argumentTypes addObject:type];
+
+		// Argument name
+		[scanner scanCharactersFromSet:identifier intoString:NULL];
+	}
+
+	// Variadic methods
+	if([declaration rangeOfString:@"..."].location != NSNotFound)
+		return nil;
+
+	if(selector.length == 0 || !method.returnType)
+		return nil;
+
+	method.selector = selector;
+	method.javaScriptName = lgn_javascript_name(selector);
+	method.argumentTypes = argumentTypes;
+
+	if(method.returnType.kind == LGNTypeKindUnsupported)
+		return nil;
+	for(LGNType *type in argumentTypes) {
+		if(type.kind == LGNTypeKindUnsupported || type.kind == LGNTypeKindVoid)
+			return nil;
+	}
+
+	return method;
+}
+
+/**
+ * Scan a parenthesized type. A missing type is id.
+ */
+- (LGNType *)scanTypeWithScanner:(NSScanner *)scanner
+{
+	NSString *string = scanner.string;
+
+	[scanner scanCharactersFromSet:[NSCharacterSet whitespaceAndNewlineCharacterSet] intoString:NULL];
+	if(![scanner scanString:@"(" intoString:NULL])
+		return [LGNType typeWithDeclaration:@"id"];
+
+	NSUInteger end = lgn_skip_parens(string, scanner.scanLocation - 1);
+	if(end == NSNotFound)
+		return nil;
+
+	NSString *type = [string substringWithRange:NSMakeRange(scanner.scanLocation, end - scanner.scanLocation - 1)];
+	scanner.scanLocation = end;
+
+	return [LGNType typeWithDeclaration:type];
+}
+
+- (LGNProperty *)parseProperty:(NSString *)declaration
+{
+	LGNProperty *property = [[LGNProperty alloc] init];
+	NSString *rest = lgn_trim([declaration substringFromIndex:@"@property".length]);
+
+	if([rest hasPrefix:@"("]) {
+		NSUInteger end = lgn_skip_parens(rest, 0);
+		if(end == NSNotFound)
+			return nil;
+
+		NSString *attributes = [rest substringWithRange:NSMakeRange(1, end - 2)];
+		for(NSString *attribute in [attributes componentsSeparatedByString:@","]) {
+			NSString *trimmed = lgn_trim(attribute);
+
+			if([trimmed isEqualToString:@"readonly"])
+				property.readonly = YES;
+			else if([trimmed hasPrefix:@"getter"])
+				property.getter = lgn_trim([trimmed substringFromIndex:[trimmed rangeOfString:@"="].location + 1]);
+			else if([trimmed hasPrefix:@"setter"])
+				property.setter = lgn_trim([trimmed substringFromIndex:[trimmed rangeOfString:@"="].location + 1]);
+		}
+
+		rest = lgn_trim([rest substringFromIndex:end]);
+	}
+
+	// Blocks and function pointers
+	if([rest rangeOfString:@"("].location != NSNotFound)
+		return nil;
+
+	NSCharacterSet *separators = [NSCharacterSet characterSetWithCharactersInString:@" \t\n*"];
+	NSRange last = [rest rangeOfCharacterFromSet:separators options:NSBackwardsSearch];
+	if(last.location == NSNotFound)
+		return nil;
+
+	property.name = [rest substringFromIndex:last.location + 1];
+	property.type = [LGNType typeWithDeclaration:[rest substringToIndex:last.location + 1]];
+
+	if(property.type.kind == LGNTypeKindUnsupported || property.type.kind == LGNTypeKindVoid)
+		return nil;
+
+	if(!property.getter)
+		property.getter = property.name;
+	if(!property.setter) {
+		property.setter = [NSString stringWithFormat:@"set%@%@:",
+						   [[property.name substringToIndex:1] uppercaseString],
+						   [property.name substringFromIndex:1]];
+	}
+
+	return property;
+}
+
+#pragma mark - Export resolution
+
+- (BOOL)isExportedProtocol:(NSString *)name
+{
+	LGNProtocol *protocol = _protocols[name];
+
+	for(NSString *parent in protocol.parentNames) {
+		if([parent isEqualToString:@"L8Export"] || [self isExportedProtocol:parent])
+			return YES;
+	}
+
+	return NO;
+}
+
+- (NSArray *)exportedProtocolsOfClass:(LGNClass *)cls unresolvedProtocol:(NSString **)unresolved
+{
+	NSSet *builtin = [NSSet setWithObjects:@"NSObject",@"L8Export",@"L8LazyExport",@"L8DirectIvarAccess",nil];
+	NSMutableArray *result = [NSMutableArray array];
+	NSMutableArray *queue = [cls.protocolNames mutableCopy];
+	NSMutableSet *seen = [NSMutableSet set];
+
+	while(queue.count) {
+		NSString *name = queue[0];
+		[queue removeObjectAtIndex:0];
+
+		if([seen containsObject:name] || [builtin containsObject:name])
+			continue;
+		[seen addObject:name];
+
+		LGNProtocol *protocol = _protocols[name];
+		if(!protocol) {
+			if(unresolved)
+				*unresolved = name;
+			return nil;
+		}
+
+		// An unresolved parent might make the protocol exported
+		[queue addObjectsFromArray:protocol.parentNames];
+
+		if([self isExportedProtocol:name])
+			[result addObject:protocol];
+	}
+
+	return result;
+}
+
+- (BOOL)isLazyClass:(LGNClass *)cls
+{
+	if([cls.protocolNames containsObject:@"L8LazyExport"])
+		return YES;
+
+	for(LGNProtocol *protocol in [self exportedProtocolsOfClass:cls unresolvedProtocol:NULL]) {
+		if([protocol.parentNames containsObject:@"L8LazyExport"])
+			return YES;
+	}
+
+	return NO;
+}
+
+@end
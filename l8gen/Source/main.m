@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2014 Jos Kuijpers. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#import "LGNHeaderParser.h"
+#import "LGNBindingWriter.h"
+
+static void lgn_usage(void)
+{
+	fprintf(stderr, "usage: l8gen [-o output] header ...\n");
+}
+
+int main(int argc, const char *argv[])
+{
+	@autoreleasepool {
+		LGNHeaderParser *parser;
+		LGNBindingWriter *writer;
+		NSMutableArray *headers;
+		NSString *outputPath = nil;
+		NSString *output;
+		NSError *error = nil;
+
+		headers = [[NSMutableArray alloc] init];
+
+		for(int i = 1; i < argc; ++i) {
+			if(strcmp(argv[i], "-o") == 0) {
+				if(++i == argc) {
+					lgn_usage();
+					return 1;
+				}
+				outputPath = [NSString stringWithUTF8String:argv[i]];
+			} else if(argv[i][0] == '-') {
+				lgn_usage();
+				return 1;
+			} else
+				[headers addObject:[NSString stringWithUTF8String:argv[i]]];
+		}
+
+		if(headers.count == 0) {
+			lgn_usage();
+			return 1;
+		}
+
+		parser = [[LGNHeaderParser alloc] init];
+		for(NSString *header in headers) {
+			if(![parser parseFileAtPath:header error:&error]) {
+				fprintf(stderr, "l8gen: %s: %s\n", header.UTF8String,
+						error.localizedDescription.UTF8String);
+				return 1;
+			}
+		}
+
+		writer = [[LGNBindingWriter alloc] initWithParser:parser headers:headers];
+		output = [writer generate];
+
+		if(outputPath) {
+			if(![output writeToFile:outputPath atomically:YES encoding:NSUTF8StringEncoding error:&error]) {
+				fprintf(stderr, "l8gen: %s: %s\n", outputPath.UTF8String,
+						error.localizedDescription.UTF8String);
+				return 1;
+			}
+		} else
+			fputs(output.UTF8String, stdout);
+	}
+
+	return 0;
+}